@@ -0,0 +1,432 @@
+#include <benchmark/benchmark.h>
+#include <core/Transform.h>
+#include <math/Math.h>
+#include <math/Matrix3.h>
+#include <math/Matrix4.h>
+#include <math/Quaternion.h>
+#include <math/SimdKernels.h>
+#include <math/Vector3.h>
+#include <glm/gtc/quaternion.hpp>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+/*  The math layer side by side: the engine's own types (Math::Matrix4 on SSE, Math::Matrix3 and
+    Math::Vector3 in scalar code), glm, and the batched Math::SimdKernels where they have a kernel
+    for the operation. Benchmarks are named BM_<operation>_<implementation>:
+        Sse, Scalar     Math::Matrix4, Math::Matrix3 / Math::Vector3
+        Glm             glm::mat4, glm::mat3, glm::vec3, glm::quat
+        SSE2, AVX2...   SimdKernels of that level, for every level the CPU runs
+    Every benchmark works through the same NUM_INPUTS values (fixed seed) per iteration, so the
+    items_per_second of one operation compare across implementations.
+    The results are written as JSON to math_benchmark.json unless --benchmark_out says otherwise.
+*/
+
+namespace {
+    using Math::Matrix3;
+    using Math::Matrix4;
+    using Math::Quaternion;
+    using Math::Vector3;
+    using Math::Vector4;
+    using Math::SimdKernelTable;
+    using Math::SimdLevel;
+
+    constexpr unsigned SEED = 2024;
+    constexpr size_t NUM_INPUTS = 1024;     // 64 KB of 4x4 matrices, each implementation reads them from the same cache level
+
+    const char* DEFAULT_OUTPUT = "math_benchmark.json";
+
+    /*  Rigid transforms with a non-uniform scale, so that the inverses take the general path */
+    struct Inputs {
+        std::vector<Quaternion> orientations;
+        std::vector<Vector3> positions;
+        std::vector<Matrix4> mat4;
+        std::vector<Matrix3> mat3;
+        std::vector<Vector3> vectors;
+
+        std::vector<glm::quat> glmOrientations;
+        std::vector<Vec3> glmPositions;
+        std::vector<Mat4> glmMat4;
+        std::vector<Mat3> glmMat3;
+        std::vector<Vec3> glmVectors;
+    };
+
+    const Inputs& GetInputs() {
+        static const Inputs inputs = [] {
+            Inputs result;
+            std::mt19937 gen(SEED);
+            std::uniform_real_distribution<float> coordinate(-10.f, 10.f);
+            std::uniform_real_distribution<float> scale(0.5f, 2.f);
+            std::uniform_real_distribution<float> angle(0.f, 360.f);
+            std::uniform_real_distribution<float> axis(-1.f, 1.f);
+
+            for (size_t i{}; i < NUM_INPUTS; ++i) {
+                const Quaternion orientation(angle(gen), Vector3{ axis(gen), axis(gen), axis(gen) + 2.f }.Normalize());
+                const Vector3 position{ coordinate(gen), coordinate(gen), coordinate(gen) };
+                const Matrix4 mat4 = Core::Transform(position, orientation).m_localToWorld
+                    * Matrix4::Scale(Vector3{ scale(gen), scale(gen), scale(gen) });
+                const Vector3 vector{ coordinate(gen), coordinate(gen), coordinate(gen) };
+
+                result.orientations.push_back(orientation);
+                result.positions.push_back(position);
+                result.mat4.push_back(mat4);
+                result.mat3.push_back(mat4.Extract3x3Matrix());
+                result.vectors.push_back(vector);
+
+                result.glmOrientations.emplace_back(orientation.w, orientation.x, orientation.y, orientation.z);
+                result.glmPositions.push_back(position);
+                result.glmMat4.push_back(static_cast<Mat4>(mat4));
+                result.glmMat3.push_back(Mat3(result.glmMat4.back()));
+                result.glmVectors.push_back(vector);
+            }
+            return result;
+        }();
+        return inputs;
+    }
+
+    /*  out[i] = op(in[i]) over all the inputs, once per iteration */
+    template <typename T, typename Op>
+    void RunUnary(benchmark::State& state, const std::vector<T>& in, Op op) {
+        std::vector<decltype(op(in[0]))> out(in.size());
+        for (auto _ : state) {
+            for (size_t i{}; i < in.size(); ++i) {
+                out[i] = op(in[i]);
+            }
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * in.size()));
+    }
+
+    /*  out[i] = op(in[i], in[n - 1 - i]) over all the inputs, once per iteration */
+    template <typename T, typename Op>
+    void RunBinary(benchmark::State& state, const std::vector<T>& in, Op op) {
+        std::vector<decltype(op(in[0], in[0]))> out(in.size());
+        for (auto _ : state) {
+            for (size_t i{}; i < in.size(); ++i) {
+                out[i] = op(in[i], in[in.size() - 1 - i]);
+            }
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * in.size()));
+    }
+
+    /*  Structure-of-arrays copies of the inputs, as the SIMD kernels take them */
+    struct SoAInputs {
+        std::vector<float> orientation[4];  // w, x, y, z
+        std::vector<float> position[3];
+        std::vector<float> mat4[16];
+
+        SoAInputs() {
+            const Inputs& inputs = GetInputs();
+            for (size_t i{}; i < NUM_INPUTS; ++i) {
+                const Quaternion& q = inputs.orientations[i];
+                orientation[0].push_back(q.w);
+                orientation[1].push_back(q.x);
+                orientation[2].push_back(q.y);
+                orientation[3].push_back(q.z);
+                for (unsigned c{}; c < 3; ++c) {
+                    position[c].push_back(inputs.positions[i][c]);
+                }
+                for (int e{}; e < 16; ++e) {
+                    mat4[e].push_back(inputs.mat4[i][e]);
+                }
+            }
+        }
+    };
+
+    const SoAInputs& GetSoAInputs() {
+        static const SoAInputs inputs;
+        return inputs;
+    }
+
+    /*  Points spread in a cube, range(0) of them, for the batch transforms */
+    std::vector<Vector3> MakePoints(size_t count) {
+        std::mt19937 gen(SEED);
+        std::uniform_real_distribution<float> coordinate(-10.f, 10.f);
+        std::vector<Vector3> points(count);
+        for (Vector3& point : points) {
+            point = { coordinate(gen), coordinate(gen), coordinate(gen) };
+        }
+        return points;
+    }
+}
+
+
+/*  4x4 multiply */
+static void BM_Mat4Multiply_Sse(benchmark::State& state) {
+    RunBinary(state, GetInputs().mat4, [](const Matrix4& a, const Matrix4& b) { return a * b; });
+}
+BENCHMARK(BM_Mat4Multiply_Sse);
+
+static void BM_Mat4Multiply_Glm(benchmark::State& state) {
+    RunBinary(state, GetInputs().glmMat4, [](const Mat4& a, const Mat4& b) { return a * b; });
+}
+BENCHMARK(BM_Mat4Multiply_Glm);
+
+
+/*  4x4 inverse */
+static void BM_Mat4Inverse_Sse(benchmark::State& state) {
+    RunUnary(state, GetInputs().mat4, [](const Matrix4& m) { return m.Inverse(); });
+}
+BENCHMARK(BM_Mat4Inverse_Sse);
+
+static void BM_Mat4Inverse_Glm(benchmark::State& state) {
+    RunUnary(state, GetInputs().glmMat4, [](const Mat4& m) { return glm::inverse(m); });
+}
+BENCHMARK(BM_Mat4Inverse_Glm);
+
+
+/*  4x4 transpose */
+static void BM_Mat4Transpose_Sse(benchmark::State& state) {
+    RunUnary(state, GetInputs().mat4, [](const Matrix4& m) { return m.Transpose(); });
+}
+BENCHMARK(BM_Mat4Transpose_Sse);
+
+static void BM_Mat4Transpose_Glm(benchmark::State& state) {
+    RunUnary(state, GetInputs().glmMat4, [](const Mat4& m) { return glm::transpose(m); });
+}
+BENCHMARK(BM_Mat4Transpose_Glm);
+
+
+/*  3x3 multiply, as the inertia tensors do */
+static void BM_Mat3Multiply_Scalar(benchmark::State& state) {
+    RunBinary(state, GetInputs().mat3, [](const Matrix3& a, const Matrix3& b) { return a * b; });
+}
+BENCHMARK(BM_Mat3Multiply_Scalar);
+
+static void BM_Mat3Multiply_Glm(benchmark::State& state) {
+    RunBinary(state, GetInputs().glmMat3, [](const Mat3& a, const Mat3& b) { return a * b; });
+}
+BENCHMARK(BM_Mat3Multiply_Glm);
+
+
+/*  3x3 inverse */
+static void BM_Mat3Inverse_Scalar(benchmark::State& state) {
+    RunUnary(state, GetInputs().mat3, [](const Matrix3& m) { return m.Inverse(); });
+}
+BENCHMARK(BM_Mat3Inverse_Scalar);
+
+static void BM_Mat3Inverse_Glm(benchmark::State& state) {
+    RunUnary(state, GetInputs().glmMat3, [](const Mat3& m) { return glm::inverse(m); });
+}
+BENCHMARK(BM_Mat3Inverse_Glm);
+
+
+/*  3x3 transpose */
+static void BM_Mat3Transpose_Scalar(benchmark::State& state) {
+    RunUnary(state, GetInputs().mat3, [](const Matrix3& m) { return m.Transpose(); });
+}
+BENCHMARK(BM_Mat3Transpose_Scalar);
+
+static void BM_Mat3Transpose_Glm(benchmark::State& state) {
+    RunUnary(state, GetInputs().glmMat3, [](const Mat3& m) { return glm::transpose(m); });
+}
+BENCHMARK(BM_Mat3Transpose_Glm);
+
+
+/*  Normal matrix, transpose(inverse(upper 3x3)), the 3x3 inverse the renderer needs per object */
+static void BM_NormalMatrix_Scalar(benchmark::State& state) {
+    RunUnary(state, GetInputs().mat4, [](const Matrix4& m) { return m.Extract3x3Matrix().Inverse().Transpose(); });
+}
+BENCHMARK(BM_NormalMatrix_Scalar);
+
+static void BM_NormalMatrix_Glm(benchmark::State& state) {
+    RunUnary(state, GetInputs().glmMat4, [](const Mat4& m) { return glm::transpose(glm::inverse(Mat3(m))); });
+}
+BENCHMARK(BM_NormalMatrix_Glm);
+
+static void NormalMatrixSimd(benchmark::State& state, const SimdKernelTable* kernels) {
+    const SoAInputs& inputs = GetSoAInputs();
+    Math::ConstMat4SoA models;
+    for (int e{}; e < 16; ++e) {
+        models.e[e] = inputs.mat4[e].data();
+    }
+    std::vector<float> planes(9 * NUM_INPUTS);
+    Math::Mat3SoA out;
+    for (int e{}; e < 9; ++e) {
+        out.e[e] = planes.data() + e * NUM_INPUTS;
+    }
+
+    for (auto _ : state) {
+        kernels->computeNormalMatrices(models, out, NUM_INPUTS);
+        benchmark::DoNotOptimize(planes.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * NUM_INPUTS));
+}
+
+
+/*  Quaternion to model matrix, rotation plus translation column */
+static void BM_QuatToMatrix_Sse(benchmark::State& state) {
+    const Inputs& inputs = GetInputs();
+    std::vector<Core::Transform> transforms;
+    for (size_t i{}; i < NUM_INPUTS; ++i) {
+        transforms.emplace_back(inputs.positions[i], inputs.orientations[i]);
+    }
+
+    for (auto _ : state) {
+        for (Core::Transform& transform : transforms) {
+            transform.Update();
+        }
+        benchmark::DoNotOptimize(transforms.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * NUM_INPUTS));
+}
+BENCHMARK(BM_QuatToMatrix_Sse);
+
+static void BM_QuatToMatrix_Glm(benchmark::State& state) {
+    const Inputs& inputs = GetInputs();
+    std::vector<Mat4> out(NUM_INPUTS);
+
+    for (auto _ : state) {
+        for (size_t i{}; i < NUM_INPUTS; ++i) {
+            out[i] = glm::mat4_cast(inputs.glmOrientations[i]);
+            out[i][3] = Vec4(inputs.glmPositions[i], 1.f);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * NUM_INPUTS));
+}
+BENCHMARK(BM_QuatToMatrix_Glm);
+
+static void QuatToMatrixSimd(benchmark::State& state, const SimdKernelTable* kernels) {
+    const SoAInputs& inputs = GetSoAInputs();
+    const Math::ConstQuatSoA orientation{
+        inputs.orientation[0].data(), inputs.orientation[1].data(), inputs.orientation[2].data(), inputs.orientation[3].data() };
+    const Math::ConstVec3SoA position{ inputs.position[0].data(), inputs.position[1].data(), inputs.position[2].data() };
+    std::vector<float> planes(16 * NUM_INPUTS);
+    Math::Mat4SoA out;
+    for (int e{}; e < 16; ++e) {
+        out.e[e] = planes.data() + e * NUM_INPUTS;
+    }
+
+    for (auto _ : state) {
+        kernels->buildModelMatrices(orientation, position, out, NUM_INPUTS);
+        benchmark::DoNotOptimize(planes.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * NUM_INPUTS));
+}
+
+
+/*  Vector normalize. Math::Vector3 has no SIMD form, nor do the kernels */
+static void BM_Vec3Normalize_Scalar(benchmark::State& state) {
+    RunUnary(state, GetInputs().vectors, [](const Vector3& v) { return v.Normalize(); });
+}
+BENCHMARK(BM_Vec3Normalize_Scalar);
+
+static void BM_Vec3Normalize_Glm(benchmark::State& state) {
+    RunUnary(state, GetInputs().glmVectors, [](const Vec3& v) { return glm::normalize(v); });
+}
+BENCHMARK(BM_Vec3Normalize_Glm);
+
+
+/*  range(0) points through one model matrix */
+static void BM_TransformPoints_Sse(benchmark::State& state) {
+    const Matrix4& matrix = GetInputs().mat4.front();
+    const std::vector<Vector3> points = MakePoints(static_cast<size_t>(state.range(0)));
+    std::vector<Vector3> out(points.size());
+
+    for (auto _ : state) {
+        for (size_t i{}; i < points.size(); ++i) {
+            out[i] = matrix * Vector4{ points[i] };
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * points.size()));
+}
+BENCHMARK(BM_TransformPoints_Sse)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_TransformPoints_Glm(benchmark::State& state) {
+    const Mat4& matrix = GetInputs().glmMat4.front();
+    std::vector<Vec3> points;
+    for (const Vector3& point : MakePoints(static_cast<size_t>(state.range(0)))) {
+        points.push_back(point);
+    }
+    std::vector<Vec3> out(points.size());
+
+    for (auto _ : state) {
+        for (size_t i{}; i < points.size(); ++i) {
+            out[i] = Vec3(matrix * Vec4(points[i], 1.f));
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * points.size()));
+}
+BENCHMARK(BM_TransformPoints_Glm)->Arg(1 << 10)->Arg(1 << 16);
+
+static void TransformPointsSimd(benchmark::State& state, const SimdKernelTable* kernels) {
+    const Matrix4& matrix = GetInputs().mat4.front();
+    float mat[16];
+    for (int e{}; e < 16; ++e) {
+        mat[e] = matrix[e];
+    }
+    const std::vector<Vector3> points = MakePoints(static_cast<size_t>(state.range(0)));
+    std::vector<float> x, y, z;
+    for (const Vector3& point : points) {
+        x.push_back(point.x);
+        y.push_back(point.y);
+        z.push_back(point.z);
+    }
+    std::vector<float> ox(points.size()), oy(points.size()), oz(points.size());
+
+    for (auto _ : state) {
+        kernels->transformPoints(mat, { x.data(), y.data(), z.data() }, { ox.data(), oy.data(), oz.data() }, points.size());
+        benchmark::DoNotOptimize(ox.data());
+        benchmark::DoNotOptimize(oy.data());
+        benchmark::DoNotOptimize(oz.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * points.size()));
+}
+
+
+/*  Registers the kernel benchmarks of every level this CPU runs */
+static void RegisterSimdBenchmarks() {
+    for (int level{}; level < static_cast<int>(SimdLevel::COUNT); ++level) {
+        const SimdKernelTable* kernels = Math::GetSimdKernels(static_cast<SimdLevel>(level));
+        if (kernels == nullptr) {
+            continue;
+        }
+        const std::string suffix = std::string("_") + Math::ToString(kernels->level);
+        benchmark::RegisterBenchmark(("BM_NormalMatrix" + suffix).c_str(), NormalMatrixSimd, kernels);
+        benchmark::RegisterBenchmark(("BM_QuatToMatrix" + suffix).c_str(), QuatToMatrixSimd, kernels);
+        benchmark::RegisterBenchmark(("BM_TransformPoints" + suffix).c_str(), TransformPointsSimd, kernels)
+            ->Arg(1 << 10)->Arg(1 << 16);
+    }
+}
+
+
+/*  As BENCHMARK_MAIN(), but the results also go to DEFAULT_OUTPUT as JSON when no --benchmark_out is given */
+int main(int argc, char** argv) {
+    std::vector<char*> args(argv, argv + argc);
+    bool hasOutput = false;
+    for (int i = 1; i < argc; ++i) {
+        hasOutput = hasOutput || std::strncmp(argv[i], "--benchmark_out=", 16) == 0;
+    }
+    std::string outputArg = std::string("--benchmark_out=") + DEFAULT_OUTPUT;
+    std::string formatArg = "--benchmark_out_format=json";
+    if (hasOutput == false) {
+        args.push_back(outputArg.data());
+        args.push_back(formatArg.data());
+    }
+
+    RegisterSimdBenchmarks();
+    benchmark::AddCustomContext("simd_level", Math::ToString(Math::DetectSimdLevel()));
+
+    int numArgs = static_cast<int>(args.size());
+    benchmark::Initialize(&numArgs, args.data());
+    if (benchmark::ReportUnrecognizedArguments(numArgs, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include <benchmark/benchmark.h>
+#include <core/Scene.h>
+#include <rendering/MeshLibrary.h>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+
+/*  Stress scenes for the physics core, stepped without any renderer.
+    Every scene is built from a fixed seed and stepped a fixed number of times at the
+    application's fixed time step, so two runs simulate the same frames and their times compare.
+    Time is per step; the counters are per step as well:
+        bodies          objects in the scene
+        pairs           collider pairs tested
+        overlaps        of which the bounding volumes overlap (what a broad phase would keep)
+        contacts        contacts solved
+        solverIters     passes of the sequential impulse solver
+        allocs          heap allocations
+    e.g. RigidBodyLab_Benchmark --benchmark_format=json --benchmark_out=physics.json
+*/
+
+namespace {
+    std::atomic<size_t> g_numAllocations{ 0 };
+}
+
+void* operator new(std::size_t size) {
+    g_numAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size != 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+    using Core::Scene;
+    using Math::Vector3;
+    using Math::Quaternion;
+    using Physics::ColliderType;
+    using Rendering::MeshID;
+    using Rendering::ImageID;
+
+    constexpr float FIXED_DT = 1 / 120.f;   // as Application
+    constexpr unsigned SEED = 2024;
+
+    constexpr float GROUND_SIZE = 70.f;     // as the demo platform
+    constexpr float GROUND_HEIGHT = 1.5f;
+    constexpr float GROUND_TOP = GROUND_HEIGHT * 0.5f;
+    constexpr float GAP = 0.01f;            // between stacked bodies, so that they start apart
+
+    /*  Physics-only: no mesh is loaded, the objects get none */
+    const Rendering::MeshLibrary& GetMeshLibrary() {
+        static const Rendering::MeshLibrary meshLibrary;
+        return meshLibrary;
+    }
+
+    std::unique_ptr<Scene> MakeEmptyScene() {
+        auto scene = std::make_unique<Scene>(GetMeshLibrary());
+        scene->Clear();
+        scene->CreateObject("ground", MeshID::CUBE, ImageID::STONE_TEX_1, ColliderType::OBB,
+            Vec3{ GROUND_SIZE, GROUND_HEIGHT, GROUND_SIZE }, { 0.f, 0.f, 0.f }, 0.f);
+        return scene;
+    }
+
+    void AddBox(Scene& scene, const Vector3& position, const Quaternion& orientation = Quaternion{}) {
+        scene.CreateObject("box", MeshID::CUBE, ImageID::WOOD_TEX_1, ColliderType::OBB,
+            Vec3{ 1.f, 1.f, 1.f }, position, 1.f, orientation);
+    }
+
+    /*  Steps the scene once per iteration, after beforeStep(), and adds the per-step counters */
+    template <typename BeforeStep>
+    void StepScene(benchmark::State& state, Scene& scene, BeforeStep beforeStep) {
+        size_t pairs{}, overlaps{}, contacts{}, solverIterations{}, allocations{};
+        for (auto _ : state) {
+            const size_t allocationsBefore = g_numAllocations.load(std::memory_order_relaxed);
+            beforeStep();
+            scene.Update(FIXED_DT);
+            allocations += g_numAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+            const auto& stats = scene.GetCollisionStats();
+            pairs += stats.pairsTested;
+            overlaps += stats.pairsOverlapping;
+            contacts += stats.contacts;
+            solverIterations += stats.solverIterations;
+        }
+
+        using benchmark::Counter;
+        state.counters["bodies"] = static_cast<double>(scene.GetNumObjects());
+        state.counters["pairs"] = Counter(static_cast<double>(pairs), Counter::kAvgIterations);
+        state.counters["overlaps"] = Counter(static_cast<double>(overlaps), Counter::kAvgIterations);
+        state.counters["contacts"] = Counter(static_cast<double>(contacts), Counter::kAvgIterations);
+        state.counters["solverIters"] = Counter(static_cast<double>(solverIterations), Counter::kAvgIterations);
+        state.counters["allocs"] = Counter(static_cast<double>(allocations), Counter::kAvgIterations);
+    }
+
+    void StepScene(benchmark::State& state, Scene& scene) {
+        StepScene(state, scene, [] {});
+    }
+}
+
+
+/*  2D pyramid of unit boxes, range(0) rows, settling on the ground */
+static void BM_BoxPyramid(benchmark::State& state) {
+    const int rows = static_cast<int>(state.range(0));
+    auto scene = MakeEmptyScene();
+    for (int row = 0; row < rows; ++row) {
+        const int count = rows - row;
+        for (int i = 0; i < count; ++i) {
+            const float x = (i - (count - 1) * 0.5f) * (1.f + GAP);
+            const float y = GROUND_TOP + 0.5f + GAP + row * (1.f + GAP);
+            AddBox(*scene, { x, y, 0.f });
+        }
+    }
+    StepScene(state, *scene);
+}
+BENCHMARK(BM_BoxPyramid)->Arg(10)->Arg(20)->Iterations(240)->Unit(benchmark::kMillisecond);
+
+
+/*  range(0) unit boxes at random positions and orientations, dropped onto the ground */
+static void BM_RandomBoxDrop(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    auto scene = MakeEmptyScene();
+
+    std::mt19937 gen(SEED);
+    std::uniform_real_distribution<float> horizontal(-GROUND_SIZE * 0.4f, GROUND_SIZE * 0.4f);
+    std::uniform_real_distribution<float> height(GROUND_TOP + 1.f, GROUND_TOP + 1.f + count / 100.f);
+    std::uniform_real_distribution<float> angle(0.f, 360.f);
+    std::uniform_real_distribution<float> axis(-1.f, 1.f);
+    for (int i = 0; i < count; ++i) {
+        const Vector3 rotationAxis = Vector3{ axis(gen), axis(gen), axis(gen) + 2.f }.Normalize();
+        AddBox(*scene, { horizontal(gen), height(gen), horizontal(gen) }, Quaternion{ angle(gen), rotationAxis });
+    }
+    StepScene(state, *scene);
+}
+BENCHMARK(BM_RandomBoxDrop)->Arg(1000)->Iterations(120)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RandomBoxDrop)->Arg(10000)->Iterations(10)->Unit(benchmark::kMillisecond);
+
+
+/*  Column of unit spheres, range(0) x range(0) per layer, jittered within the gaps so that the pile topples */
+static void BM_SpherePile(benchmark::State& state) {
+    const int side = static_cast<int>(state.range(0));
+    constexpr int LAYERS = 10;
+    auto scene = MakeEmptyScene();
+
+    std::mt19937 gen(SEED);
+    std::uniform_real_distribution<float> jitter(-GAP * 0.4f, GAP * 0.4f);
+    for (int layer = 0; layer < LAYERS; ++layer) {
+        for (int i = 0; i < side; ++i) {
+            for (int j = 0; j < side; ++j) {
+                const Vector3 position{
+                    (i - (side - 1) * 0.5f) * (1.f + GAP) + jitter(gen),
+                    GROUND_TOP + 0.5f + GAP + layer * (1.f + GAP),
+                    (j - (side - 1) * 0.5f) * (1.f + GAP) + jitter(gen) };
+                scene->CreateObject("sphere", MeshID::SPHERE, ImageID::POTTERY_TEX_1, ColliderType::SPHERE,
+                    1.f, position, 1.f);
+            }
+        }
+    }
+    StepScene(state, *scene);
+}
+BENCHMARK(BM_SpherePile)->Arg(5)->Arg(10)->Iterations(240)->Unit(benchmark::kMillisecond);
+
+
+/*  The demo scene under fire: range(0) projectiles per step, as Scene::ShootProjectile does for
+    the player, from shooters circling the platform and aiming at its center.
+    The pool holds every shot of the run, so none is reloaded and the barrage keeps growing. */
+constexpr int BARRAGE_STEPS = 240;
+
+static void BM_ProjectileBarrage(benchmark::State& state) {
+    const int shotsPerStep = static_cast<int>(state.range(0));
+    constexpr float SHOOTER_RADIUS = 30.f;
+    constexpr float SHOOTER_HEIGHT = 8.f;
+    constexpr float PI = 3.14159265359f;
+    Scene scene(GetMeshLibrary(), Vec3{ 0.f }, shotsPerStep * BARRAGE_STEPS);
+
+    int shot = 0;
+    StepScene(state, scene, [&] {
+        for (int i = 0; i < shotsPerStep; ++i, ++shot) {
+            const float angle = shot * 0.618034f * 2.f * PI;   // golden angle steps, spread evenly
+            const Vec3 position{ SHOOTER_RADIUS * std::cos(angle), SHOOTER_HEIGHT, SHOOTER_RADIUS * std::sin(angle) };
+            scene.ShootProjectile(position, -position, Vec3{ 0.f, 1.f, 0.f });
+        }
+    });
+}
+BENCHMARK(BM_ProjectileBarrage)->Arg(1)->Arg(10)->Iterations(BARRAGE_STEPS)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -1,8 +1,19 @@
 #pragma once
 #include <core/Scene.h>
 #include <chrono>
-#include <input/InputHandler.h>
+#include <string>
+#include <input/inputHandler.h>
 class Application {
+public:
+    /*  Command line options, see main.cpp */
+    struct Options {
+        int numFrames{};            // > 0: render that many frames as fast as possible, then quit
+        bool headless{ false };     // no window nor GUI, for benchmark machines
+        std::string gpuProfilePath; // where to write the per-pass GPU times, if not empty
+    };
+
+private:
+    Options m_options;
     Core::Scene m_scene;
     std::unique_ptr<InputHandler> m_inputHandler;
     bool m_gameStarted{ false };
@@ -26,8 +37,9 @@ class Application {
     void UpdateTime();
     float GetDeltaTime() const;
     float GetFPS()const { return m_fps; }
+    void RunFrames(int numFrames);
 public:
-    Application();
+    explicit Application(const Options& options);
 
     InputHandler& GetInputHandler() { return *m_inputHandler; }
     void ProcessInput() {
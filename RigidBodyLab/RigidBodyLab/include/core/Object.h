@@ -2,10 +2,12 @@
 #include <math/Math.h>
 #include <utilities/ToUnderlyingEnum.h>
 #include <rendering/Mesh.h>
-#include <rendering/ResourceManager.h>
+#include <rendering/ResourceIDs.h>
 #include <physics/RigidBody.h>
 #include <physics/Collider.h>
 #include <memory>
+#include <string>
+#include <variant>
 #include <vector>
 
 namespace Core {
@@ -29,12 +31,15 @@ namespace Core {
 		ObjectType m_objType;
 
 		//Dependency Injection
-		const Mesh* m_mesh;     //not owner
+		const Mesh* m_mesh;     //not owner, null in physics-only scenes
 		std::unique_ptr<Collider> m_collider; //owner
 		//'Rigidbody' for dynamic objects, 'Transform' for static objects
 		std::variant<std::unique_ptr<RigidBody>, Transform> m_physicsOrTransform; //owner
 		std::string m_name;
 		bool m_shouldRender;
+		bool m_isOccluder{ false }; // large enough to hide other objects, see Renderer::OcclusionCullSlab
+		// changes of the model matrix that don't go through the transform (mesh, collider scale, visibility)
+		uint64_t m_version{ Transform::NextVersion() };
 	public:
 		// Constructor for static objects (only Mat4 needed)
 		Object(const std::string& name,const Mesh* mesh, ImageID imageID, std::unique_ptr<Collider> collider, const Transform& transform, ObjectType _type, bool isVisible=true)
@@ -44,8 +49,8 @@ namespace Core {
 		Object(const std::string& name, const Mesh* mesh, ImageID imageID, std::unique_ptr<Collider> collider, std::unique_ptr<RigidBody> rigidBody, ObjectType _type, bool isVisible=true)
 			:m_name{ name }, m_mesh(mesh), m_imageID(imageID), m_collider(std::move(collider)), m_physicsOrTransform(std::move(rigidBody)), m_objType{ _type }, m_shouldRender{isVisible} {}
 
-		void SetMesh(const Mesh* mesh) { m_mesh = mesh; }
-		void SetImageID(ImageID id) { m_imageID = id; }
+		void SetMesh(const Mesh* mesh) { m_mesh = mesh; MarkDirty(); }
+		void SetImageID(ImageID id) { m_imageID = id; MarkDirty(); }
 		
 		// Getter methods (setters might not be necessary because we are passing by reference)
 		Vector3 GetPosition()const;
@@ -61,8 +66,26 @@ namespace Core {
 		std::string GetName() const { return m_name; }
 		ImageID GetImageID() const { return m_imageID; }
 		ObjectType GetObjType() const { return m_objType; }
-		void SetVisibility(bool isVisible) { m_shouldRender = isVisible; }
+		void SetVisibility(bool isVisible) { 
+			if (m_shouldRender != isVisible) {
+				m_shouldRender = isVisible;
+				MarkDirty();
+			}
+		}
 		bool IsVisible()const { return m_shouldRender; }
+		void SetOccluder(bool isOccluder) {
+			if (m_isOccluder != isOccluder) {
+				m_isOccluder = isOccluder;
+				MarkDirty();
+			}
+		}
+		bool IsOccluder() const { return m_isOccluder; }
+
+		// call after changing anything GetModelMatrix() depends on outside of the transform (e.g. the collider scale)
+		void MarkDirty() { m_version = Transform::NextVersion(); }
+		// changes whenever GetModelMatrix(), the mesh, the image or the visibility may have changed.
+		// Renderer caches compare it against the version they were built from.
+		uint64_t GetModelVersion() const;
 
 		bool IsDynamic() const;
 		void Integrate(float deltaTime);
@@ -14,9 +14,9 @@ namespace Core {
 
         Projectile(Object* obj) : m_isActive(false), m_hasKnockedOff{false}, m_object(obj) {}
 
-        void Activate(const Vector3& position);
+        void Activate(const Vec3& position, const Vec3& forward, const Vec3& up);
         void Deactivate();
-        Vec3 CalculateInitialVelocity();
+        static Vec3 CalculateInitialVelocity(const Vec3& forward, const Vec3& up);
     };
 
 }
@@ -2,23 +2,42 @@
 
 #include <core/Object.h>
 #include <core/Projectile.h>
+#include <rendering/MeshLibrary.h>
 #include <rendering/OrbitalLight.h>
 #include <physics/CollisionData.h>
 #include <physics/CollisionManager.h>
+#include <physics/RigidBodyBatch.h>
 #include <vector>
 #include <future>
 #include <variant>
 
+namespace Rendering {
+    class Renderer;
+}
+
 namespace Core {
     using Physics::CollisionData;
     using Physics::CollisionManager;
 
+    /*  Objects, lights and physics of the demo. Builds without GL, the renderer nor the camera:
+        meshes come from the MeshLibrary given (which may be empty for physics-only runs) and the
+        projectiles wait at, and are shot from, the positions given. The projectile pool holds
+        numProjectiles; a shot whose next projectile in line is still in flight reloads them all.
+    */
     class Scene {
+    public:
+        static constexpr int NUM_MAX_LIGHTS = 256;  // also the size of the renderer's light block
+    private:
         static constexpr int NUM_PROJECTILES = 50;
         static constexpr int NUM_INITIAL_GIRLS = 4;//the # of girl statues on the platform
         static constexpr float Y_THRESHOLD = -10.0f; //either remove or reload objects that fall below this threshold
         static constexpr float PLANE_SHRINK_SPEED = 0.025f;
 
+        const Rendering::MeshLibrary& m_meshLibrary;
+        Vec3 m_projectileSpawnPos;  // where inactive projectiles are parked
+        int m_numProjectiles;       // size of the pool built by SetUpProjectiles
+        size_t m_nextProjectile{};  // where ShootProjectile starts looking for an inactive projectile
+
         std::vector<std::unique_ptr<Core::Object>> m_objects;
         std::vector<Projectile> m_projectiles;
         /*  Light pos are defined in world frame, but we need to compute their pos in view frame for
@@ -37,6 +56,7 @@ namespace Core {
         int m_numLights;
 
         CollisionManager m_collisionManager;
+        Physics::RigidBodyBatch m_rigidBodyBatch;//bodies integrated this frame, their poses are refreshed together
         //Special objects require seperate rendering 
         const Core::Object* m_mirror;//planar mirror
         Core::Object* m_idol;//idol (spherical mirror)
@@ -56,10 +76,11 @@ namespace Core {
         void RestoreTrueIdentities();
         bool OnlyFollowersLeft()const { return m_numGirls <= 0; }
 
-        friend class Renderer;
+        friend class Rendering::Renderer;
 
     public:
-        Scene();
+        explicit Scene(const Rendering::MeshLibrary& meshLibrary, const Vec3& projectileSpawnPos = Vec3{ 0.f },
+            int numProjectiles = NUM_PROJECTILES);
 
         void Update(float dt);
         int AddLight();
@@ -111,11 +132,14 @@ namespace Core {
             bool isVisible = true
             );
 
-        void ShootProjectile(const Vector3& position);
+        void ShootProjectile(const Vec3& position, const Vec3& forward, const Vec3& up);
+        size_t GetNumObjects() const { return m_objects.size(); }
+        const CollisionManager::StepStats& GetCollisionStats() const { return m_collisionManager.GetStepStats(); }
         void ReloadProjectiles();
         void RemoveObjectsBelowThreshold();
         void RemoveProjectiles();
         void RemoveAndNullifySpecialObjects();
         void Reset();
+        void Clear();
     };
 }
@@ -2,6 +2,7 @@
 #include <math/Vector3.h>
 #include <math/Matrix4.h>
 #include <math/Quaternion.h>
+#include <cstdint>
 namespace Core {
     using Math::Matrix4;
     using Math::Vector3;
@@ -11,10 +12,15 @@ namespace Core {
         Matrix4 m_localToWorld;//RT only (no scale)
         Vector3 m_position;
         Quaternion m_orientation;
+        // bumped whenever m_localToWorld is rebuilt. Values come from one global counter,
+        // so two different transforms (or the same one at different times) never share a version.
+        uint64_t m_version{};
         Transform(const Vector3& _position = Vector3{}, const Quaternion& _ori = Quaternion{}) :m_position{ _position }, m_orientation{ _ori } {
             Update();
         }
         void Update();
         Vector3 GetAxis(int index)const;
+
+        static uint64_t NextVersion();
     };
 }
\ No newline at end of file
@@ -68,6 +68,7 @@ Mat4 Frustum(float leftPlane, float rightPlane,
 Mat4 Perspective(float fovy, float aspect, float near, float far);
 
 Mat4 LookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &up);
+void FrustumPlanes(const Mat4 &viewProj, Vec4 planes[6]);
 
 Mat4 Inverse(const Mat4 &m);
 Mat4 Transpose(const Mat4 &m);
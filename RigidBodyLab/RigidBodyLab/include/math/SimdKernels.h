@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+
+// Batched math kernels working on structure-of-arrays data.
+// Every kernel exists in an SSE2, AVX2 and AVX-512 flavour; the widest one the
+// running CPU supports is picked once (cpuid/xgetbv) the first time GetSimdKernels() is called.
+// All matrices are column-major: element (row, col) lives in plane [col * 4 + row] (or [col * 3 + row] for 3x3).
+// This header is deliberately free of Math::Matrix4/glm so the kernels can be linked into any target.
+namespace Math
+{
+    enum class SimdLevel {
+        SSE2 = 0,
+        AVX2,
+        AVX512,
+        COUNT
+    };
+
+    struct Vec3SoA {
+        float* x;
+        float* y;
+        float* z;
+    };
+
+    struct ConstVec3SoA {
+        const float* x;
+        const float* y;
+        const float* z;
+    };
+
+    struct ConstQuatSoA {
+        const float* w;
+        const float* x;
+        const float* y;
+        const float* z;
+    };
+
+    struct Mat4SoA {
+        float* e[16];
+    };
+
+    struct ConstMat4SoA {
+        const float* e[16];
+    };
+
+    struct Mat3SoA {
+        float* e[9];
+    };
+
+    struct ConstMat3SoA {
+        const float* e[9];
+    };
+
+    // Rows of a depth buffer given to rasterizeOccluders are processed a full register at a time
+    constexpr int OCCLUSION_ROW_ALIGNMENT = 16;
+
+    struct SimdKernelTable {
+        SimdLevel level;
+
+        // out[i] = mat * (in[i], 1), 'mat' being 16 column-major floats. No perspective divide.
+        void (*transformPoints)(const float* mat, ConstVec3SoA in, Vec3SoA out, std::size_t count);
+
+        // out[i] = rotation(orientation[i]) with position[i] as the translation column (see Core::Transform::Update).
+        void (*buildModelMatrices)(ConstQuatSoA orientation, ConstVec3SoA position, Mat4SoA out, std::size_t count);
+
+        // out[i] = transpose(inverse(upper 3x3 of models[i])). Singular inputs yield the identity.
+        void (*computeNormalMatrices)(ConstMat4SoA models, Mat3SoA out, std::size_t count);
+
+        // Rigid body pose update: localToWorld[i] as in buildModelMatrices, plus
+        // inverseInertiaWorld[i] = R * inverseInertiaLocal[i] * R^T with R the rotation of orientation[i].
+        void (*updateRigidTransforms)(ConstQuatSoA orientation, ConstVec3SoA position, ConstMat3SoA inverseInertiaLocal,
+                                      Mat4SoA localToWorld, Mat3SoA inverseInertiaWorld, std::size_t count);
+
+        // visible[i] = 1 unless box i (center, half extents) lies entirely on the negative side of one of the planes, 0 otherwise.
+        // 'planes' holds numPlanes (a, b, c, d) tuples, with a*x + b*y + c*z + d >= 0 inside. They need not be normalized.
+        void (*cullBoxes)(const float* planes, std::size_t numPlanes, ConstVec3SoA centers, ConstVec3SoA halfExtents,
+                          float* visible, std::size_t count);
+
+        // overlap[i] = 1 if the sphere (sphere[0..2] center, sphere[3] radius) touches box i (center, half extents), 0 otherwise.
+        void (*sphereOverlapsBoxes)(const float* sphere, ConstVec3SoA centers, ConstVec3SoA halfExtents,
+                                    float* overlap, std::size_t count);
+
+        // Conservative depth rasterization for occlusion culling. 'triangles' holds 9 floats per triangle, (x, y, depth)
+        // per vertex, x and y in pixels from the bottom-left corner of the buffer, depth in [0, 1] with 0 nearest.
+        // depth[y * width + x] becomes min(depth, triangle depth) for every pixel whose center lies inside a triangle, the
+        // triangle depth being its farthest value over the whole pixel, so that no depth in the buffer is nearer than the triangles.
+        // Both windings are drawn. width must be a multiple of OCCLUSION_ROW_ALIGNMENT.
+        void (*rasterizeOccluders)(const float* triangles, std::size_t numTriangles, float* depth, int width, int height);
+    };
+
+    const char* ToString(SimdLevel level);
+
+    /****************************************************************************/
+    /*!
+    \fn     SimdLevel DetectSimdLevel()
+    \brief
+            Queries cpuid (and xgetbv for the OS-enabled register state) for the
+            widest instruction set the kernels can use on this machine.
+    */
+    /****************************************************************************/
+    SimdLevel DetectSimdLevel();
+
+    /****************************************************************************/
+    /*!
+    \fn     const SimdKernelTable& GetSimdKernels()
+    \brief
+            Returns the kernel table for the detected level. The choice is made
+            once on the first call and cached for the rest of the run.
+    */
+    /****************************************************************************/
+    const SimdKernelTable& GetSimdKernels();
+
+    /****************************************************************************/
+    /*!
+    \fn     const SimdKernelTable* GetSimdKernels(SimdLevel level)
+    \brief
+            Returns the table for a specific level, or nullptr when the running
+            CPU cannot execute it. Mostly useful for tests and benchmarks.
+    */
+    /****************************************************************************/
+    const SimdKernelTable* GetSimdKernels(SimdLevel level);
+}
@@ -0,0 +1,420 @@
+#pragma once
+
+#include <math/SimdKernels.h>
+#include <cstdint>
+#include <cstring>
+
+// Shared kernel bodies, written once against a "Lane" type (a SIMD register of Lane::WIDTH floats).
+// Only SimdKernels_SSE2/AVX2/AVX512.cpp include this, each one after defining its own lane type.
+// Those translation units are compiled with different /arch flags, so they must not instantiate any inline
+// function with external linkage: templates and inline functions of the standard library (std::fabs, std::min...)
+// come out as weak symbols built with the wider instruction set, the linker keeps any one copy for the whole
+// program, and a TU compiled for SSE2 could end up calling the AVX-512 one on a machine without it.
+// Hence everything here lives in an unnamed namespace, and calls only helpers of its own or the intrinsics.
+namespace
+{
+    // |value|, by clearing the sign bit
+    inline float AbsFloat(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        bits &= 0x7fffffffu;
+        std::memcpy(&value, &bits, sizeof value);
+        return value;
+    }
+
+    inline float Min3(float a, float b, float c)
+    {
+        const float ab = a < b ? a : b;
+        return ab < c ? ab : c;
+    }
+
+    inline float Max3(float a, float b, float c)
+    {
+        const float ab = a > b ? a : b;
+        return ab > c ? ab : c;
+    }
+
+    inline int MinInt(int a, int b) { return a < b ? a : b; }
+    inline int MaxInt(int a, int b) { return a > b ? a : b; }
+
+    // floor, for values well within the int range (pixel coordinates)
+    inline int FloorToInt(float value)
+    {
+        const int truncated = static_cast<int>(value);
+        return static_cast<float>(truncated) > value ? truncated - 1 : truncated;
+    }
+
+    inline void SwapFloats(float& a, float& b)
+    {
+        const float tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    // The tail (count % WIDTH) runs through the same bodies one element at a time.
+    struct ScalarLane {
+        float v;
+
+        static constexpr std::size_t WIDTH = 1;
+
+        static ScalarLane Load(const float* ptr) { return { *ptr }; }
+        static ScalarLane Set1(float value) { return { value }; }
+        void Store(float* ptr) const { *ptr = v; }
+
+        friend ScalarLane operator+(ScalarLane a, ScalarLane b) { return { a.v + b.v }; }
+        friend ScalarLane operator-(ScalarLane a, ScalarLane b) { return { a.v - b.v }; }
+        friend ScalarLane operator*(ScalarLane a, ScalarLane b) { return { a.v * b.v }; }
+        friend ScalarLane operator/(ScalarLane a, ScalarLane b) { return { a.v / b.v }; }
+        friend ScalarLane Abs(ScalarLane a) { return { AbsFloat(a.v) }; }
+        // (a < b) ? x : y, per lane
+        friend ScalarLane SelectIfLess(ScalarLane a, ScalarLane b, ScalarLane x, ScalarLane y) { return a.v < b.v ? x : y; }
+    };
+
+    constexpr float SINGULAR_DETERMINANT = 1e-12f;
+
+    template <typename Lane>
+    void TransformPointsRange(const float* mat, Math::ConstVec3SoA in, Math::Vec3SoA out, std::size_t begin, std::size_t end)
+    {
+        const Lane m00 = Lane::Set1(mat[0]), m10 = Lane::Set1(mat[1]), m20 = Lane::Set1(mat[2]);
+        const Lane m01 = Lane::Set1(mat[4]), m11 = Lane::Set1(mat[5]), m21 = Lane::Set1(mat[6]);
+        const Lane m02 = Lane::Set1(mat[8]), m12 = Lane::Set1(mat[9]), m22 = Lane::Set1(mat[10]);
+        const Lane m03 = Lane::Set1(mat[12]), m13 = Lane::Set1(mat[13]), m23 = Lane::Set1(mat[14]);
+
+        for (std::size_t i = begin; i < end; i += Lane::WIDTH) {
+            const Lane x = Lane::Load(in.x + i);
+            const Lane y = Lane::Load(in.y + i);
+            const Lane z = Lane::Load(in.z + i);
+
+            (m00 * x + m01 * y + m02 * z + m03).Store(out.x + i);
+            (m10 * x + m11 * y + m12 * z + m13).Store(out.y + i);
+            (m20 * x + m21 * y + m22 * z + m23).Store(out.z + i);
+        }
+    }
+
+    // r[col * 3 + row], same layout as Core::Transform::Update
+    template <typename Lane>
+    void RotationFromQuaternion(Lane w, Lane x, Lane y, Lane z, Lane (&r)[9])
+    {
+        const Lane one = Lane::Set1(1.f);
+        const Lane two = Lane::Set1(2.f);
+
+        const Lane xx = x * x, yy = y * y, zz = z * z;
+        const Lane xy = x * y, xz = x * z, yz = y * z;
+        const Lane wx = w * x, wy = w * y, wz = w * z;
+
+        r[0] = one - two * (yy + zz);
+        r[1] = two * (xy + wz);
+        r[2] = two * (xz - wy);
+
+        r[3] = two * (xy - wz);
+        r[4] = one - two * (xx + zz);
+        r[5] = two * (yz + wx);
+
+        r[6] = two * (xz + wy);
+        r[7] = two * (yz - wx);
+        r[8] = one - two * (xx + yy);
+    }
+
+    template <typename Lane>
+    void StoreRigidTransform(const Lane (&r)[9], Lane px, Lane py, Lane pz, Math::Mat4SoA out, std::size_t i)
+    {
+        const Lane zero = Lane::Set1(0.f);
+
+        for (int col{}; col < 3; ++col) {
+            for (int row{}; row < 3; ++row) {
+                r[col * 3 + row].Store(out.e[col * 4 + row] + i);
+            }
+            zero.Store(out.e[col * 4 + 3] + i);
+        }
+        px.Store(out.e[12] + i);
+        py.Store(out.e[13] + i);
+        pz.Store(out.e[14] + i);
+        Lane::Set1(1.f).Store(out.e[15] + i);
+    }
+
+    template <typename Lane>
+    void BuildModelMatricesRange(Math::ConstQuatSoA q, Math::ConstVec3SoA p, Math::Mat4SoA out, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; i += Lane::WIDTH) {
+            Lane r[9];
+            RotationFromQuaternion(Lane::Load(q.w + i), Lane::Load(q.x + i), Lane::Load(q.y + i), Lane::Load(q.z + i), r);
+            StoreRigidTransform(r, Lane::Load(p.x + i), Lane::Load(p.y + i), Lane::Load(p.z + i), out, i);
+        }
+    }
+
+    template <typename Lane>
+    void UpdateRigidTransformsRange(Math::ConstQuatSoA q, Math::ConstVec3SoA p, Math::ConstMat3SoA invInertia,
+                                    Math::Mat4SoA localToWorld, Math::Mat3SoA invInertiaWorld, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; i += Lane::WIDTH) {
+            Lane r[9];
+            RotationFromQuaternion(Lane::Load(q.w + i), Lane::Load(q.x + i), Lane::Load(q.y + i), Lane::Load(q.z + i), r);
+            StoreRigidTransform(r, Lane::Load(p.x + i), Lane::Load(p.y + i), Lane::Load(p.z + i), localToWorld, i);
+
+            Lane inertia[9];
+            for (int e{}; e < 9; ++e) {
+                inertia[e] = Lane::Load(invInertia.e[e] + i);
+            }
+
+            // t = R * I
+            Lane t[9];
+            for (int col{}; col < 3; ++col) {
+                for (int row{}; row < 3; ++row) {
+                    t[col * 3 + row] = r[row] * inertia[col * 3]
+                                     + r[3 + row] * inertia[col * 3 + 1]
+                                     + r[6 + row] * inertia[col * 3 + 2];
+                }
+            }
+
+            // world = t * R^T
+            for (int col{}; col < 3; ++col) {
+                for (int row{}; row < 3; ++row) {
+                    (t[row] * r[col] + t[3 + row] * r[3 + col] + t[6 + row] * r[6 + col]).Store(invInertiaWorld.e[col * 3 + row] + i);
+                }
+            }
+        }
+    }
+
+    template <typename Lane>
+    void ComputeNormalMatricesRange(Math::ConstMat4SoA m, Math::Mat3SoA out, std::size_t begin, std::size_t end)
+    {
+        const Lane zero = Lane::Set1(0.f);
+        const Lane one = Lane::Set1(1.f);
+        const Lane eps = Lane::Set1(SINGULAR_DETERMINANT);
+
+        for (std::size_t i = begin; i < end; i += Lane::WIDTH) {
+            // m<row><col>
+            const Lane m00 = Lane::Load(m.e[0] + i), m10 = Lane::Load(m.e[1] + i), m20 = Lane::Load(m.e[2] + i);
+            const Lane m01 = Lane::Load(m.e[4] + i), m11 = Lane::Load(m.e[5] + i), m21 = Lane::Load(m.e[6] + i);
+            const Lane m02 = Lane::Load(m.e[8] + i), m12 = Lane::Load(m.e[9] + i), m22 = Lane::Load(m.e[10] + i);
+
+            // transpose(inverse(M)) == cofactor(M) / det(M)
+            const Lane c00 = m11 * m22 - m12 * m21;
+            const Lane c01 = m12 * m20 - m10 * m22;
+            const Lane c02 = m10 * m21 - m11 * m20;
+            const Lane c10 = m02 * m21 - m01 * m22;
+            const Lane c11 = m00 * m22 - m02 * m20;
+            const Lane c12 = m01 * m20 - m00 * m21;
+            const Lane c20 = m01 * m12 - m02 * m11;
+            const Lane c21 = m02 * m10 - m00 * m12;
+            const Lane c22 = m00 * m11 - m01 * m10;
+
+            const Lane det = m00 * c00 + m01 * c01 + m02 * c02;
+            const Lane absDet = Abs(det);
+            const Lane invDet = one / SelectIfLess(absDet, eps, one, det);
+
+            SelectIfLess(absDet, eps, one, c00 * invDet).Store(out.e[0] + i);
+            SelectIfLess(absDet, eps, zero, c10 * invDet).Store(out.e[1] + i);
+            SelectIfLess(absDet, eps, zero, c20 * invDet).Store(out.e[2] + i);
+
+            SelectIfLess(absDet, eps, zero, c01 * invDet).Store(out.e[3] + i);
+            SelectIfLess(absDet, eps, one, c11 * invDet).Store(out.e[4] + i);
+            SelectIfLess(absDet, eps, zero, c21 * invDet).Store(out.e[5] + i);
+
+            SelectIfLess(absDet, eps, zero, c02 * invDet).Store(out.e[6] + i);
+            SelectIfLess(absDet, eps, zero, c12 * invDet).Store(out.e[7] + i);
+            SelectIfLess(absDet, eps, one, c22 * invDet).Store(out.e[8] + i);
+        }
+    }
+
+    template <typename Lane>
+    void CullBoxesRange(const float* planes, std::size_t numPlanes, Math::ConstVec3SoA c, Math::ConstVec3SoA e,
+                        float* visible, std::size_t begin, std::size_t end)
+    {
+        const Lane zero = Lane::Set1(0.f);
+
+        for (std::size_t i = begin; i < end; i += Lane::WIDTH) {
+            const Lane cx = Lane::Load(c.x + i), cy = Lane::Load(c.y + i), cz = Lane::Load(c.z + i);
+            const Lane ex = Lane::Load(e.x + i), ey = Lane::Load(e.y + i), ez = Lane::Load(e.z + i);
+
+            Lane inside = Lane::Set1(1.f);
+            for (std::size_t p{}; p < numPlanes; ++p) {
+                const float* plane = planes + p * 4;
+                // signed distance of the center, and the box's projected radius onto the plane normal
+                const Lane dist = Lane::Set1(plane[0]) * cx + Lane::Set1(plane[1]) * cy + Lane::Set1(plane[2]) * cz + Lane::Set1(plane[3]);
+                const Lane radius = Lane::Set1(AbsFloat(plane[0])) * ex + Lane::Set1(AbsFloat(plane[1])) * ey + Lane::Set1(AbsFloat(plane[2])) * ez;
+                inside = SelectIfLess(dist + radius, zero, zero, inside);
+            }
+            inside.Store(visible + i);
+        }
+    }
+
+    template <typename Lane>
+    void SphereOverlapsBoxesRange(const float* sphere, Math::ConstVec3SoA c, Math::ConstVec3SoA e,
+                                  float* overlap, std::size_t begin, std::size_t end)
+    {
+        const Lane zero = Lane::Set1(0.f), one = Lane::Set1(1.f);
+        const Lane sx = Lane::Set1(sphere[0]), sy = Lane::Set1(sphere[1]), sz = Lane::Set1(sphere[2]);
+        const Lane radiusSqrd = Lane::Set1(sphere[3] * sphere[3]);
+
+        for (std::size_t i = begin; i < end; i += Lane::WIDTH) {
+            // per axis, how far the sphere center lies outside the box (0 when within its slab)
+            Lane dx = Abs(Lane::Load(c.x + i) - sx) - Lane::Load(e.x + i);
+            Lane dy = Abs(Lane::Load(c.y + i) - sy) - Lane::Load(e.y + i);
+            Lane dz = Abs(Lane::Load(c.z + i) - sz) - Lane::Load(e.z + i);
+            dx = SelectIfLess(dx, zero, zero, dx);
+            dy = SelectIfLess(dy, zero, zero, dy);
+            dz = SelectIfLess(dz, zero, zero, dz);
+
+            SelectIfLess(radiusSqrd, dx * dx + dy * dy + dz * dz, zero, one).Store(overlap + i);
+        }
+    }
+
+    template <typename Lane>
+    void RasterizeOccludersRows(const float* tri, float* depth, int width, int height)
+    {
+        static constexpr float LANE_OFFSETS[Math::OCCLUSION_ROW_ALIGNMENT]{ 0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f,
+                                                                            8.f, 9.f, 10.f, 11.f, 12.f, 13.f, 14.f, 15.f };
+        float x0 = tri[0], y0 = tri[1], z0 = tri[2];
+        float x1 = tri[3], y1 = tri[4], z1 = tri[5];
+        float x2 = tri[6], y2 = tri[7], z2 = tri[8];
+
+        float area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+        if (AbsFloat(area) < 1e-6f) {
+            return;
+        }
+        if (area < 0.f) {   // make it counter-clockwise
+            SwapFloats(x1, x2);
+            SwapFloats(y1, y2);
+            SwapFloats(z1, z2);
+            area = -area;
+        }
+
+        const int minX = MaxInt(FloorToInt(Min3(x0, x1, x2)), 0);
+        const int maxX = MinInt(FloorToInt(Max3(x0, x1, x2)), width - 1);
+        const int minY = MaxInt(FloorToInt(Min3(y0, y1, y2)), 0);
+        const int maxY = MinInt(FloorToInt(Max3(y0, y1, y2)), height - 1);
+        if (minX > maxX || minY > maxY) {
+            return;
+        }
+
+        // edge k: a*x + b*y + c >= 0 on the inside, tested at pixel centers. Pixels on an edge shared by two
+        // triangles are drawn by both, so that meshes come out without cracks. For that, both must get exactly
+        // opposite values along the edge whatever the rounding (or FMA contraction), hence every edge is set up
+        // from its endpoints in one fixed order and negated afterwards if needed.
+        const float xs[3]{ x0, x1, x2 }, ys[3]{ y0, y1, y2 };
+        float a[3], b[3], c[3];
+        for (int k{}; k < 3; ++k) {
+            const int next = (k + 1) % 3;
+            const bool inOrder = xs[k] < xs[next] || (xs[k] == xs[next] && ys[k] < ys[next]);
+            const int p = inOrder ? k : next, q = inOrder ? next : k;
+            const float sign = inOrder ? 1.f : -1.f;
+            a[k] = sign * (ys[p] - ys[q]);
+            b[k] = sign * (xs[q] - xs[p]);
+            c[k] = sign * (xs[p] * ys[q] - xs[q] * ys[p]);
+        }
+
+        // depth plane, pushed back to its farthest value over the pixel and never past the farthest vertex
+        const float dzdx = ((z1 - z0) * (y2 - y0) - (z2 - z0) * (y1 - y0)) / area;
+        const float dzdy = ((x1 - x0) * (z2 - z0) - (x2 - x0) * (z1 - z0)) / area;
+        const float zBias = 0.5f * (AbsFloat(dzdx) + AbsFloat(dzdy));
+        const Lane zMax = Lane::Set1(Max3(z0, z1, z2));
+
+        const Lane zero = Lane::Set1(0.f);
+        const Lane a0 = Lane::Set1(a[0]), a1 = Lane::Set1(a[1]), a2 = Lane::Set1(a[2]);
+        const Lane laneDzdx = Lane::Set1(dzdx);
+        const Lane laneOffsets = Lane::Load(LANE_OFFSETS);
+        const int firstX = minX - minX % static_cast<int>(Lane::WIDTH);
+
+        for (int y = minY; y <= maxY; ++y)
+        {
+            const float py = static_cast<float>(y) + 0.5f;
+            const Lane r0 = Lane::Set1(b[0] * py + c[0]), r1 = Lane::Set1(b[1] * py + c[1]), r2 = Lane::Set1(b[2] * py + c[2]);
+            const Lane rz = Lane::Set1(z0 + dzdy * (py - y0) - dzdx * x0 + zBias);
+            float* row = depth + static_cast<std::size_t>(y) * width;
+
+            for (int x = firstX; x <= maxX; x += static_cast<int>(Lane::WIDTH))
+            {
+                const Lane px = Lane::Set1(static_cast<float>(x) + 0.5f) + laneOffsets;
+                Lane z = laneDzdx * px + rz;
+                z = SelectIfLess(zMax, z, zMax, z);
+
+                const Lane old = Lane::Load(row + x);
+                Lane result = SelectIfLess(z, old, z, old);
+                result = SelectIfLess(a0 * px + r0, zero, old, result);
+                result = SelectIfLess(a1 * px + r1, zero, old, result);
+                result = SelectIfLess(a2 * px + r2, zero, old, result);
+                result.Store(row + x);
+            }
+        }
+    }
+
+    // Full-width body over the bulk, scalar body over the remainder.
+    template <typename Lane>
+    void TransformPoints(const float* mat, Math::ConstVec3SoA in, Math::Vec3SoA out, std::size_t count)
+    {
+        const std::size_t bulk = count - count % Lane::WIDTH;
+        TransformPointsRange<Lane>(mat, in, out, 0, bulk);
+        TransformPointsRange<ScalarLane>(mat, in, out, bulk, count);
+    }
+
+    template <typename Lane>
+    void BuildModelMatrices(Math::ConstQuatSoA orientation, Math::ConstVec3SoA position, Math::Mat4SoA out, std::size_t count)
+    {
+        const std::size_t bulk = count - count % Lane::WIDTH;
+        BuildModelMatricesRange<Lane>(orientation, position, out, 0, bulk);
+        BuildModelMatricesRange<ScalarLane>(orientation, position, out, bulk, count);
+    }
+
+    template <typename Lane>
+    void ComputeNormalMatrices(Math::ConstMat4SoA models, Math::Mat3SoA out, std::size_t count)
+    {
+        const std::size_t bulk = count - count % Lane::WIDTH;
+        ComputeNormalMatricesRange<Lane>(models, out, 0, bulk);
+        ComputeNormalMatricesRange<ScalarLane>(models, out, bulk, count);
+    }
+
+    template <typename Lane>
+    void UpdateRigidTransforms(Math::ConstQuatSoA orientation, Math::ConstVec3SoA position, Math::ConstMat3SoA inverseInertiaLocal,
+                               Math::Mat4SoA localToWorld, Math::Mat3SoA inverseInertiaWorld, std::size_t count)
+    {
+        const std::size_t bulk = count - count % Lane::WIDTH;
+        UpdateRigidTransformsRange<Lane>(orientation, position, inverseInertiaLocal, localToWorld, inverseInertiaWorld, 0, bulk);
+        UpdateRigidTransformsRange<ScalarLane>(orientation, position, inverseInertiaLocal, localToWorld, inverseInertiaWorld, bulk, count);
+    }
+
+    template <typename Lane>
+    void CullBoxes(const float* planes, std::size_t numPlanes, Math::ConstVec3SoA centers, Math::ConstVec3SoA halfExtents,
+                   float* visible, std::size_t count)
+    {
+        const std::size_t bulk = count - count % Lane::WIDTH;
+        CullBoxesRange<Lane>(planes, numPlanes, centers, halfExtents, visible, 0, bulk);
+        CullBoxesRange<ScalarLane>(planes, numPlanes, centers, halfExtents, visible, bulk, count);
+    }
+
+    template <typename Lane>
+    void SphereOverlapsBoxes(const float* sphere, Math::ConstVec3SoA centers, Math::ConstVec3SoA halfExtents,
+                             float* overlap, std::size_t count)
+    {
+        const std::size_t bulk = count - count % Lane::WIDTH;
+        SphereOverlapsBoxesRange<Lane>(sphere, centers, halfExtents, overlap, 0, bulk);
+        SphereOverlapsBoxesRange<ScalarLane>(sphere, centers, halfExtents, overlap, bulk, count);
+    }
+
+    // Rows are padded to OCCLUSION_ROW_ALIGNMENT, so there is no remainder to handle here
+    template <typename Lane>
+    void RasterizeOccluders(const float* triangles, std::size_t numTriangles, float* depth, int width, int height)
+    {
+        static_assert(Math::OCCLUSION_ROW_ALIGNMENT % Lane::WIDTH == 0, "a lane must never cross the end of a row");
+        for (std::size_t t{}; t < numTriangles; ++t) {
+            RasterizeOccludersRows<Lane>(triangles + 9 * t, depth, width, height);
+        }
+    }
+
+    template <typename Lane>
+    constexpr Math::SimdKernelTable MakeKernelTable(Math::SimdLevel level)
+    {
+        return {
+            level,
+            &TransformPoints<Lane>,
+            &BuildModelMatrices<Lane>,
+            &ComputeNormalMatrices<Lane>,
+            &UpdateRigidTransforms<Lane>,
+            &CullBoxes<Lane>,
+            &SphereOverlapsBoxes<Lane>,
+            &RasterizeOccluders<Lane>
+        };
+    }
+}
+
@@ -20,14 +20,7 @@ namespace Physics {
 	public:
 		Collider(bool isCollisionEnabled) :m_isCollisionEnabled{isCollisionEnabled} {}
 		template<typename T>
-		void SetScale(const T& scale) {
-			if constexpr (std::is_same_v<T, Vec3>) {
-				static_cast<BoxCollider*>(this)->SetScaleInternal(scale);
-			}
-			else if constexpr (std::is_same_v<T, float>) {
-				static_cast<SphereCollider*>(this)->SetScaleInternal(scale);
-			}
-		}
+		void SetScale(const T& scale);
 		virtual void SetCollisionEnabled(bool collisionEnabled) { m_isCollisionEnabled = collisionEnabled; }
 		virtual bool GetCollisionEnabled()const { return m_isCollisionEnabled; }
 		virtual Matrix4 GetScaleMatrix() const = 0;
@@ -71,6 +64,17 @@ namespace Physics {
 		}
 	};
 
+	// defined once both colliders are complete, as standard two-phase lookup requires
+	template<typename T>
+	void Collider::SetScale(const T& scale) {
+		if constexpr (std::is_same_v<T, Vec3>) {
+			static_cast<BoxCollider*>(this)->SetScaleInternal(scale);
+		}
+		else if constexpr (std::is_same_v<T, float>) {
+			static_cast<SphereCollider*>(this)->SetScaleInternal(scale);
+		}
+	}
+
 	////(3) Infinite Plane
 	//class PlaneCollider : public Collider {
 	//	Vec3 normal;  // Normal vector of the plane
@@ -15,8 +15,21 @@ namespace Physics {
 
 
     class CollisionManager {
+    public:
+        /*  What the last step went through, reset by Reset(). Every pair is tested (there is no broad
+            phase yet), so pairsOverlapping is what one would have to keep: box pairs whose bounding
+            spheres overlap, and pairs with a sphere that touch, since their exact test is as cheap.
+        */
+        struct StepStats {
+            size_t pairsTested{};       // pairs of colliders that both had collisions enabled
+            size_t pairsOverlapping{};
+            size_t contacts{};
+            int solverIterations{};     // passes of the sequential impulse solver over the contacts
+        };
+
     private:
         std::vector<CollisionData> m_collisions;
+        StepStats m_stats;
         //mutable std::mutex m_mutex;  
 
         float m_friction;
@@ -52,6 +65,7 @@ namespace Physics {
             if (distanceSquared > radiusSum * radiusSum) {
                 return; // no collision
             }
+            ++m_stats.pairsOverlapping;
 
             Vector3 normal = (spherePos1 - spherePos2).Normalize();
 
@@ -100,5 +114,6 @@ namespace Physics {
         void ResolveCollision(float dt);
         void AddCollision(const CollisionData& data);
         std::vector<CollisionData> GetCollisions() const;
+        const StepStats& GetStepStats() const { return m_stats; }
     };
 }
@@ -30,8 +30,10 @@ namespace Physics
 
         static constexpr float SPHERE_INERTIA_FACTOR = 0.4f;
         static constexpr float CUBE_INERTIA_FACTOR = 1 / 6.0f;
+
+        friend class RigidBodyBatch;
     public:
-        RigidBody(Core::Transform& _transform, float _mass = 1.f, ColliderType colliderType=ColliderType::OBB) : transform{ _transform }, massInverse{ 1.f/_mass }, linearDamping(0.9f), angularDamping(0.75f)
+        RigidBody(const Core::Transform& _transform, float _mass = 1.f, ColliderType colliderType=ColliderType::OBB) : transform{ _transform }, massInverse{ 1.f/_mass }, linearDamping(0.9f), angularDamping(0.75f)
         {
             Math::Matrix3 inertiaTensor;
             float diagonal = _mass *  (colliderType == ColliderType::SPHERE) ?  SPHERE_INERTIA_FACTOR : CUBE_INERTIA_FACTOR;
@@ -40,6 +42,10 @@ namespace Physics
         }
 
         void Integrate(float duration);
+        // steps 0-3 of Integrate (forces, velocities, position and orientation) without refreshing
+        // m_localToWorld/inverseInertiaTensorWorld; RigidBodyBatch does that for all bodies at once.
+        // returns false for fixed bodies, which are left untouched.
+        bool IntegrateMotion(float duration);
         void AddForceAt(const Vector3& force, const Vector3& point);
         void AddForce(const Vector3& force);
         Vector3 GetAxis(int index) const;
@@ -84,6 +90,7 @@ namespace Physics
         Vector3 GetAcceleration() const;
         float GetLinearDamping() const;
         Matrix4 GetLocalToWorldMatrix() const;
+        uint64_t GetTransformVersion() const { return transform.m_version; }
 
         static constexpr float GRAVITY = -9.81f;
     }; 
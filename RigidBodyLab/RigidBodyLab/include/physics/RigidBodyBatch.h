@@ -0,0 +1,47 @@
+#pragma once
+#include <math/SimdKernels.h>
+#include <vector>
+
+namespace Physics
+{
+    class RigidBody;
+
+    // Refreshes m_localToWorld and inverseInertiaTensorWorld for many bodies in one kernel call.
+    // Bodies are gathered into structure-of-arrays planes, run through
+    // Math::SimdKernelTable::updateRigidTransforms (one SIMD lane per body) and scattered back.
+    // The plane storage is kept between frames, so steady-state updates do not allocate.
+    class RigidBodyBatch
+    {
+        enum Plane {
+            QUAT_W = 0, QUAT_X, QUAT_Y, QUAT_Z,
+            POS_X, POS_Y, POS_Z,
+            INV_INERTIA,                            // 9 planes, column-major
+            LOCAL_TO_WORLD = INV_INERTIA + 9,       // 16 planes, column-major
+            INV_INERTIA_WORLD = LOCAL_TO_WORLD + 16,// 9 planes, column-major
+            NUM_PLANES = INV_INERTIA_WORLD + 9
+        };
+
+        std::vector<RigidBody*> m_bodies;
+        std::vector<float> m_planes; // NUM_PLANES * m_capacity floats
+
+        size_t m_capacity{};
+
+        float* GetPlane(int plane) { return m_planes.data() + plane * m_capacity; }
+        void Reserve(size_t count);
+
+    public:
+        void Clear() { m_bodies.clear(); }
+        void Add(RigidBody* body) { m_bodies.push_back(body); }
+        size_t GetSize() const { return m_bodies.size(); }
+
+        /****************************************************************************/
+        /*!
+        \fn     void RigidBodyBatch::UpdateTransforms()
+        \brief
+                Equivalent to calling transform.Update() and TransformInertiaTensor()
+                on every added body, but vectorised across bodies.
+        */
+        /****************************************************************************/
+        void UpdateTransforms();
+    };
+}
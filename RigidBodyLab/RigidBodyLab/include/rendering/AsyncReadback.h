@@ -0,0 +1,55 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering
+{
+    /*  Reads pixels back to the CPU without stalling on the GPU.
+        Each request copies a rectangle of the current read buffer into one of RING_SIZE
+        pixel-pack buffers and drops a fence behind it; Poll() hands out the oldest request
+        once its fence has signaled, which with one request per frame is frame N-2.
+        Only needs GL 3.2 (pixel buffers and sync objects), so it works on software
+        implementations such as Mesa llvmpipe too.
+    */
+    class AsyncReadback
+    {
+    public:
+        static constexpr int RING_SIZE = 3;
+
+        /*  RGBA8 pixels, bottom row first as glReadPixels returns them */
+        struct Frame {
+            std::uint64_t id{};
+            int width{};
+            int height{};
+            std::vector<unsigned char> pixels;
+        };
+
+        void Init(int width, int height);
+        void Release();
+
+        bool Request(std::uint64_t id, int x, int y);
+        bool Poll(Frame& frame, bool wait = false);
+
+        int GetWidth() const { return m_width; }
+        int GetHeight() const { return m_height; }
+        int GetNumPending() const { return m_numPending; }
+        unsigned GetNumDropped() const { return m_numDropped; }
+
+    private:
+        struct Slot {
+            GLuint pbo{};
+            void* fence{};          // GLsync, opaque here since GLFW's GL header predates sync objects
+            std::uint64_t id{};
+        };
+
+        std::array<Slot, RING_SIZE> m_slots{};
+        int m_width{};
+        int m_height{};
+        int m_oldest{};             // slot of the oldest pending request
+        int m_numPending{};
+        unsigned m_numDropped{};    // requests refused because every slot was still in flight, or lost while mapped
+    };
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+namespace Rendering
+{
+    /*  Picks the internal render resolution, as a scale of the output size, from measured frame times.
+        The GPU time of a frame goes roughly with its number of pixels, i.e. with scale^2:
+            - over budget, the scale drops at once to where the frame would have fit, with some
+              headroom, so that a load spike costs one late frame rather than a run of them,
+            - well under budget for RAISE_AFTER_FRAMES frames in a row, it goes back up one step.
+        The CPU time does not depend on the resolution; while the CPU alone is over budget the scale
+        is held, as a higher resolution would only make the GPU late too.
+        Measurements reach Update() a few frames late (timer queries are read without waiting), so
+        the ones of the SETTLE_FRAMES frames after a change are ignored.
+        Scales are multiples of SCALE_STEP within [minScale, maxScale], so that render targets only
+        change size by whole steps.
+    */
+    class DynamicResolution
+    {
+    public:
+        static constexpr float SCALE_STEP = 1.f / 16.f;
+        static constexpr float HEADROOM = 0.9f;         // fraction of the budget aimed at when dropping
+        static constexpr float RAISE_BELOW = 0.7f;      // fraction of the budget under which the scale may go up
+        static constexpr int RAISE_AFTER_FRAMES = 30;
+        static constexpr int SETTLE_FRAMES = 3;
+
+        explicit DynamicResolution(float budgetMs = 1000.f / 60.f, float minScale = 0.5f, float maxScale = 1.f);
+
+        void SetBudget(float budgetMs) { m_budgetMs = budgetMs; }
+        void SetLimits(float minScale, float maxScale);
+        float Update(float gpuMs, float cpuMs);
+
+        float GetScale() const { return m_scale; }
+        float GetBudget() const { return m_budgetMs; }
+        float GetMinScale() const { return m_minScale; }
+        float GetMaxScale() const { return m_maxScale; }
+
+        /*  size * scale, rounded, at least 1 */
+        static int ScaleSize(int size, float scale);
+
+    private:
+        float m_budgetMs;
+        float m_minScale;
+        float m_maxScale;
+        float m_scale;
+        int m_framesUnderBudget{};
+        int m_framesToSettle{};
+    };
+}
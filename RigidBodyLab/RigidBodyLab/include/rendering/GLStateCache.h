@@ -0,0 +1,95 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Rendering
+{
+    /*  Kinds of GL calls that go through the state cache, for the per-frame counters */
+    enum class GLStateCall {
+        PROGRAM = 0,
+        VERTEX_ARRAY,
+        ACTIVE_TEXTURE,
+        TEXTURE,
+        CULL_FACE,
+        CAPABILITY,         // glEnable/glDisable
+        DEPTH_MASK,
+        UNIFORM,
+        NUM_CALLS
+    };
+
+    struct GLStateStats {
+        std::array<unsigned, static_cast<int>(GLStateCall::NUM_CALLS)> issued{};
+        std::array<unsigned, static_cast<int>(GLStateCall::NUM_CALLS)> skipped{};
+
+        unsigned TotalIssued() const;
+        unsigned TotalSkipped() const;
+    };
+
+    /*  Shadows the GL state the renderer changes in its hot paths (bound program, VAO, texture
+        units, cull face, depth state, and uniform values per program) and drops calls that would
+        set what is already set.
+        Anything that changes the bindings behind the cache's back (ImGui, resource uploads) must be
+        followed by Invalidate(); BeginFrame() does so at the start of every frame.
+        Uniform values live in the program object, so they are kept across frames until the program
+        is relinked or deleted, which must be followed by ForgetProgram().
+    */
+    class GLStateCache
+    {
+    public:
+        static constexpr int NUM_TEXTURE_UNITS = 16;
+
+        void BeginFrame();
+        void Invalidate();
+        void ForgetProgram(GLuint program);
+
+        void UseProgram(GLuint program);
+        void BindVertexArray(GLuint vao);
+        void BindTexture(int unit, GLenum target, GLuint texture);
+        void CullFace(GLenum face);
+        void SetCapability(GLenum cap, bool enabled);
+        void DepthMask(bool enabled);
+
+        /*  Uniforms of the program in use. Values are remembered per (program, location). */
+        void Uniform1i(GLint location, GLint value);
+        void Uniform1f(GLint location, GLfloat value);
+        void Uniform2f(GLint location, GLfloat x, GLfloat y);
+        void Uniform3fv(GLint location, const GLfloat* value);
+        void Uniform4fv(GLint location, const GLfloat* value, GLsizei count = 1);
+        void UniformMatrix4fv(GLint location, const GLfloat* value, GLsizei count = 1);
+
+        /*  Counters of the frame before the current one */
+        const GLStateStats& GetLastFrameStats() const { return m_lastFrameStats; }
+
+    private:
+        /*  Raw bits of the last value sent, so ints and floats compare exactly.
+            Arrays (the shadow matrices) are stored whole, hence the vector. */
+        struct UniformValue {
+            std::vector<std::uint32_t> bits;
+        };
+
+        bool SetUniform(GLint location, const void* value, int size);
+        void Count(GLStateCall call, bool issued);
+
+        /*  UNKNOWN means "not known since the last Invalidate", so the next call always goes through */
+        static constexpr GLuint UNKNOWN = ~GLuint(0);
+        static constexpr GLenum UNKNOWN_ENUM = ~GLenum(0);
+
+        GLuint m_program{ UNKNOWN };
+        GLuint m_vertexArray{ UNKNOWN };
+        int m_activeUnit{ -1 };
+        std::array<GLuint, NUM_TEXTURE_UNITS> m_textures{};
+        std::array<GLenum, NUM_TEXTURE_UNITS> m_textureTargets{};
+        GLenum m_cullFace{ UNKNOWN_ENUM };
+        int m_cullFaceEnabled{ -1 };
+        int m_depthTestEnabled{ -1 };
+        int m_depthMask{ -1 };
+        std::unordered_map<std::uint64_t, UniformValue> m_uniforms;     // key: program << 32 | location
+
+        GLStateStats m_frameStats;
+        GLStateStats m_lastFrameStats;
+    };
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+#include <rendering/ProfileLog.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering
+{
+    /*  GPU time of the render passes, from GL_TIME_ELAPSED queries.
+        A pass is timed between Begin() and End(), most simply with a Scope. Time-elapsed queries
+        cannot overlap, so a scope opened inside another is counted in the outer one.
+        The queries are double-buffered: those of a frame are read back in the BeginFrame() of
+        NUM_BUFFERS frames later, by when the GPU is normally done with them. Nothing waits on the
+        GPU; a frame whose queries are still pending by then is dropped. Results go to a ProfileLog.
+        Only needs GL 3.3 timer queries, which Mesa's software rasterizers implement too.
+    */
+    class GpuProfiler
+    {
+    public:
+        static constexpr int NUM_BUFFERS = 2;
+
+        class Scope
+        {
+        public:
+            Scope(GpuProfiler& profiler, const char* pass) : m_profiler{ profiler } { m_profiler.Begin(pass); }
+            ~Scope() { m_profiler.End(); }
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            GpuProfiler& m_profiler;
+        };
+
+        void Release();
+
+        bool BeginFrame(std::uint64_t frameIndex);
+        void Begin(const char* pass);
+        void End();
+
+        const ProfileLog& GetLog() const { return m_log; }
+        ProfileLog& GetLog() { return m_log; }
+        unsigned GetNumDropped() const { return m_numDropped; }
+
+    private:
+        /*  Queries are created as a frame needs them and reused by the frames of the same buffer */
+        struct Buffer {
+            std::vector<GLuint> queries;
+            std::vector<int> passes;    // pass index of each used query
+            std::uint64_t frameIndex{};
+        };
+
+        std::array<Buffer, NUM_BUFFERS> m_buffers{};
+        int m_current{};
+        int m_depth{};              // scopes open, only the outermost one has a query
+        ProfileLog m_log;
+        unsigned m_numDropped{};    // frames whose queries were not done when their buffer came around
+    };
+}
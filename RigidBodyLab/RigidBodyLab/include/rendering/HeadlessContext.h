@@ -0,0 +1,31 @@
+#pragma once
+
+namespace Rendering
+{
+    /*  OpenGL context without a window or a display, to render on benchmark machines.
+        Made with EGL, on Mesa's surfaceless platform when there is one (which also covers
+        machines without a GPU, through llvmpipe) and on the default display otherwise.
+        The context has no surface, hence no default framebuffer: the renderer draws the
+        frame into its own framebuffer object.
+        Only available where CMake found EGL (RIGIDBODYLAB_HAS_EGL); elsewhere Create() fails.
+    */
+    class HeadlessContext
+    {
+    public:
+        HeadlessContext() = default;
+        ~HeadlessContext() { Destroy(); }
+        HeadlessContext(const HeadlessContext&) = delete;
+        HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+        bool Create(int majorVersion, int minorVersion);
+        void Destroy();
+        bool IsCreated() const { return m_context != nullptr; }
+
+        /*  Loader for glad, like glfwGetProcAddress */
+        static void* GetProcAddress(const char* name);
+
+    private:
+        void* m_display{};  // EGLDisplay, opaque so that the EGL headers stay out of the renderer
+        void* m_context{};  // EGLContext
+    };
+}
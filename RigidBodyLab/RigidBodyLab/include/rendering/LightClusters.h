@@ -0,0 +1,56 @@
+#pragma once
+
+#include <math/Math.h>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering
+{
+    /*  Clustered light assignment on the CPU.
+        The view frustum is split into TILES_X * TILES_Y screen tiles and NUM_SLICES depth
+        slices spaced exponentially between the near and far planes. Each light sphere is
+        tested against the view-space bounding boxes of the clusters its depth range crosses,
+        and the result is flattened into:
+            - ranges:  (offset, count) per cluster, slice-major then row-major,
+            - indices: light indices, the lights of a cluster being indices[offset .. offset + count).
+        The light pass finds the cluster of a pixel from its screen position and view depth
+        (slice = log(depth) * sliceScale + sliceBias) and only shades with those lights.
+    */
+    class LightClusters
+    {
+    public:
+        static constexpr int TILES_X = 16;
+        static constexpr int TILES_Y = 16;
+        static constexpr int NUM_SLICES = 24;
+        static constexpr int TILES_PER_SLICE = TILES_X * TILES_Y;
+        static constexpr int NUM_CLUSTERS = TILES_PER_SLICE * NUM_SLICES;
+
+        void SetProjection(const Mat4& projMat, float nearPlane, float farPlane);
+        void AssignLights(const Vec4* lightSpheresVF, int numLights);
+
+        /*  slice = log(view depth) * sliceScale + sliceBias */
+        float GetSliceScale() const { return m_sliceScale; }
+        float GetSliceBias() const { return m_sliceBias; }
+
+        const std::vector<std::uint32_t>& GetRanges() const { return m_ranges; }
+        const std::vector<std::uint32_t>& GetIndices() const { return m_indices; }
+
+    private:
+        int GetSlice(float depth) const;
+
+        Mat4 m_projMat{ 0.f };
+        float m_nearPlane{};
+        float m_farPlane{};
+        float m_sliceScale{};
+        float m_sliceBias{};
+
+        /*  View-space boxes of the clusters, SoA for the SIMD sphere test */
+        std::vector<float> m_centerX, m_centerY, m_centerZ;
+        std::vector<float> m_halfX, m_halfY, m_halfZ;
+
+        std::vector<float> m_overlap;                           // sphere test result of one slice
+        std::vector<std::uint32_t> m_pairs;                     // (cluster, light) pairs, interleaved
+        std::vector<std::uint32_t> m_ranges;                    // (offset, count) per cluster
+        std::vector<std::uint32_t> m_indices;
+    };
+}
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <vector>
-#include <GLFW/glfw3.h>
 #include <math/Math.h>
 #include <math/Vector3.h>
 #include <math/Matrix4.h>
@@ -22,17 +21,6 @@ namespace Rendering {
     const int indexSize = sizeof(int);
 
 
-    /*  The layouts for specifying the offsets of a vertex
-        when it is copied into the graphics pipeline. */
-    struct VertexLayout
-    {
-        int location;
-        int size;
-        int type;
-        bool normalized;
-        int offset;
-    };
-
     struct BoundingBoxInfo {
         Vector3 center;
         Vector3 extents;
@@ -40,22 +28,12 @@ namespace Rendering {
         BoundingBoxInfo(const Vector3& center= Vector3(0, 0, 0), const Vector3& extents= Vector3(1.f, 1.f, 1.f)) : center(center), extents(extents) {}
     };
 
-    const VertexLayout vLayout[] =
-    {
-        { 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, pos) },
-        { 1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, nrm) },
-        { 2, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, tan) },
-        { 3, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, bitan) },
-        { 4, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, uv) }
-    };
-
-    const int layoutSize = sizeof(VertexLayout);
-    const int numAttribs = sizeof(vLayout) / layoutSize;
-
     using VertexBuffer=std::vector<Vertex>;
     using IndexBuffer=std::vector<int>;
 
-    /*  Mesh format, only contains geometric data but not color/texture */
+    /*  Mesh format, only contains geometric data but not color/texture.
+        CPU side only, the GL vertex layout is the renderer's (see Renderer.h).
+    */
     struct Mesh
     {
         Mesh();
@@ -67,23 +45,25 @@ namespace Rendering {
         int numTris;
         int numIndices;
 
-        /*  Once the buffer data has been copied into the pipeline, these array object and
-            buffer objects will store  its "states".
-            Later on if we want to render a mesh, we just need to bind the VAO.
-            We don't need to copy the buffer data again.
+        /*  All meshes share one vertex buffer and one index buffer (see Renderer::SetUpMeshBuffers).
+            These are where this mesh starts in them, as used by the indirect draw commands.
         */
-        GLuint VAO;
-        GLuint VBO;
-        GLuint IBO;
+        int baseVertex;
+        unsigned firstIndex;
+        unsigned drawID;        // index among the packed meshes, the mesh field of the render queue sort key
         
         BoundingBoxInfo m_boundingBox;//be default scl=(1,1,1), center={0,0,0}
 
+        /*  Box around the raw vertex positions (before GetBoundingBoxMat), used for culling */
+        Vec3 m_vertexBoundsCenter;
+        Vec3 m_vertexBoundsHalfSize;
+
         Math::Matrix4 GetBoundingBoxMat()const;
         /*  Mesh function(s) */
         static Mesh CreatePlane(int stacks, int slices);
         static Mesh CreateCube(int length, int height, int width);
         static Mesh CreateSphere(int stacks, int slices);
-        static Mesh LoadOBJMesh(char* filename, bool flipX = false);
+        static Mesh LoadOBJMesh(const char* filename, bool flipX = false);
     };
 
 }
\ No newline at end of file
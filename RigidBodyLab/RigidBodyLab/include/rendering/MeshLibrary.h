@@ -0,0 +1,25 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <utilities/ToUnderlyingEnum.h>
+#include <rendering/ResourceIDs.h>
+#include <rendering/Mesh.h>
+
+namespace Rendering {
+
+	/*  The meshes of the MeshIDs, CPU side only: the scene takes them from here, so that it can be
+		built without a GL context. ResourceManager owns the one the renderer uploads.
+		A mesh that was not loaded is null; objects made with it have no mesh, which is enough for
+		physics-only scenes (see Core::Scene).
+	*/
+	class MeshLibrary {
+		std::array<std::unique_ptr<Mesh>, TO_INT(MeshID::NUM_MESHES)> m_meshes{};
+
+	public:
+		void LoadDefaultMeshes();
+
+		Mesh* GetMesh(MeshID id) { return m_meshes[TO_INT(id)].get(); }
+		const Mesh* GetMesh(MeshID id) const { return m_meshes[TO_INT(id)].get(); }
+		void SetMesh(MeshID id, std::unique_ptr<Mesh> newMesh) { m_meshes[TO_INT(id)] = std::move(newMesh); }
+	};
+}
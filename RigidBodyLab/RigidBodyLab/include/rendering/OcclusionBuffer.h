@@ -0,0 +1,60 @@
+#pragma once
+
+#include <math/SimdKernels.h>
+#include <cstddef>
+#include <vector>
+
+namespace Rendering
+{
+    /*  Simplified copy of a mesh used to draw the occlusion buffer: positions (xyz) and triangle indices */
+    struct OccluderMesh {
+        std::vector<float> positions;
+        std::vector<unsigned> indices;
+
+        std::size_t GetNumTriangles() const { return indices.size() / 3; }
+    };
+
+    /*  Software occlusion culling on the CPU.
+        Occluder meshes are rasterized into a small depth buffer (rasterizeOccluders kernel) from
+        one camera, then the world-space boxes of the objects are tested against it: a box whose
+        nearest depth lies behind the buffer everywhere it covers on screen is hidden.
+        Depth is kept conservative, so that the buffer never puts an occluder nearer than it is:
+            - a pixel gets the farthest depth its triangle reaches over it, not the one at its center,
+            - simplifying an occluder only drops triangles, it never moves them.
+        Coverage is sampled at pixel centers like the GPU does, so that meshes are drawn without
+        cracks; an occluder's silhouette may therefore be off by up to half a pixel of the buffer.
+        Matrices are 16 column-major floats, so this does not depend on glm and can be unit-tested.
+    */
+    class OcclusionBuffer
+    {
+    public:
+        static constexpr int DEFAULT_SIZE = 128;
+
+        explicit OcclusionBuffer(int width = DEFAULT_SIZE, int height = DEFAULT_SIZE);
+
+        static OccluderMesh Simplify(const float* positions, std::size_t stride, const int* indices, std::size_t numIndices,
+            std::size_t maxTriangles);
+
+        void Begin(const float* viewProj);
+        void AddOccluder(const OccluderMesh& mesh, const float* model);
+        bool IsBoxVisible(const float* center, const float* halfExtents) const;
+        std::size_t CullBoxes(Math::ConstVec3SoA centers, Math::ConstVec3SoA halfExtents, float* visible, std::size_t count) const;
+
+        int GetWidth() const { return m_width; }
+        int GetHeight() const { return m_height; }
+        float GetDepth(int x, int y) const { return m_depth[static_cast<std::size_t>(y) * m_width + x]; }
+        std::size_t GetNumTriangles() const { return m_numTriangles; }
+
+    private:
+        void ClipAndProject(const float* a, const float* b, const float* c);
+        void EmitTriangle(const float* a, const float* b, const float* c);
+
+        int m_width;
+        int m_height;
+        std::vector<float> m_depth;         // 1 (far) where nothing was drawn
+        float m_viewProj[16]{};
+        std::vector<float> m_clipPositions; // clip space (x, y, z, w) of the occluder being added
+        std::vector<float> m_triangles;     // screen-space triangles for the kernel, see rasterizeOccluders
+        std::size_t m_numTriangles{};       // drawn since Begin()
+    };
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Rendering
+{
+    /*  Per-pass times of the profiled frames, shown in the GUI and exported as CSV.
+        Passes get an index by name the first time they are seen. A frame holds one time per pass,
+        NOT_RUN for the passes it skipped (e.g. the mirror when its texture was reused); statistics
+        count those as 0 ms, so that they give the cost per frame.
+        The last MAX_FRAMES frames are kept, so that a whole run can be exported.
+    */
+    class ProfileLog
+    {
+    public:
+        static constexpr float NOT_RUN = -1.f;
+        static constexpr int TOTAL = -1;                    // pass index standing for the sum of the passes
+        static constexpr std::size_t MAX_FRAMES = 1 << 16;
+        static constexpr std::size_t STATS_FRAMES = 120;
+
+        struct Frame {
+            std::uint64_t index{};
+            std::vector<float> passMs;  // by pass index, may be shorter than the number of passes
+
+            float GetMs(int pass) const;
+        };
+
+        int GetPassIndex(const std::string& name);
+        void AddFrame(std::uint64_t index, std::vector<float> passMs);
+        void Clear() { m_frames.clear(); }
+
+        int GetNumPasses() const { return static_cast<int>(m_passNames.size()); }
+        const std::string& GetPassName(int pass) const { return m_passNames[pass]; }
+        std::size_t GetNumFrames() const { return m_frames.size(); }
+        const Frame& GetFrame(std::size_t i) const { return m_frames[i]; }     // oldest first
+
+        float GetAverageMs(int pass, std::size_t numFrames = STATS_FRAMES) const;
+        float GetMaxMs(int pass, std::size_t numFrames = STATS_FRAMES) const;
+
+        void WriteCsv(std::ostream& out) const;
+        bool WriteCsv(const std::string& path) const;
+
+    private:
+        std::vector<std::string> m_passNames;
+        std::deque<Frame> m_frames;
+    };
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Rendering
+{
+    /*  Draw items of every pass of a frame, ordered by a 64-bit key so that consecutive
+        items share as much GL state as possible. Key layout, most significant first:
+
+            pass (4) | program (4) | cull mode (1) | texture (8) | mesh (16) | depth (16) | unused (15)
+
+        Sorting groups items by pass first, then by the state that is most expensive to switch.
+        Depth comes last and orders items front to back within an otherwise identical state.
+    */
+    class RenderQueue
+    {
+    public:
+        struct Item {
+            std::uint64_t key;
+            int objIdx;
+        };
+
+        static constexpr int PASS_BITS = 4;
+        static constexpr int PROGRAM_BITS = 4;
+        static constexpr int CULL_BITS = 1;
+        static constexpr int TEXTURE_BITS = 8;
+        static constexpr int MESH_BITS = 16;
+        static constexpr int DEPTH_BITS = 16;
+
+        static constexpr int DEPTH_SHIFT = 15;
+        static constexpr int MESH_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+        static constexpr int TEXTURE_SHIFT = MESH_SHIFT + MESH_BITS;
+        static constexpr int CULL_SHIFT = TEXTURE_SHIFT + TEXTURE_BITS;
+        static constexpr int PROGRAM_SHIFT = CULL_SHIFT + CULL_BITS;
+        static constexpr int PASS_SHIFT = PROGRAM_SHIFT + PROGRAM_BITS;
+
+        /*  Mask of the key bits that decide the GL state of a draw (everything but mesh and depth) */
+        static constexpr std::uint64_t STATE_MASK = ~((std::uint64_t(1) << MESH_SHIFT) - 1);
+
+        static std::uint64_t MakeKey(unsigned pass, unsigned program, bool cullFront, unsigned texture, unsigned mesh, float viewDepth);
+        static unsigned GetPass(std::uint64_t key) { return Field(key, PASS_SHIFT, PASS_BITS); }
+        static unsigned GetProgram(std::uint64_t key) { return Field(key, PROGRAM_SHIFT, PROGRAM_BITS); }
+        static bool GetCullFront(std::uint64_t key) { return Field(key, CULL_SHIFT, CULL_BITS) != 0; }
+        static unsigned GetTexture(std::uint64_t key) { return Field(key, TEXTURE_SHIFT, TEXTURE_BITS); }
+        static unsigned GetMesh(std::uint64_t key) { return Field(key, MESH_SHIFT, MESH_BITS); }
+
+        void Clear() { m_items.clear(); }
+        void Push(std::uint64_t key, int objIdx) { m_items.push_back({ key, objIdx }); }
+        void Sort();
+
+        const std::vector<Item>& GetItems() const { return m_items; }
+
+    private:
+        static unsigned Field(std::uint64_t key, int shift, int bits) {
+            return static_cast<unsigned>((key >> shift) & ((std::uint64_t(1) << bits) - 1));
+        }
+
+        std::vector<Item> m_items;
+        std::vector<Item> m_scratch;    // ping-pong buffer of the radix sort
+    };
+}
@@ -2,6 +2,16 @@
 #include <GLFW/glfw3.h>
 #include <utilities/ToUnderlyingEnum.h>
 #include <rendering/Shader.h>
+#include <rendering/RenderQueue.h>
+#include <rendering/GLStateCache.h>
+#include <rendering/LightClusters.h>
+#include <rendering/ShadowAtlas.h>
+#include <rendering/AsyncReadback.h>
+#include <rendering/OcclusionBuffer.h>
+#include <rendering/DynamicResolution.h>
+#include <rendering/GpuProfiler.h>
+#include <rendering/HeadlessContext.h>
+#include <rendering/ResourceManager.h>
 #include <core/Object.h>
 #include <core/Scene.h>
 #include <unordered_map>
@@ -62,24 +72,139 @@ namespace Rendering {
 
 	class ResourceManager;
 
+	/*  The layouts for specifying the offsets of a vertex
+		when it is copied into the graphics pipeline. */
+	struct VertexLayout
+	{
+		int location;
+		int size;
+		int type;
+		bool normalized;
+		int offset;
+	};
+
+	const VertexLayout vLayout[] =
+	{
+		{ 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, pos) },
+		{ 1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, nrm) },
+		{ 2, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, tan) },
+		{ 3, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, bitan) },
+		{ 4, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, uv) }
+	};
+
+	const int layoutSize = sizeof(VertexLayout);
+	const int numAttribs = sizeof(vLayout) / layoutSize;
+
+	/*  World-space matrices of one object, shared by every render pass.
+		Rebuilt only when the object's model version changes (see Core::Object::GetModelVersion).
+	*/
+	struct ObjectMatrices {
+		const Core::Object* object{ nullptr };
+		uint64_t version{};
+		uint64_t changedFrame{};    // Renderer frame index of the last version change
+		Mat4 model;
+		Mat4 normalModel;   // transpose(inverse(model))
+	};
+
+	/*  Model-view matrices of one object as seen from one camera.
+		The geometry pass reads them as per-instance vertex attributes (locations 5-12),
+		so the layout must match deferred_geom.vs.
+	*/
+	struct alignas(16) ObjectMVMatrices {
+		Mat4 mv;
+		Mat4 nmv;           // transpose(inverse(mv))
+	};
+	constexpr GLuint MV_MATRIX_LOCATION = 5;    // mat4 attributes take 4 consecutive locations
+	constexpr GLuint NMV_MATRIX_LOCATION = 9;
+
+	/*  One slab of ObjectMVMatrices per camera, stored back to back in the same buffer */
+	enum class MVSlabID {
+		MAIN_CAM = 0,
+		MIRROR_CAM,
+		SPHERE_CAM,         // followed by one slab per remaining cube face
+		NUM_SLABS = SPHERE_CAM + TO_INT(CubeFaceID::NUM_FACES)
+	};
+
+	/*  What a slab is built from: the camera's view and whether it changed since the slab was last filled */
+	struct MVSlabView {
+		Mat4 view;
+		Mat4 viewInvTrans;  // transpose(inverse(view)), so that nmv = viewInvTrans * normalModel
+		Vec4 frustumPlanes[6];  // world space, see FrustumPlanes()
+		Mat4 viewProj;      // for the occlusion buffer
+		Vec3 camPos;        // world space
+		bool viewChanged{ true };
+		bool active{ false };   // false when the pass is skipped (e.g. mirror not visible)
+	};
+
+	/*  Layout fixed by GL_DRAW_INDIRECT_BUFFER: one instanced draw of one mesh */
+	struct DrawElementsIndirectCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;    // first entry of the instance buffer
+	};
+
+	/*  Visible objects of one pass sharing texture and type, i.e. the same GL state (see RenderQueue::STATE_MASK).
+		Each mesh among them is one indirect command, and the whole batch goes out in one multi-draw call.
+		The commands occupy [firstCommand, firstCommand + commandCount) of the indirect buffer.
+	*/
+	struct DrawBatch {
+		ImageID image;
+		Core::ObjectType type;
+		GLuint firstCommand;
+		GLsizei commandCount;
+	};
+
+	/*  World-space AABBs of the objects, one array per component for the culling kernel */
+	struct WorldBoundsSoA {
+		std::vector<float> centerX, centerY, centerZ;
+		std::vector<float> halfX, halfY, halfZ;
+
+		void Resize(size_t size);
+		void Set(size_t idx, const Vec3& center, const Vec3& half);
+	};
+
 
 	//in OpenGL, a rendering context can only be active on one thread at a time, making multi - threading complex and potentially inefficient.The sequential nature of OpenGL's state machine also means that the order of operations is crucial, and multi-threading can disrupt this order, leading to unintended consequences in rendering outcomes.	
 	class Renderer {
 	public:
-		static constexpr int NUM_MAX_LIGHTS = 30;
+		static constexpr int NUM_MAX_LIGHTS = Scene::NUM_MAX_LIGHTS;
 	private:
 		std::unordered_map<ProgType, ShaderInfo> m_shaderFileMap;  // Central map for shader file paths
 		std::array <Shader, TO_INT(ProgType::NUM_PROGTYPES) > m_shaders;
+
+		/*  Every bind/uniform of the frame goes through here, so that no-op calls are dropped */
+		GLStateCache m_glState;
 		//custom deleter
 		std::unique_ptr<GLFWwindow, void(*)(GLFWwindow*)> m_window;// Pointer to the window
+
+		/*  Headless mode: no window nor GUI, the context comes from m_headlessContext and the light
+			pass draws into m_outputFBO (0, the window, otherwise). Chosen before the renderer is made.
+		*/
+		inline static bool s_headless{ false };
+		HeadlessContext m_headlessContext;
+		GLuint m_outputFBO{};
+		GLuint m_outputColorRBO{};
 		std::vector<int> m_guiToObjectIndexMap;
 
 		int m_sphereMirrorCubeMapFrameCounter;
+
+		/*  Time-sliced sphere cube map: a due refresh queues the faces whose content changed,
+			and at most m_sphereFacesPerFrame of them are rendered per frame, round-robin.
+		*/
+		int m_sphereFacesPerFrame{ 2 };
+		int m_sphereNextFace{};
+		std::array<bool, TO_INT(CubeFaceID::NUM_FACES)> m_sphereFacePending{};
+		std::array<bool, TO_INT(CubeFaceID::NUM_FACES)> m_sphereFaceStale{};    // something moved in it since it was rendered
+		std::array<bool, TO_INT(CubeFaceID::NUM_FACES)> m_sphereFaceRendered{}; // faces drawn this frame
+		std::array<Vec3, TO_INT(CubeFaceID::NUM_FACES)> m_sphereFaceCamPos{};   // sphere position each face was rendered from
 		float m_sphereRefIndex;
 		RefType m_sphereRef;          // Current reflection/refraction type for the objects
 
 		bool m_parallaxMappingOn;     // Toggle for parallax mapping
-		bool m_mirrorVisible;
+		bool m_compactGBuffer{ false }; // RGBA8 albedo + RG16 octahedral normal, position rebuilt from depth
+		bool m_mirrorVisible{ false };   // faces the main camera and is in its frustum
 		bool m_shouldUpdateCubeMapForSphere;
 		//deferred light
 		//deferred geom
@@ -89,11 +214,51 @@ namespace Rendering {
 		/******************************************************************************/
 
 		/*  Matrices for view/projetion transformations */
+		std::vector<ObjectMatrices> m_objectMatrices; // same order as scene.m_objects
+		WorldBoundsSoA m_objectBounds;                // same order as scene.m_objects
+
+		/*  Model-view matrices of every pass: slab s, object i lives at [s * m_mvSlabSize + i] */
+		std::vector<ObjectMVMatrices> m_mvMatrices;
+		std::vector<uint64_t> m_mvMatrixVersions;   // model version each entry was built from
+		std::vector<float> m_mvSlabVisibility;      // 1 when the object's box touches the slab camera's frustum and is not occluded, 0 when culled
+		std::array<MVSlabView, TO_INT(MVSlabID::NUM_SLABS)> m_mvSlabViews;
+		size_t m_mvSlabSize;
+		bool m_mvMatricesDirty;                     // a matrix or a culling plane changed since the batches were built
+
+		/*  Software occlusion culling: the occluder objects are rasterized on the CPU from each slab camera,
+			and the objects hidden behind them are culled from the slab like frustum-culled ones.
+			One buffer per slab, so that the slabs are culled in parallel.
+		*/
+		static constexpr size_t MAX_OCCLUDER_TRIANGLES = 512;
+		bool m_occlusionCullingOn{ true };
+		std::vector<OccluderMesh> m_occluderMeshes;     // per mesh drawID, its largest triangles
+		std::array<OcclusionBuffer, TO_INT(MVSlabID::NUM_SLABS)> m_occlusionBuffers;
+		std::array<int, TO_INT(MVSlabID::NUM_SLABS)> m_numOccludedObjects{};
+
+		/*  Instanced drawing: the visible entries of every active slab, regrouped into batches */
+		std::array<std::vector<DrawBatch>, TO_INT(MVSlabID::NUM_SLABS)> m_drawBatches;
+		std::vector<DrawElementsIndirectCommand> m_drawCommands;
+		std::vector<ObjectMVMatrices> m_instanceMatrices;
+		RenderQueue m_renderQueue;                  // visible objects of all active slabs, sorted by state
+		unsigned m_batchedSlabMask;                 // slabs the current batches were built for
+		GLuint m_instanceBuffer;                    // GPU copy of m_instanceMatrices, bound as instanced attributes
+		size_t m_instanceBufferSize;
+		GLuint m_drawIndirectBuffer;                // GPU copy of m_drawCommands
+		size_t m_drawIndirectBufferSize;
+
+		/*  Every mesh packed into one vertex/index buffer pair, behind one VAO */
+		GLuint m_meshVAO;
+		GLuint m_meshVBO;
+		GLuint m_meshIBO;
+
+		/*  glMultiDrawElementsIndirect is GL 4.3 (or ARB_multi_draw_indirect), above what glad was generated for.
+			Loaded at start-up when available; otherwise the commands go out one glDrawElementsIndirect at a time.
+		*/
+		GLFWglproc m_multiDrawElementsIndirect;
+
 		/*  Viewer camera */
 		Mat4 m_mainCamViewMat;
 		Mat4 m_mainCamProjMat;
-		std::unordered_map<int, Mat4> m_mainCamMVMat;
-		std::unordered_map<int, Mat4> m_mainCamNormalMVMat;
 
 		/*  For clearing depth buffer */
 		GLfloat one = 1.0f;
@@ -159,11 +324,7 @@ namespace Rendering {
 		};
 
 		/* (1) deferred geometry Locs */
-		GLuint m_gMVMatLoc;
-		GLuint m_gNMVMatLoc;
 		GLuint m_gProjMatLoc;
-		GLuint m_gNumLightsLoc;
-		GLuint m_gAmbientLoc;
 		GLuint m_gObjectTypeLoc;
 		GLuint m_gNormalMappingOnLoc;
 		GLuint m_gForwardRenderOnLoc;
@@ -171,18 +332,16 @@ namespace Rendering {
 		GLuint m_gColorTexLoc;
 		GLuint m_gNormalTexLoc;
 		GLuint m_gBumpTexLoc;
-		GLuint m_gSpecularPowerLoc;
-		GLuint m_gLightPosVFLoc[NUM_MAX_LIGHTS];
-		GLuint m_gDiffuseLoc[NUM_MAX_LIGHTS];
-		GLuint m_gSpecularLoc[NUM_MAX_LIGHTS];
-		GLuint m_gLightcolorLoc[NUM_MAX_LIGHTS];
+		GLuint m_gCompactGBufferLoc;
 		int m_gLightPassDebug = 0;
 		bool m_gBlinnPhongLighting = true;
 
 		/* (2) deferred light Locs */
 		GLuint m_lLightPassQuadLoc;
 		GLuint m_lLightPassDebugLoc;
-		GLuint m_lLightSpaceMatLoc;
+		GLuint m_lShadowMatsLoc;          // per atlas tile, view frame to the light clip space the tile was rendered with
+		GLuint m_lShadowRectsLoc;         // per atlas tile, uv offset in xy and scale in zw
+		GLuint m_lPrimaryShadowSlotLoc;   // tile of the most important light that has one, -1 if none
 		GLuint m_lColorTexLoc;
 		GLuint m_lNormalMappingObjTypeLoc;
 		GLuint m_lPosTexLoc;
@@ -190,15 +349,39 @@ namespace Rendering {
 		GLuint m_lTanTexLoc;
 		GLuint m_lDepthTexLoc;
 		GLuint m_lShadowDepthTexLoc;
-		GLuint m_lNumLightsLoc;
-		GLuint m_lAmbientLoc;
-		GLuint m_lSpecularPowerLoc;
 		GLuint m_lParallaxMappingOnLoc;
 		GLuint m_lBlinnPhongLightingLoc;  // 1 for active, 0 for inactive
-		GLuint m_lLightPosVFLoc[NUM_MAX_LIGHTS];
-		GLuint m_lDiffuseLoc[NUM_MAX_LIGHTS];
-		GLuint m_lSpecularLoc[NUM_MAX_LIGHTS];
-		GLuint m_lLightcolorLoc[NUM_MAX_LIGHTS];
+		GLuint m_lCompactGBufferLoc;
+		GLuint m_lInvProjMatLoc;          // to rebuild view-frame positions from depth in the compact layout
+
+		/*  Light data shared by the geometry and light pass programs, laid out as the std140
+			"LightBlock" uniform block of the deferred shaders (whose NUM_MAX_LIGHTS must match ours).
+			Refilled from the scene and uploaded once per frame.
+		*/
+		struct alignas(16) LightBlock {
+			Vec4 ambient;
+			GLint numLights;
+			GLint specularPower;
+			GLint pad[2];
+			Vec4 lightPosVF[NUM_MAX_LIGHTS];    // view frame, w = radius of influence
+			Vec4 diffuse[NUM_MAX_LIGHTS];
+			Vec4 specular[NUM_MAX_LIGHTS];
+			GLint shadowSlot[NUM_MAX_LIGHTS];   // shadow atlas tile, -1 for none; ivec4[NUM_MAX_LIGHTS / 4] in the shaders
+		};
+		static constexpr GLuint LIGHT_BLOCK_BINDING = 0;
+		LightBlock m_lightBlock;
+		GLuint m_lightUBO;
+
+		/*  Per-cluster light lists of the main camera, read by the light pass from two texture buffers:
+			ranges as (offset, count) pairs in GL_RG32UI, light indices in GL_R32UI.
+		*/
+		LightClusters m_lightClusters;
+		GLuint m_clusterRangeBuffer, m_clusterRangeTex;
+		GLuint m_clusterIndexBuffer, m_clusterIndexTex;
+		GLuint m_lClusterRangeTexLoc;
+		GLuint m_lClusterIndexTexLoc;
+		GLuint m_lClusterSliceScaleLoc;
+		GLuint m_lClusterSliceBiasLoc;
 
 		//(3) sphere mirror
 		GLint m_sphereMVMatLoc, m_sphereNMVMatLoc, m_sphereProjMatLoc, m_sphereViewMatLoc;  /*  used for sphere program */
@@ -208,16 +391,63 @@ namespace Rendering {
 
 		/*  Sphere cameras - we need 6 of them to generate the texture cubemap */
 		Mat4 m_sphereCamProjMat;
-		std::unordered_map<int, Mat4> m_sphereCamViewMat;
-		std::unordered_map<int, std::array<Mat4, TO_INT(CubeFaceID::NUM_FACES)>> m_sphereCamMVMat;
-		std::unordered_map<int, std::array<Mat4, TO_INT(CubeFaceID::NUM_FACES)>> m_sphereCamNormalMVMat;
+		Vec3 m_sphereCamPos;
+		std::array<Mat4, TO_INT(CubeFaceID::NUM_FACES)> m_sphereCamViewMat;
+
+		/*  Persistent target of the sphere cube map passes. The faces of the cube map are attached
+			in turn, unless the driver cannot render to them (incomplete FBO): then every face is
+			rendered into m_sphereFaceTexID and copied over through m_sphereFacePBO, on the GPU.
+		*/
+		GLuint m_sphereCubeFBO;
+		GLuint m_sphereCubeDepthRBO;
+		bool m_sphereCubeDirect;
+		GLuint m_sphereFaceTexID;
+		GLuint m_sphereFacePBO;
+
+		/*  Frame capture: the lit frame is queued for readback every frame while enabled */
+		AsyncReadback m_frameReadback;
+		bool m_frameCaptureOn{ false };
+		std::uint64_t m_frameIndex{};
+
+		/*  GPU time of each pass (sphere cube map, mirror, geometry, shadow map, light), the passes
+			together giving the GPU time of the frame
+		*/
+		GpuProfiler m_gpuProfiler;
+
+		/*  Dynamic resolution: the G-buffer is rendered into its lower-left m_renderWidth x m_renderHeight
+			part and the light pass stretches that over the screen. The scale comes from m_dynamicResolution,
+			fed with the GPU time of the frames as m_gpuProfiler reads it back, a couple of frames late, and
+			the CPU time of Render(). The mirror texture size and the mip level the sphere cube map is
+			rendered to follow the scale.
+		*/
+		static constexpr int SPHERE_CUBE_MAX_LEVEL = 2;
+		DynamicResolution m_dynamicResolution;
+		bool m_dynamicResolutionOn{ true };
+		float m_renderScale{ 1.f };
+		bool m_renderScaleChanged{ false };
+		int m_renderWidth{};
+		int m_renderHeight{};
+		float m_gpuFrameMs{};
+		float m_cpuFrameMs{};
+		int m_sphereCubeLevel{};     // mip level of the sphere cube map rendered to, and its base level
+		GLuint m_lGBufferScaleLoc;
 
 		//(4) planar mirror
 		/*  Mirror camera */
 		Mat4 m_mirrorCamViewMat;
 		Mat4 m_mirrorCamProjMat;
-		std::unordered_map<int, Mat4> m_mirrorCamMVMat;
-		std::unordered_map<int, Mat4> m_mirrorCamNormalMVMat;
+
+		/*  The mirror texture is only re-rendered when its camera changed or when something moved
+			inside the frustum it was rendered with, and only into its lower-left m_mirrorTexSize^2
+			corner, sized after the area the mirror covers on screen.
+		*/
+		static constexpr int MIRROR_MIN_TEX_SIZE = 64;
+		int m_mirrorTexSize{ MIRROR_MIN_TEX_SIZE };  // mirrorCam.width at most
+		bool m_mirrorTexStale{ true };
+		bool m_mirrorTexRendered{ false };          // this frame, for the GUI
+		Vec4 m_mirrorTexPlanes[6]{};                // world-space frustum of the last rendered texture
+		Mat4 m_mirrorModelMat{ 0.f };               // mirror model matrix the mirror camera was computed from
+		GLuint m_gMirrorTexScaleLoc;
 
 		//(5) skybox
 		GLint m_skyboxViewMatLoc;                             /*  used for skybox program */
@@ -228,17 +458,42 @@ namespace Rendering {
 		GLuint m_shadowMapFBO;
 		GLuint m_sShdowMapDepthTexID;
 
+		/*  The shadow map is an atlas holding one tile per shadowed light, laid out by m_shadowAtlas.
+			At most m_shadowUpdatesPerFrame tiles are re-rendered per frame, the others keep their depth.
+		*/
+		ShadowAtlas m_shadowAtlas;
+		std::vector<float> m_shadowImportance;      // per light, ShadowAtlas::ScreenImportance()
+		int m_shadowUpdatesPerFrame{ 4 };
+		int m_numShadowTilesRendered{};
+
+		/*  Static shadow layer: objects that have not moved for SHADOW_STATIC_AFTER_FRAMES frames,
+			rendered into their own atlas, per tile only when its light or that set of objects changes.
+			A re-rendered tile is copied from there and the moving casters are drawn on top.
+			A light that moved since its tile was last rendered gets every caster drawn straight into
+			the atlas instead, since its static layer would be stale by the next update anyway.
+			The lights only stand still while their orbit is paused (m_lightsOrbiting).
+		*/
+		static constexpr uint64_t SHADOW_STATIC_AFTER_FRAMES = 30;
+		GLuint m_shadowStaticFBO{};
+		GLuint m_sShadowStaticDepthTexID{};
+		std::vector<char> m_shadowStaticCaster;     // per object, whether it is in the static layer
+		std::vector<float> m_shadowCasterVisible;   // per object, 1 when its box touches the light frustum
+		int m_numStaticShadowCasters{};
+		int m_numDynamicShadowCasters{};
+		int m_numShadowStaticTilesRedrawn{};
+		bool m_lightsOrbiting{ true };
+
 	private:
 		void InitImGui();
 		void InitRendering();
 
-		void UpdateNumLights(int numLights);
 		// Function to update the mapping when objects are added/removed
 		void UpdateGuiToObjectIndexMap(const Core::Scene& scene);
 
 		// Function to update light positions
 		void UpdateOrbitalLights(Core::Scene& scene, float dt);
 
+		void UseProgram(ProgType type) { m_glState.UseProgram(m_shaders[TO_INT(type)].GetProgramID()); }
 		void RenderSkybox(const Mat4& viewMat);
 		void RenderObj(const Core::Object& obj);
 		void RenderSphere(const Scene& scene);
@@ -249,18 +504,30 @@ namespace Rendering {
 		void RenderToMirrorTexture(const Scene& scene);
 		void RenderToScreen(const Scene& scene);
 		void RenderGui(Scene& scene, float fps);
-		void RenderGeometryPass(const Scene& scene, float fps);
+		void RenderGeometryPass(const Scene& scene, bool updateSphereCubemap);
 		void RenderLightPass(const Scene& scene);
 		void RenderShadowMap(Scene& scene);
 
-		void ComputeMainCamObjMVMats(const Core::Scene& scene);
-		void ComputePlanarMirrorCamObjMVMats(const Core::Scene& scene);
-		void ComputeSphericalMirrorCamObjMVMats(int faceIdx, const Core::Scene& scene);
+		void UpdateObjectMatrices(const Core::Scene& scene);
+		void SetMVSlabView(MVSlabID slab, const Mat4& viewMat, const Mat4& projMat, bool viewChanged);
+		bool ComputeObjMVMats(MVSlabID slab, size_t begin, size_t end);
+		void ComputeAllObjMVMats();
+		void OcclusionCullSlab(MVSlabID slab);
+		void BuildDrawBatches(const Core::Scene& scene);
+		void UploadDrawData();
+		static bool IsDrawnInSlab(Core::ObjectType type, MVSlabID slab);
+		GLuint GetMVMatrixIdx(MVSlabID slab, int objIdx) const { return static_cast<GLuint>(TO_INT(slab) * m_mvSlabSize + objIdx); }
+		bool IsInFrustum(MVSlabID slab, int objIdx) const { return m_mvSlabVisibility[GetMVMatrixIdx(slab, objIdx)] != 0.f; }
 		void ComputeMainCamMats(const Scene& scene);
 		void ComputeMirrorCamMats(const Scene& scene);
+		bool UpdateMirrorTexSize(const Scene& scene);
+		void UpdateRenderScale();
 		void ComputeSphereCamMats(const Scene& scene);
 		
-		void SendLightColors(Scene& scene, int lightIdx=0);
+		void SetUpLightBlock();
+		void UploadLightBlock(const Scene& scene);
+		void SetUpLightClusters();
+		void UpdateLightClusters(const Scene& scene);
 		void SendDeferredLightPassProperties(const Scene& scene);
 		void SendDeferredGeomProperties(const Scene& scene);
 		
@@ -270,13 +537,23 @@ namespace Rendering {
 		void SetUpDeferredLightUniformLocations();
 		void SetUpShadowMappingUniformLocations();
 
-		void SetUpVertexData(Mesh& mesh);
+		void SetUpMeshBuffers();
+		void LoadMultiDrawIndirect();
 		void SetUpShaders();
 		void SetUpDeferredGeomPassTextures();
+		void DeleteDeferredGeomPassTextures();
 		void SetUpLightPassQuads();
 		void SetUpShadowMappingTextures();
+		void SetUpSphereCubeMapTarget();
+		void SetUpOutputTarget();
+		void GetOutputSize(int& width, int& height) const;
+		GLFWglproc GetProcAddress(const char* name) const;
+		void CaptureFrame();
 
 		bool ShouldUpdateSphereCubemap(float speedSqrd, float fps);
+		bool SelectSphereCubeFaces(const Scene& scene, float fps);
+		void MarkSphereFacesStale(const Vec3& center, const Vec3& half);
+		void MarkMirrorTexStale(const Vec3& center, const Vec3& half);
 		// GLFW's window handling doesn't directly support smart pointers since the GLFW API is a C API that expects raw pointers. 
 		// therefore, provided a custom deleter for the std::unique_ptr to properly handle GLFW window destruction.
 		static void WindowDeleter(GLFWwindow* window);
@@ -285,6 +562,7 @@ namespace Rendering {
 		Renderer();
 
 		static Renderer& GetInstance();
+		static void SetHeadless(bool headless) { s_headless = headless; }   // before the first GetInstance()
 		static void Resize(GLFWwindow* window, int width, int height);
 
 		//(rule of 5)
@@ -302,14 +580,28 @@ namespace Rendering {
 		void AttachScene(const Scene& scene);
 		void Render(Scene& scene, float fps, float dt);
 
-		bool ShouldClose()const { return glfwWindowShouldClose(m_window.get()); }
+		bool ShouldClose()const { return m_window && glfwWindowShouldClose(m_window.get()); }
 		void CleanUp();
 
 		// Getter and setters
 		bool& GetParallaxMapping() { return m_parallaxMappingOn; }
+		const GLStateStats& GetGLStateStats() const { return m_glState.GetLastFrameStats(); }
 		int GetSphereRef() const { return TO_INT(m_sphereRef); }
 		GLFWwindow* GetWindow() const;
 
+		/*  Frames come out of PollCapturedFrame about two frames after they were rendered */
+		void SetFrameCapture(bool on) { m_frameCaptureOn = on; }
+		bool PollCapturedFrame(AsyncReadback::Frame& frame, bool wait = false) { return m_frameReadback.Poll(frame, wait); }
+
+		/*  Per-pass GPU times of the frames profiled so far, one row per frame */
+		const ProfileLog& GetGpuProfile() const { return m_gpuProfiler.GetLog(); }
+		bool ExportGpuProfile(const std::string& path) const { return m_gpuProfiler.GetLog().WriteCsv(path); }
+
+		bool IsHeadless() const { return s_headless; }
+		void SetDynamicResolution(bool on) { m_dynamicResolutionOn = on; }
+		void SetLightsOrbiting(bool on) { m_lightsOrbiting = on; }
+		void WaitForGpu() const;
+
 		void SetParallaxMapping(bool on) { m_parallaxMappingOn = on; }
 		void SetSphereRef(RefType type) { m_sphereRef = type; }
 		void Reset();
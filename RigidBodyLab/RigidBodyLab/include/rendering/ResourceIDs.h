@@ -0,0 +1,39 @@
+#pragma once
+
+namespace Rendering {
+
+	/*  Pre-defined shapes: big flat cube, horizontal cube, vertical cube, sphere */
+	enum class MeshID {
+		SPHERE=0,
+		CUBE,
+		VASE,
+		TEAPOT,
+		DIAMOND,
+		GOURD,
+		DODECAHEDRON,
+		PLANE,
+		CAT,
+		GIRL_RIGHTY,
+		//GIRL_LEFTY,
+		GRIM_REAPER_LEFTY,
+		//GRIM_REAPER_RIGHTY,
+		NUM_MESHES
+	};
+
+	/*  The ID for texture loading */
+	enum class ImageID
+	{
+		STONE_TEX_1 = 0,
+		STONE_TEX_2,
+		WOOD_TEX_1,
+		WOOD_TEX_2,
+		POTTERY_TEX_1,
+		POTTERY_TEX_2,
+		POTTERY_TEX_3,
+		GRIM_REAPER_SKIN,
+		GIRL_SKIN,
+		MIRROR_TEX,
+		SPHERE_TEX,
+		NUM_IMAGES
+	};
+}
@@ -1,47 +1,15 @@
 #pragma once
 #include <array>
+#include <cstring>
+#include <GLFW/glfw3.h>
 #include <utilities/ToUnderlyingEnum.h>
-#include <rendering/Mesh.h>
+#include <rendering/ResourceIDs.h>
+#include <rendering/MeshLibrary.h>
 
 namespace Rendering {
 
 	class Object;
 
-	/*  Pre-defined shapes: big flat cube, horizontal cube, vertical cube, sphere */
-	enum class MeshID {
-		SPHERE=0,
-		CUBE,
-		VASE,
-		TEAPOT,
-		DIAMOND,
-		GOURD,
-		DODECAHEDRON,
-		PLANE,
-		CAT,
-		GIRL_RIGHTY,
-		//GIRL_LEFTY,
-		GRIM_REAPER_LEFTY,
-		//GRIM_REAPER_RIGHTY,
-		NUM_MESHES
-	};
-
-	/*  The ID for texture loading */
-	enum class ImageID
-	{
-		STONE_TEX_1 = 0,
-		STONE_TEX_2,
-		WOOD_TEX_1,
-		WOOD_TEX_2,
-		POTTERY_TEX_1,
-		POTTERY_TEX_2,
-		POTTERY_TEX_3,
-		GRIM_REAPER_SKIN,
-		GIRL_SKIN,
-		MIRROR_TEX,
-		SPHERE_TEX,
-		NUM_IMAGES
-	};
-
 	/*  6 faces of the texture cube */
 	enum class CubeFaceID {
 		RIGHT = 0, LEFT, TOP, BOTTOM, BACK, FRONT, NUM_FACES
@@ -50,11 +18,9 @@ namespace Rendering {
 
     class ResourceManager {
 
-		std::array<std::unique_ptr<Mesh>, TO_INT(MeshID::NUM_MESHES)> m_meshes;
+		MeshLibrary m_meshLibrary;
 		std::array<GLuint, TO_INT(ImageID::NUM_IMAGES)> m_textureIDs;
 
-		std::unique_ptr<unsigned char[]> m_sphereCubeMapData[TO_INT(CubeFaceID::NUM_FACES)];
-
 		GLuint m_bumpTexID, m_normalTexID;
 		GLuint m_skyboxTexID;
 		/*  For generating sphere "reflection/refraction" texture */
@@ -106,25 +72,13 @@ namespace Rendering {
         ResourceManager();
 		static ResourceManager& GetInstance();
 
-		Mesh* ResourceManager::GetMesh(MeshID id);
-		const Mesh* ResourceManager::GetMesh(MeshID id) const;
-		void ResourceManager::SetMesh(MeshID id, std::unique_ptr<Mesh> newMesh);
+		Mesh* GetMesh(MeshID id) { return m_meshLibrary.GetMesh(id); }
+		const Mesh* GetMesh(MeshID id) const { return m_meshLibrary.GetMesh(id); }
+		void SetMesh(MeshID id, std::unique_ptr<Mesh> newMesh) { m_meshLibrary.SetMesh(id, std::move(newMesh)); }
+		const MeshLibrary& GetMeshLibrary() const { return m_meshLibrary; }
 		GLuint GetTexture(ImageID id);
 		void SetUpTextures();
     private:
-		/**
-		 * Initializes the cube map texture data for the spherical mirror.
-		 * This function allocates memory for each face of the cube map (unique_ptr),
-		 * based on the size specified for the skybox. It should be called
-		 * after the skybox texture is set up, ensuring that the skybox size
-		 * is correctly initialized before allocating memory for the spherical
-		 * mirror's cube map texture.
-		 *
-		 * Each face of the cube map is allocated memory equivalent to
-		 * the skybox face size, with each pixel occupying 4 bytes (presumably for RGBA).
-		 */
-		void InitSphericalMirrorTexture();
-
 		void SetUpObjTextures();
 		void SetUpBaseBumpNormalTextures();
 		void SetTextureParameters(GLenum textureType);
@@ -132,6 +86,11 @@ namespace Rendering {
 		void SetUpSkyBoxTexture();
 		void SetUpSeparateSkyBoxTexture();
 
+		/**
+		 * Allocates the cube map the spherical mirror's reflection is rendered into.
+		 * Must be called after the skybox texture is set up, since the faces have the
+		 * skybox face size.
+		 */
 		void SetUpSphereCubeMapTexture();
 
 		void CopySubTexture(unsigned char* destTex, const unsigned char* srcTex,
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <math/Math.h>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering
+{
+    /*  Layout and refresh schedule of the shadow atlas, on the CPU.
+        The shadow maps of up to MAX_SHADOWED_LIGHTS lights share one ATLAS_SIZE^2 depth texture.
+        Every frame, Plan():
+            - ranks the lights by screen-space importance (the size of their sphere of influence
+              on screen) and keeps the most important ones,
+            - gives each a square power-of-two tile between MIN_TILE_SIZE and MAX_TILE_SIZE,
+              shrinking the least important tiles until they all fit,
+            - packs the tiles largest first in Morton order, which leaves no holes,
+            - picks at most updateBudget tiles to re-render this frame: tiles that moved first,
+              then the ones with the largest importance * frames since their last update.
+        The other tiles keep the depth they were last rendered with, and must be looked up with
+        the light matrix of that time (Tile::renderedMat), so that stale shadows stay consistent.
+    */
+    class ShadowAtlas
+    {
+    public:
+        static constexpr int ATLAS_SIZE = 4096;
+        static constexpr int MAX_TILE_SIZE = 2048;
+        static constexpr int MIN_TILE_SIZE = 256;
+        static constexpr int MAX_SHADOWED_LIGHTS = 16;
+
+        struct Tile {
+            int light{ -1 };
+            int x{}, y{}, size{};
+            float importance{};
+            bool rendered{};            // holds a shadow map, made with renderedMat
+            Mat4 renderedMat{ 0.f };
+            std::uint64_t renderedFrame{};
+            bool staticValid{};         // the static layer of the tile was made with staticMat
+            Mat4 staticMat{ 0.f };
+        };
+
+        static float ScreenImportance(const Vec4& lightSphereVF, const Mat4& projMat, float nearPlane);
+
+        void Plan(const float* importance, int numLights, int updateBudget);
+        void MarkRendered(int tileIdx, const Mat4& lightSpaceMat);
+        void InvalidateStatic();
+
+        /*  Tiles in decreasing importance; the tile of a light is its shadow slot */
+        std::vector<Tile>& GetTiles() { return m_tiles; }
+        const std::vector<Tile>& GetTiles() const { return m_tiles; }
+        const std::vector<int>& GetUpdates() const { return m_updates; }
+
+    private:
+        std::vector<Tile> m_tiles;
+        std::vector<Tile> m_prevTiles;
+        std::vector<int> m_order;
+        std::vector<int> m_updates;         // tiles to render this frame
+        std::uint64_t m_frame{};
+    };
+}
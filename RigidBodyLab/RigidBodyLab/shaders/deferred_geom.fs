@@ -2,7 +2,19 @@
 
 //#extension GL_ARB_explicit_uniform_location : require
 
-#define MAX_LIGHTS 10
+#define MAX_LIGHTS 10           // lights with a tangent-space direction for the normal mapped plane
+
+// Lights, shared with the light pass through one uniform buffer (Renderer::LightBlock)
+#define NUM_MAX_LIGHTS 256      // must match Renderer::NUM_MAX_LIGHTS
+layout(std140) uniform LightBlock {
+    vec4 ambient;
+    int numLights;
+    int specularPower;
+    vec4 lightPosVF[NUM_MAX_LIGHTS];    /*  light pos already in view frame, w = radius of influence */
+    vec4 diffuse[NUM_MAX_LIGHTS];
+    vec4 specular[NUM_MAX_LIGHTS];
+    ivec4 shadowSlots[NUM_MAX_LIGHTS / 4];  /*  shadow atlas tile of light i in [i / 4][i % 4], -1 for none */
+};
 
 in vec3 vPos;   
 in vec3 vNormal;
@@ -20,24 +32,32 @@ uniform sampler2D bumpTex;
 uniform bool normalMappingOn;
 uniform bool parallaxMappingOn;
 uniform bool forwardRenderOn;
-
-uniform int numLights;
-uniform int specularPower;  
-
-uniform vec4 ambient;
-uniform vec4 diffuse[MAX_LIGHTS];
-uniform vec4 specular[MAX_LIGHTS];
+uniform bool compactGBuffer;    // RGBA8 color with the object type in alpha, RG16 octahedral normal, no position
+uniform float mirrorTexScale;   // the planar mirror texture is only rendered in its lower-left mirrorTexScale^2 corner
 
 layout (location = 0) out vec4 fragColor;
 layout (location = 1) out vec3 fragPos;
 layout (location = 2) out vec4 fragNrm;
 layout (location = 3) out float fragDepth;
 
+// Unit vector to the [-1, 1]^2 square: project onto the octahedron |x|+|y|+|z| = 1 and fold the lower half over
+vec2 OctEncode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;
+}
+
 void main(void) {
     fragPos = vPos;
     fragDepth = gl_FragCoord.z;
 
-    fragColor = texture(colorTex, vUV);        
+    if (vFragObjType > 0.2 && vFragObjType < 0.3) {    // planar mirror, kept off the texels outside its corner
+        vec2 halfTexel = 0.5 / vec2(textureSize(colorTex, 0));
+        fragColor = texture(colorTex, clamp(vUV * mirrorTexScale, halfTexel, vec2(mirrorTexScale) - halfTexel));
+    }
+    else {
+        fragColor = texture(colorTex, vUV);
+    }
 
     vec3 N = vNormal;
     vec3 V = normalize(vViewDir); 
@@ -70,7 +90,7 @@ void main(void) {
 
       vec4 intensity = ambient;
       
-      for (int i = 0; i < numLights; ++i){                                                                                      
+      for (int i = 0; i < min(numLights, MAX_LIGHTS); ++i){                                                                                      
 
         vec3 L = normalize(vLightDir[i]);                                                     
         vec3 H = normalize(L+V);     
@@ -82,5 +102,11 @@ void main(void) {
       fragColor *= intensity;
     }           
 
-    fragNrm = vec4(N, vFragObjType);
+    if (compactGBuffer) {
+        fragColor.a = vFragObjType;
+        fragNrm = vec4(OctEncode(normalize(N)) * 0.5 + 0.5, 0.0, 0.0);
+    }
+    else {
+        fragNrm = vec4(N, vFragObjType);
+    }
 }
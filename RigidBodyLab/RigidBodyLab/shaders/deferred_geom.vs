@@ -1,14 +1,22 @@
 #version 330 core
 
-#define MAX_LIGHTS 10
+#define MAX_LIGHTS 10           // lights with a tangent-space direction for the normal mapped plane
+
+// Lights, shared with the light pass through one uniform buffer (Renderer::LightBlock)
+#define NUM_MAX_LIGHTS 256      // must match Renderer::NUM_MAX_LIGHTS
+layout(std140) uniform LightBlock {
+    vec4 ambient;
+    int numLights;
+    int specularPower;
+    vec4 lightPosVF[NUM_MAX_LIGHTS];    /*  light pos already in view frame, w = radius of influence */
+    vec4 diffuse[NUM_MAX_LIGHTS];
+    vec4 specular[NUM_MAX_LIGHTS];
+    ivec4 shadowSlots[NUM_MAX_LIGHTS / 4];  /*  shadow atlas tile of light i in [i / 4][i % 4], -1 for none */
+};
 
 // Uniforms and layout locations
-uniform mat4 mvMat;  // Model-view matrix
-uniform mat4 nmvMat; // Normal model-view matrix
 uniform mat4 projMat; // Projection matrix
 uniform bool normalMappingOn;
-uniform int  numLights;
-uniform vec3 lightPosVF[MAX_LIGHTS];    /*  light pos already in view frame */
 uniform float  objType;      //0   : regular deferred object
                              //1/4 : planar mirror
                              //2/4 : spherical mirror
@@ -19,6 +27,8 @@ layout(location = 1) in vec3 nrm;
 layout(location = 2) in vec3 tan;
 layout(location = 3) in vec3 bitan;
 layout(location = 4) in vec2 uv; // Include UV coordinates
+layout(location = 5) in mat4 mvMat;  // Model-view matrix (per instance, locations 5-8)
+layout(location = 9) in mat4 nmvMat; // Normal model-view matrix (per instance, locations 9-12)
 
 out vec3 vPos;
 out vec3 vNormal;
@@ -46,8 +56,8 @@ void main() {
 
         vViewDir = toTBN * vViewDir;                        //'V' (in TBN space)
 
-        for (int i = 0; i < numLights; ++i) {
-            vLightDir[i] = lightPosVF[i] - vPos; //'L' (in the cam space)
+        for (int i = 0; i < min(numLights, MAX_LIGHTS); ++i) {
+            vLightDir[i] = lightPosVF[i].xyz - vPos; //'L' (in the cam space)
             vLightDir[i] = toTBN * vLightDir[i];              //'L' (in TBN space) 
         }
     }
@@ -9,18 +9,42 @@ uniform sampler2D colorTex;
 uniform sampler2D depthTex;
 uniform sampler2D shadowMapDepthTex;
 
-// Light properties
-#define MAX_LIGHTS 10
-uniform vec3 lightPosVF[MAX_LIGHTS];
-uniform vec4 ambient;
-uniform vec4 diffuse[MAX_LIGHTS];
-uniform vec4 specular[MAX_LIGHTS];
+// Lights, shared with the geometry pass through one uniform buffer (Renderer::LightBlock)
+#define NUM_MAX_LIGHTS 256      // must match Renderer::NUM_MAX_LIGHTS
+layout(std140) uniform LightBlock {
+    vec4 ambient;
+    int numLights;
+    int specularPower;
+    vec4 lightPosVF[NUM_MAX_LIGHTS];    /*  light pos already in view frame, w = radius of influence */
+    vec4 diffuse[NUM_MAX_LIGHTS];
+    vec4 specular[NUM_MAX_LIGHTS];
+    ivec4 shadowSlots[NUM_MAX_LIGHTS / 4];  /*  shadow atlas tile of light i in [i / 4][i % 4], -1 for none */
+};
+
+// Clustered lights (Rendering::LightClusters): the screen is split into CLUSTER_TILES_X * CLUSTER_TILES_Y tiles
+// and the view depth into exponential slices, slice = log(depth) * clusterSliceScale + clusterSliceBias.
+// Each cluster has an (offset, count) range into the light index list.
+#define CLUSTER_TILES_X 16      // must match LightClusters::TILES_X
+#define CLUSTER_TILES_Y 16      // must match LightClusters::TILES_Y
+#define CLUSTER_SLICES 24       // must match LightClusters::NUM_SLICES
+uniform usamplerBuffer clusterRangeTex;
+uniform usamplerBuffer clusterIndexTex;
+uniform float clusterSliceScale;
+uniform float clusterSliceBias;
+
+uniform bool compactGBuffer;    // no posTex, octahedral normal in nrmTex.rg, object type in colorTex.a
+uniform mat4 invProjMat;        // compact layout only
+uniform vec2 gBufferScale;      // part of the G-buffer textures the geometry pass rendered to, for dynamic resolution
+
 uniform bool parallaxMappingOn;
-uniform int numLights;
-uniform int specularPower;  
 uniform int blinnPhongLighting;  // 1 for active, 0 for inactive
 uniform int normalMappingObjType; // Object type for normal mapping
-uniform mat4 lightSpaceMat;
+
+// Shadow atlas (Rendering::ShadowAtlas): shadowMapDepthTex holds one tile per shadowed light
+#define MAX_SHADOW_TILES 16     // must match ShadowAtlas::MAX_SHADOWED_LIGHTS
+uniform mat4 shadowMats[MAX_SHADOW_TILES];  // view frame to the light clip space the tile was rendered with
+uniform vec4 shadowRects[MAX_SHADOW_TILES]; // uv offset of the tile in xy, scale in zw
+uniform int primaryShadowSlot;              // tile of the most important shadowed light, -1 if none
 
 in vec2 uvCoord;
 out vec4 fragColor;
@@ -30,6 +54,31 @@ out vec4 fragColor;
 //this means that for two objects that are equally spaced in the 3D world, the difference in their depth values will be smaller if they are far from the camera compared to if they are close.
 //since most of the depth values are concentrated near the near plane, most fragments will have depth values very close to 1.0.
 //therefore, this function maps the depth values such that they are more evenly distributed between the near and far planes.
+// View-frame position, read from the G-buffer or rebuilt from the depth buffer; uv is in screen space
+vec3 GetFragPos(vec2 uv, float depth) {
+    if (!compactGBuffer) {
+        return texture(posTex, uv * gBufferScale).xyz;
+    }
+    vec4 pos = invProjMat * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return pos.xyz / pos.w;
+}
+
+vec3 OctDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float fold = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -fold : fold, n.y >= 0.0 ? -fold : fold);
+    return normalize(n);
+}
+
+// Normal in xyz, object type in w
+vec4 GetNormalAndType(vec2 uv) {
+    if (!compactGBuffer) {
+        vec4 nrmPack = texture(nrmTex, uv * gBufferScale);
+        return vec4(normalize(nrmPack.xyz), nrmPack.w);
+    }
+    return vec4(OctDecode(texture(nrmTex, uv * gBufferScale).rg * 2.0 - 1.0), texture(colorTex, uv * gBufferScale).a);
+}
+
 float linearizeDepth(float depth) {
     float near = 0.005f; // Near plane distance
     float far = 10.f; // Far plane distance
@@ -60,11 +109,16 @@ float ShadowCalculation(vec4 fragPosLightSpace)
     //return closestDepth;
 }
 */
-float ShadowCalculation(vec4 fragPosLightSpace) {
+float ShadowCalculation(int slot, vec3 fragPos) {
+    vec4 fragPosLightSpace = shadowMats[slot] * vec4(fragPos, 1.0);
     // perform perspective divide
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     // transform to [0,1] range
     projCoords = projCoords * 0.5 + 0.5;
+    // outside of the light frustum, nothing was rendered for it
+    if (any(lessThan(projCoords, vec3(0.0))) || any(greaterThan(projCoords, vec3(1.0)))) {
+        return 0.0;
+    }
     float currentDepth = linearizeDepth(projCoords.z);
 
     
@@ -76,9 +130,15 @@ float ShadowCalculation(vec4 fragPosLightSpace) {
     const int kernelSize = 3;
     float texelSize = 1.0 / textureSize(shadowMapDepthTex, 0).x;
 
+    // atlas coordinates; the taps stay inside the tile so that they never read a neighbour
+    vec4 rect = shadowRects[slot];
+    vec2 atlasCoords = rect.xy + projCoords.xy * rect.zw;
+    vec2 tileMin = rect.xy + 0.5 * texelSize;
+    vec2 tileMax = rect.xy + rect.zw - 0.5 * texelSize;
+
     for(int x = -kernelSize / 2; x <= kernelSize / 2; ++x) {
         for(int y = -kernelSize / 2; y <= kernelSize / 2; ++y) {
-            float pcfDepth = texture(shadowMapDepthTex, projCoords.xy + vec2(x, y) * texelSize).r;
+            float pcfDepth = texture(shadowMapDepthTex, clamp(atlasCoords + vec2(x, y) * texelSize, tileMin, tileMax)).r;
             pcfDepth = linearizeDepth(pcfDepth);
             shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;
         }
@@ -90,18 +150,20 @@ float ShadowCalculation(vec4 fragPosLightSpace) {
 
 
 void main(void) {
-    float fragDepth = texture(depthTex, uvCoord).r;
+    // the G-buffer may be smaller than the screen: its texels are stretched over it (nearest), lighting stays per pixel
+    vec2 gBufferUV = uvCoord * gBufferScale;
+    float fragDepth = texture(depthTex, gBufferUV).r;
     if (lightPassDebug != 0) {
         // Handle non-lighting debug modes
         switch(lightPassDebug) {
             case 1: // COLOR
-                fragColor = texture(colorTex, uvCoord);
+                fragColor = texture(colorTex, gBufferUV);
                 break;
             case 2: // POSITION
-                fragColor = texture(posTex, uvCoord);
+                fragColor = vec4(GetFragPos(uvCoord, fragDepth), 1.0);
                 break;
             case 3: // NORMAL
-                fragColor = vec4(normalize(texture(nrmTex, uvCoord).xyz), 1.0);
+                fragColor = vec4(GetNormalAndType(uvCoord).xyz, 1.0);
                 break;                    
             case 4: // DEPTH
                 // Linearize the depth value for better visualization
@@ -131,10 +193,8 @@ void main(void) {
 
                 fragColor = vec4(vec3(depth),1.0);
                 */
-                vec3 fragPos = texture(posTex, uvCoord).xyz;
-                vec4 fragPosLightSpace = lightSpaceMat * vec4(fragPos, 1.0);        
-                float shadow = ShadowCalculation(fragPosLightSpace);      
-                //fragColor = fragPosLightSpace;
+                vec3 fragPos = GetFragPos(uvCoord, fragDepth);
+                float shadow = primaryShadowSlot >= 0 ? ShadowCalculation(primaryShadowSlot, fragPos) : 0.0;
                 fragColor =vec4(vec3(1.f-shadow),1.f);
                 
                 break;
@@ -142,35 +202,27 @@ void main(void) {
         }
     } else {
 
-        fragColor = texture(colorTex, uvCoord);
+        fragColor = texture(colorTex, gBufferUV);
 
         if (fragDepth >= 0.999f) { //background
             return;
         }
 
-        vec3 fragPos = texture(posTex, uvCoord).xyz;
-        vec4 nrmPack = texture(nrmTex, uvCoord);
-        vec3 normal = normalize(nrmPack.xyz);
+        vec3 fragPos = GetFragPos(uvCoord, fragDepth);
+        vec4 nrmPack = GetNormalAndType(uvCoord);
+        vec3 normal = nrmPack.xyz;
         vec3 viewDir = normalize(-fragPos);
         float objectType = nrmPack.w; //0   : regular deferred object
                                      //1/4 : planar mirror
                                      //2/4 : spherical mirror
                                      //3/4 : normal mapped plane                             
 
-        vec4 fragPosLightSpace = lightSpaceMat * vec4(fragPos, 1.0);        
-        float shadow = ShadowCalculation(fragPosLightSpace);      
-        //fragColor = fragPosLightSpace;
-        //fragColor =vec4(vec3(1.f-shadow),1.f);
-
-        //return;
-
-        // Calculate shadow factor: 0 for full shadow, 1 for fully lit
-        float shadowFactor = 1.0 - shadow;
-        
         //vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color; 
         vec4 intensity = ambient ;
 
         if (objectType > 0.7f) {// plane
+            // Calculate shadow factor: 0 for full shadow, 1 for fully lit
+            float shadowFactor = primaryShadowSlot >= 0 ? 1.0 - ShadowCalculation(primaryShadowSlot, fragPos) : 1.0;
             fragColor*=shadowFactor;
 
             return; //light already computed
@@ -179,21 +231,39 @@ void main(void) {
             intensity += vec4(0.27,0.27,0.27,1.f); //brighter (optional, for demonstration purposes)            
         }
 
-        for (int i = 0; i < numLights; ++i) {
-            vec3 lightDir = normalize(normalize(lightPosVF[i] - fragPos));
+        ivec2 tile = min(ivec2(uvCoord * vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y)), ivec2(CLUSTER_TILES_X - 1, CLUSTER_TILES_Y - 1));
+        int slice = clamp(int(floor(log(max(-fragPos.z, 1e-4)) * clusterSliceScale + clusterSliceBias)), 0, CLUSTER_SLICES - 1);
+        uvec2 range = texelFetch(clusterRangeTex, (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x).xy;
+
+        for (uint n = 0u; n < range.y; ++n) {
+            int i = int(texelFetch(clusterIndexTex, int(range.x + n)).r);
+            vec3 toLight = lightPosVF[i].xyz - fragPos;
+            vec3 lightDir = normalize(toLight);
+
+            // smooth falloff to 0 at the radius the light was clustered with
+            float distRatio = length(toLight) / lightPosVF[i].w;
+            float window = clamp(1.0 - distRatio * distRatio * distRatio * distRatio, 0.0, 1.0);
+            float lightFactor = window * window;
+
+            // every shadowed light has its own tile in the atlas
+            int shadowSlot = shadowSlots[i / 4][i % 4];
+            if (shadowSlot >= 0 && lightFactor > 0.0) {
+                lightFactor *= 1.0 - ShadowCalculation(shadowSlot, fragPos);
+            }
+
             //diffuse
-            intensity +=shadowFactor*diffuse[i]* max(dot(normal, lightDir), 0.0);
+            intensity +=lightFactor*diffuse[i]* max(dot(normal, lightDir), 0.0);
 
             //specular
             if(blinnPhongLighting==1){//blinn phong
                 vec3 H = normalize(lightDir+viewDir);
-                intensity += shadowFactor*specular[i]* pow(max(dot(H, normal), 0.0), specularPower);
+                intensity += lightFactor*specular[i]* pow(max(dot(H, normal), 0.0), specularPower);
             }
             else{//normal phong
                 vec3 reflectDir = reflect(-lightDir, normal);
-                intensity += shadowFactor*specular[i]* pow(max(dot(viewDir, reflectDir), 0.0), specularPower);
+                intensity += lightFactor*specular[i]* pow(max(dot(viewDir, reflectDir), 0.0), specularPower);
             }
-            fragColor *= intensity;
-        }        
+        }
+        fragColor *= intensity;
     }
 }
@@ -1,15 +1,20 @@
 #include <core/Application.h>
 #include <rendering/Renderer.h>
+#include <rendering/ResourceManager.h>
+#include <rendering/Camera.h>
 #include <utilities/Logger.h>
 #include <memory>
+#include <algorithm>
+#include <numeric>
+#include <vector>
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 
 using Rendering::Renderer;
 using namespace std::chrono;
 
-Application::Application()
-    :m_scene{}, m_prevTime{},m_currTime {  }, m_frameCount{}, m_secCount{}, m_deltaTime{}, m_fps{}, m_inputHandler{ std::make_unique<InputHandler>(m_scene) }
+Application::Application(const Options& options)
+    :m_options{ options }, m_scene{ Rendering::ResourceManager::GetInstance().GetMeshLibrary(), Rendering::mainCam.GetPos() }, m_prevTime{},m_currTime {  }, m_frameCount{}, m_secCount{}, m_deltaTime{}, m_fps{}, m_inputHandler{ std::make_unique<InputHandler>(m_scene) }
 {
     Logger::Log("Application initialized");
     Renderer::GetInstance().AttachScene(m_scene);
@@ -24,7 +29,14 @@ void Application::Run() {
     // sets a custom pointer to the GLFW window. This allows us to associate custom data 
     //(in this case, the "this" pointer of the Application instance) with the GLFW window. 
     // later, will retrieve this pointer in the GLFW callback functions to access application's state or methods.
-    glfwSetWindowUserPointer(renderer.GetWindow(), this);
+    if (renderer.GetWindow()) {
+        glfwSetWindowUserPointer(renderer.GetWindow(), this);
+    }
+
+    if (m_options.numFrames > 0) {
+        RunFrames(m_options.numFrames);
+        return;
+    }
 
     // instruction loop
     while (!m_gameStarted && !renderer.ShouldClose()) {
@@ -82,6 +94,72 @@ void Application::Run() {
     Logger::Log("Application Run Loop ended. Renderer and GLFW window finalized.");
 }
 
+
+/******************************************************************************/
+/*!
+\fn     void RunFrames(int numFrames)
+\brief
+        Benchmark run: skip the intro and the input, and render numFrames
+        frames back to back, each stepping the scene by FIXED_DT so that two
+        runs simulate the same frames. Dynamic resolution is off for the
+        same reason. Logs the frame time statistics, the GL calls issued and
+        skipped by the state cache, and the GPU time of each pass, and exports
+        the latter if a path was given.
+*/
+/******************************************************************************/
+void Application::RunFrames(int numFrames)
+{
+    Renderer& renderer = Renderer::GetInstance();
+    renderer.SetDynamicResolution(false);
+    Logger::Log("Rendering ", numFrames, renderer.IsHeadless() ? " frames headless" : " frames");
+
+    std::vector<double> frameMs;
+    frameMs.reserve(numFrames);
+    /*  The renderer holds the counters of the frame before the one it just rendered */
+    unsigned long long glIssued = 0, glSkipped = 0;
+    const auto runStart = high_resolution_clock::now();
+    for (int frame = 0; frame < numFrames && !renderer.ShouldClose(); ++frame) {
+        const auto frameStart = high_resolution_clock::now();
+        if (renderer.IsHeadless() == false) {
+            glfwPollEvents();
+        }
+        m_scene.Update(FIXED_DT);
+        renderer.Render(m_scene, 1 / FIXED_DT, FIXED_DT);
+        frameMs.push_back(duration<double, std::milli>(high_resolution_clock::now() - frameStart).count());
+        glIssued += renderer.GetGLStateStats().TotalIssued();
+        glSkipped += renderer.GetGLStateStats().TotalSkipped();
+    }
+    renderer.WaitForGpu();
+    const double runMs = duration<double, std::milli>(high_resolution_clock::now() - runStart).count();
+    if (frameMs.empty()) {
+        return;
+    }
+
+    std::vector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    const auto percentile = [&sorted](double p) { return sorted[static_cast<size_t>(p * (sorted.size() - 1))]; };
+    Logger::Log("Frames: ", frameMs.size(), ", ", runMs, " ms (", frameMs.size() * 1000.0 / runMs, " fps)");
+    Logger::Log("CPU frame ms: mean ", std::accumulate(frameMs.begin(), frameMs.end(), 0.0) / frameMs.size(),
+        ", median ", percentile(0.5), ", p95 ", percentile(0.95), ", max ", sorted.back());
+    if (frameMs.size() > 1) {
+        const double numCounted = static_cast<double>(frameMs.size() - 1);
+        Logger::Log("GL state calls per frame: ", glIssued / numCounted, " issued, ", glSkipped / numCounted, " skipped");
+    }
+
+    const Rendering::ProfileLog& gpuProfile = renderer.GetGpuProfile();
+    const size_t numProfiled = gpuProfile.GetNumFrames();
+    for (int pass = 0; pass < gpuProfile.GetNumPasses(); ++pass) {
+        Logger::Log("GPU ", gpuProfile.GetPassName(pass), " ms: mean ", gpuProfile.GetAverageMs(pass, numProfiled),
+            ", max ", gpuProfile.GetMaxMs(pass, numProfiled));
+    }
+    Logger::Log("GPU total ms: mean ", gpuProfile.GetAverageMs(Rendering::ProfileLog::TOTAL, numProfiled),
+        " over ", numProfiled, " frames");
+
+    if (m_options.gpuProfilePath.empty() == false && !renderer.ExportGpuProfile(m_options.gpuProfilePath)) {
+        Logger::Log("Error: cannot write the GPU profile to ", m_options.gpuProfilePath);
+    }
+}
+
 float Application::GetDeltaTime() const {
     return m_deltaTime;
 }
@@ -1,6 +1,7 @@
 #include <core/Object.h>
 #include <math/Math.h>
 #include <utilities/ToUnderlyingEnum.h>
+#include <algorithm>
 
 using namespace Rendering;
 
@@ -55,20 +56,31 @@ Mat4 Core::Object::GetModelMatrix() const {
 	(scale-rotate-translate, aka model to world) matrix as usual. The final matrix represents a composite transformation
 	from the object's local space to world space, incorporating position, orientation, scale, and physical bounds.
 	*/
+	// physics-only scenes have no mesh: the collider box is the model then
+	const Matrix4 boundingBoxMat = m_mesh != nullptr ? m_mesh->GetBoundingBoxMat() : Matrix4{};
+
 	if (IsDynamic()) {
 		// for dynamic objects, combine RigidBody's transformation with the collider's scale and mesh offset
 		return std::get<std::unique_ptr<RigidBody>>(m_physicsOrTransform)->GetLocalToWorldMatrix()
 			* m_collider->GetScaleMatrix()
-			* m_mesh->GetBoundingBoxMat();
+			* boundingBoxMat;
 	}
 	else {
 		// for static objects, combine Transform's transformation with the collider's scale and mesh offset
 		return std::get<Transform>(m_physicsOrTransform).m_localToWorld
 			* m_collider->GetScaleMatrix() 
-			* m_mesh->GetBoundingBoxMat();
+			* boundingBoxMat;
 	}
 }
 
+uint64_t Core::Object::GetModelVersion() const {
+	// versions are drawn from one increasing counter, so the newer of the two identifies the current state
+	const uint64_t transformVersion = IsDynamic()
+		? std::get<std::unique_ptr<RigidBody>>(m_physicsOrTransform)->GetTransformVersion()
+		: std::get<Transform>(m_physicsOrTransform).m_version;
+	return std::max(m_version, transformVersion);
+}
+
 const Physics::Collider* Core::Object::GetCollider() const {
 	return m_collider.get();
 }
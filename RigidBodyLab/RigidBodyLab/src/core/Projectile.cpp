@@ -1,13 +1,13 @@
 #include <core/Projectile.h>
-#include <rendering/Camera.h>
 
-void Core::Projectile::Activate(const Vector3& position) {
+// position, forward and up are those of the shooter, e.g. the camera
+void Core::Projectile::Activate(const Vec3& position, const Vec3& forward, const Vec3& up) {
     if (m_object) {
         RigidBody* rb = m_object->GetRigidBody();
         if (rb) {
-            // adj pos slightly above the camera (so as not to hide the screen)
-            rb->SetPosition(mainCam.GetPos() + Vec3(0.0f, PROJECTILE_Y_OFFSET, 0.0f));
-            rb->SetLinearVelocity(CalculateInitialVelocity());
+            // adj pos slightly above the shooter (so as not to hide the screen)
+            rb->SetPosition(position + Vec3(0.0f, PROJECTILE_Y_OFFSET, 0.0f));
+            rb->SetLinearVelocity(CalculateInitialVelocity(forward, up));
         }
         m_isActive = true;
         m_object->GetCollider()->SetCollisionEnabled(true);
@@ -22,17 +22,12 @@ void Core::Projectile::Deactivate() {
     m_object->SetVisibility(false);
 }
 
-Vec3 Core::Projectile::CalculateInitialVelocity() {
-    Vec3 camPos = mainCam.GetPos();
-    Vec3 lookAtVec = mainCam.GetLookAtVec();
-    Vec3 upVec = mainCam.GetUpVec();
-
-    // calculate the normalized forward direction from the camera to its look-at point
-    Vec3 forwardDirection = Normalize(lookAtVec - camPos);
+Vec3 Core::Projectile::CalculateInitialVelocity(const Vec3& forward, const Vec3& up) {
+    Vec3 forwardDirection = Normalize(forward);
 
     // scale down the up vector's influence for a more horizontal launch
     const float UP_VECTOR_SCL_DOWN_FACTOR = 0.25f;
-    Vec3 launchDirection = Normalize(forwardDirection + upVec * UP_VECTOR_SCL_DOWN_FACTOR);
+    Vec3 launchDirection = Normalize(forwardDirection + up * UP_VECTOR_SCL_DOWN_FACTOR);
 
     Vec3 initialVelocity = launchDirection * INITIAL_SPEED;
 
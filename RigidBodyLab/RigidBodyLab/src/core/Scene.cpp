@@ -1,6 +1,4 @@
 #include <core/Scene.h>
-#include <rendering/Camera.h>
-#include <rendering/Renderer.h>
 #include <physics/Collider.h>
 #include <physics/RigidBody.h>
 #include <core/Transform.h>
@@ -8,14 +6,19 @@
 #include <memory>//std::make_unique
 #include <string>
 #include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <stdexcept>
 
 #include <math/Matrix3.h>//temp
 #include <math/Vector3.h>//temp
 
 using namespace Physics;
 
-Core::Scene::Scene() 
-    : m_ambientLightIntensity{0.3f,0.3f,0.3f,1.f}, m_ambientAlbedo{ 1.f, 1.f, 1.f, 1.0f }, m_numLights{ 1 }, m_orbitalLights(Renderer::NUM_MAX_LIGHTS),
+Core::Scene::Scene(const Rendering::MeshLibrary& meshLibrary, const Vec3& projectileSpawnPos, int numProjectiles)
+    : m_meshLibrary{ meshLibrary }, m_projectileSpawnPos{ projectileSpawnPos }, m_numProjectiles{ numProjectiles },
+    m_ambientLightIntensity{0.3f,0.3f,0.3f,1.f}, m_ambientAlbedo{ 1.f, 1.f, 1.f, 1.0f }, m_numLights{ 1 }, m_orbitalLights(NUM_MAX_LIGHTS),
 	m_diffuseAlbedo{ 0.9f, 0.9f, 0.9f, 1.0f }, m_specularAlbedo{ 1.f, 1.f, 1.f, 1.0f },
 	m_specularPower{ 12 }, m_collisionManager{}, m_mirror{ nullptr }, m_idol{ nullptr }
 {
@@ -44,18 +47,25 @@ void Core::Scene::Update(float dt) {
 
     // integrate (multi-threading)
     //ThreadPool& pool = ThreadPool::GetInstance();
+    m_rigidBodyBatch.Clear();
     for (const auto& obj : m_objects) {
         // enqueue the task
         //pool.enqueue([rawObjPtr, dt]() {
         if (obj.get()->IsVisible() == true) {
-            obj.get()->Integrate(dt);
+            RigidBody* rigidBody = obj.get()->GetRigidBody();
+            if (rigidBody != nullptr && rigidBody->IntegrateMotion(dt)) {
+                m_rigidBodyBatch.Add(rigidBody);
+            }
         }
         //});
     }
+
+    // local-to-world matrices and world inertia tensors of every moved body, in one SIMD pass
+    m_rigidBodyBatch.UpdateTransforms();
 }
 
 int Core::Scene::AddLight() {
-    if (m_numLights < Renderer::NUM_MAX_LIGHTS) {
+    if (m_numLights < NUM_MAX_LIGHTS) {
         m_numLights++;
     }
     return m_numLights;
@@ -116,8 +126,8 @@ const Vec4& Core::Scene::GetLightColor(int lightIdx) const {
  */
 Object* Core::Scene::CreateObject(const std::string& name, MeshID meshID, ImageID textureID, ColliderType colliderType, ColliderConfig colliderConfig, const Vector3& position, float mass, const Quaternion& orientation, ObjectType objType, bool isCollisionEnabled , bool isVisible)
 {
-    // Fetch the mesh and texture
-    auto mesh = ResourceManager::GetInstance().GetMesh(meshID);
+    // Fetch the mesh (null if the library has not loaded it)
+    auto mesh = m_meshLibrary.GetMesh(meshID);
 
     std::unique_ptr<Collider> collider;
     // Determine the type of collider to create
@@ -155,14 +165,13 @@ Object* Core::Scene::CreateObject(const std::string& name, MeshID meshID, ImageI
     return m_objects.back().get();
 }
 
-void Core::Scene::ShootProjectile(const Vector3& position) {
-    static size_t nextProjectileIndex = 0;
+void Core::Scene::ShootProjectile(const Vec3& position, const Vec3& forward, const Vec3& up) {
     // start from the next projectile index and loop around the projectile pool
     for (size_t i = 0; i < m_projectiles.size(); ++i) {
-        size_t idx = (nextProjectileIndex + i) % m_projectiles.size();
+        size_t idx = (m_nextProjectile + i) % m_projectiles.size();
         if (!m_projectiles[idx].m_isActive) {
-            m_projectiles[idx].Activate(position);
-            nextProjectileIndex = (idx + 1) % m_projectiles.size(); // update the index for the next shot
+            m_projectiles[idx].Activate(position, forward, up);
+            m_nextProjectile = (idx + 1) % m_projectiles.size(); // update the index for the next shot
             break;
         }
         else {
@@ -176,7 +185,7 @@ void Core::Scene::ReloadProjectiles() {
     }
 }
 
-void Scene::RemoveObjectsBelowThreshold() {
+void Core::Scene::RemoveObjectsBelowThreshold() {
     RemoveProjectiles();
     RemoveAndNullifySpecialObjects();    
 }
@@ -211,7 +220,7 @@ void Core::Scene::RemoveAndNullifySpecialObjects() {
             }
             else if (obj.get()->GetImageID() == ImageID::GIRL_SKIN) {
                 if (--m_numGirls <= 0 && m_idol) {
-					m_idol->SetMesh(ResourceManager::GetInstance().GetMesh(MeshID::SPHERE));
+					m_idol->SetMesh(m_meshLibrary.GetMesh(MeshID::SPHERE));
                 }
             }
         }
@@ -236,8 +245,6 @@ void Core::Scene::SetUpScene() {
     constexpr float BASE_SCL_Y = 1.5f;//7.5
     constexpr float MIRROR_POS_Y = 10.4f;//5.4
     constexpr float MIRROR_SCL = 6.f;
-    
-    ResourceManager& resourceManager = ResourceManager::GetInstance();
 
     //default objects for the demo scene
 
@@ -286,6 +293,15 @@ void Core::Scene::SetUpScene() {
     //(6) IDOL
     constexpr float IDOL_SCL = 9.f;
     m_idol = CreateObject("idol", MeshID::GRIM_REAPER_LEFTY, ImageID::SPHERE_TEX, ColliderType::OBB, Vector3{ IDOL_SCL,IDOL_SCL,IDOL_SCL }, { -0.5f, 5.3f, 0.5f }, 25.f, Quaternion{}, ObjectType::REFLECTIVE_CURVED);
+
+    //(7) OCCLUDERS: the platform and the grim reaper statues (idol included) hide much of the scene
+    m_plane->SetOccluder(true);
+    const Mesh* grimReaperMesh = m_meshLibrary.GetMesh(MeshID::GRIM_REAPER_LEFTY);
+    for (const auto& obj : m_objects) {
+        if (grimReaperMesh != nullptr && obj->GetMesh() == grimReaperMesh) {
+            obj->SetOccluder(true);
+        }
+    }
 }
 
 void Core::Scene::ApplyBroadPhase()
@@ -319,19 +335,21 @@ void Core::Scene::ApplyNarrowPhaseAndResolveCollisions(float dt)
 
 void Core::Scene::ShrinkPlaneOverTime(float dt) {
     Physics::Collider* collider = m_plane->GetCollider();
+    const std::variant<float, Vec3> currentScale = collider->GetScale(); // named: std::get_if needs an lvalue
 
-    if (auto scale = std::get_if<Vec3>(&collider->GetScale())) {
+    if (auto scale = std::get_if<Vec3>(&currentScale)) {
         // if the collider is a BoxCollider, scale is a Vec3
         Vec3 shrinkAmount = (*scale) *(PLANE_SHRINK_SPEED * dt); // calc the amount to shrink based on dt
         Vec3 newScale = (*scale) - shrinkAmount; // subtract the shrink amount from the current scale
         collider->SetScale(2.f*newScale); 
     }
-    else if (auto radius = std::get_if<float>(&collider->GetScale())) {
+    else if (auto radius = std::get_if<float>(&currentScale)) {
         // if the collider is a SphereCollider, scale is a float representing the radius
         float shrinkAmount = (*radius) * (PLANE_SHRINK_SPEED * dt); // calc the amount to shrink based on dt
         float newRadius = (*radius) - shrinkAmount; // subtract the shrink amount from the current radius
         collider->SetScale(2.f*newRadius); 
     }
+    m_plane->MarkDirty();
 }
 
 Rendering::MeshID Core::Scene::GetRandomIdolMeshID() const{
@@ -353,7 +371,7 @@ void Core::Scene::RestoreTrueIdentities() {
     for (auto& obj : m_objects) {
         if (obj.get()->GetImageID() == ImageID::GRIM_REAPER_SKIN) {
             obj.get()->SetImageID(ImageID::GIRL_SKIN);
-            obj.get()->SetMesh(ResourceManager::GetInstance().GetMesh(MeshID::GIRL_RIGHTY));
+            obj.get()->SetMesh(m_meshLibrary.GetMesh(MeshID::GIRL_RIGHTY));
         }
     }
 }
@@ -363,7 +381,8 @@ void Core::Scene::SetUpOrbitalLights() {
     std::srand(static_cast<unsigned int>(std::time(nullptr)));
 
     //rendom offset between -1 and 1
-    for (int i{}; i < m_numLights; ++i) {
+    //every slot is set up, so lights added later from the GUI are lit as well
+    for (int i{}; i < static_cast<int>(m_orbitalLights.size()); ++i) {
         float offsetX = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * 2.f - 1.f;
         float offsetY = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * 2.f + 7.f;//1~3
         float offsetZ = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * 2.f - 1.f;
@@ -399,6 +418,7 @@ void Core::Scene::SetUpOrbitalLights() {
 void Core::Scene::SetUpProjectiles() {
     static constexpr float PROJECTILE_SCL = 1.f;
     m_projectiles.clear();
+    m_nextProjectile = 0;
 
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -406,7 +426,7 @@ void Core::Scene::SetUpProjectiles() {
     std::uniform_int_distribution<> meshDist(static_cast<int>(MeshID::CUBE), static_cast<int>(MeshID::GOURD));
     std::uniform_int_distribution<> imageDist(0, static_cast<int>(ImageID::POTTERY_TEX_3));
 
-    for (int i{}; i < NUM_PROJECTILES; ++i) {
+    for (int i{}; i < m_numProjectiles; ++i) {
         MeshID randomMeshID = static_cast<MeshID>(meshDist(gen));
         ImageID randomImageID = static_cast<ImageID>(imageDist(gen));
 
@@ -429,7 +449,7 @@ void Core::Scene::SetUpProjectiles() {
             randomImageID,
             colliderType,
             colliderConfig,
-            { mainCam.GetPos().x, mainCam.GetPos().y, mainCam.GetPos().z },
+            { m_projectileSpawnPos.x, m_projectileSpawnPos.y, m_projectileSpawnPos.z },
             Projectile::PROJECTILE_MASS, // mass
             Quaternion{},
             Core::ObjectType::DEFERRED_REGULAR,
@@ -448,6 +468,17 @@ void Core::Scene::SetLightPosition(const Vector3& lightPos, int lightIdx)
     m_orbitalLights[lightIdx].m_lightPosWF = lightPos;
 }
 
+// removes every object, the projectiles included, e.g. to build another scene with CreateObject
+void Core::Scene::Clear() {
+    m_projectiles.clear();
+    m_nextProjectile = 0;
+    m_objects.clear();
+    m_mirror = nullptr;
+    m_idol = nullptr;
+    m_plane = nullptr;
+    m_numGirls = NUM_INITIAL_GIRLS;
+}
+
 void Core::Scene::Reset() {
     m_numGirls = NUM_INITIAL_GIRLS;
     m_projectiles.clear();
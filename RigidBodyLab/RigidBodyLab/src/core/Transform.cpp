@@ -1,29 +1,25 @@
 #include <core/Transform.h>
 void Core::Transform::Update()
 {
-    // First column
-    m_localToWorld.columns[0].m128_f32[0] = 1.0f - 2.0f * (m_orientation.y * m_orientation.y + m_orientation.z * m_orientation.z);
-    m_localToWorld.columns[0].m128_f32[1] = 2.0f * (m_orientation.x * m_orientation.y + m_orientation.w * m_orientation.z);
-    m_localToWorld.columns[0].m128_f32[2] = 2.0f * (m_orientation.x * m_orientation.z - m_orientation.w * m_orientation.y);
-    m_localToWorld.columns[0].m128_f32[3] = 0.0f; // Assuming homogeneous coordinate for direction vectors is 0
-
-    // Second column
-    m_localToWorld.columns[1].m128_f32[0] = 2.0f * (m_orientation.x * m_orientation.y - m_orientation.w * m_orientation.z);
-    m_localToWorld.columns[1].m128_f32[1] = 1.0f - 2.0f * (m_orientation.x * m_orientation.x + m_orientation.z * m_orientation.z);
-    m_localToWorld.columns[1].m128_f32[2] = 2.0f * (m_orientation.y * m_orientation.z + m_orientation.w * m_orientation.x);
-    m_localToWorld.columns[1].m128_f32[3] = 0.0f;
-
-    // Third column
-    m_localToWorld.columns[2].m128_f32[0] = 2.0f * (m_orientation.x * m_orientation.z + m_orientation.w * m_orientation.y);
-    m_localToWorld.columns[2].m128_f32[1] = 2.0f * (m_orientation.y * m_orientation.z - m_orientation.w * m_orientation.x);
-    m_localToWorld.columns[2].m128_f32[2] = 1.0f - 2.0f * (m_orientation.x * m_orientation.x + m_orientation.y * m_orientation.y);
-    m_localToWorld.columns[2].m128_f32[3] = 0.0f; 
-
-    // Fourth column (position)
-    m_localToWorld.columns[3].m128_f32[0] = m_position[0];
-    m_localToWorld.columns[3].m128_f32[1] = m_position[1];
-    m_localToWorld.columns[3].m128_f32[2] = m_position[2];
-    m_localToWorld.columns[3].m128_f32[3] = 1.0f; // Homogeneous coordinate for position is 1
+    const float w = m_orientation.w, x = m_orientation.x, y = m_orientation.y, z = m_orientation.z;
+
+    // one register per column instead of lane-by-lane m128_f32 writes (MSVC-only, and forces a store/reload per lane).
+    // '_mm_set_ps' takes the lanes in reverse order: (w, z, y, x)
+    m_localToWorld.columns[0] = _mm_set_ps(0.0f, 2.0f * (x * z - w * y), 2.0f * (x * y + w * z), 1.0f - 2.0f * (y * y + z * z));
+    m_localToWorld.columns[1] = _mm_set_ps(0.0f, 2.0f * (y * z + w * x), 1.0f - 2.0f * (x * x + z * z), 2.0f * (x * y - w * z));
+    m_localToWorld.columns[2] = _mm_set_ps(0.0f, 1.0f - 2.0f * (x * x + y * y), 2.0f * (y * z - w * x), 2.0f * (x * z + w * y));
+
+    // position, homogeneous coordinate 1
+    m_localToWorld.columns[3] = _mm_set_ps(1.0f, m_position.z, m_position.y, m_position.x);
+
+    m_version = NextVersion();
+}
+
+uint64_t Core::Transform::NextVersion()
+{
+    //only touched from the simulation/render thread
+    static uint64_t counter{};
+    return ++counter;
 }
 
 //Math::Vector3 Core::Transform::GetAxis(int index) const
@@ -49,9 +45,9 @@ Math::Vector3 Core::Transform::GetAxis(int index) const
     }
 
     Vector3 result(
-        m_localToWorld.columns[index].m128_f32[0],
-        m_localToWorld.columns[index].m128_f32[1],
-        m_localToWorld.columns[index].m128_f32[2]
+        m_localToWorld[index * 4],
+        m_localToWorld[index * 4 + 1],
+        m_localToWorld[index * 4 + 2]
     );
     result.Normalize();
 
@@ -7,7 +7,7 @@ void InputHandler::RegisterKeyAction(int key, KeyActionFunction action) {
     keyActions[key] = action;
 }
 void InputHandler::ProcessSpacebar() {
-    scene.ShootProjectile({ mainCam.GetPos().x, mainCam.GetPos().y, mainCam.GetPos().z });
+    scene.ShootProjectile(mainCam.GetPos(), mainCam.GetLookAtVec() - mainCam.GetPos(), mainCam.GetUpVec());
 }
 void InputHandler::ProcessRKey() {
     Rendering::Renderer::GetInstance().Reset();
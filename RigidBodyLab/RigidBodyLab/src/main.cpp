@@ -8,11 +8,52 @@
 #include <core/Application.h>
 #include <rendering/Renderer.h>
 
+#include <cstdlib>
+#include <cstring>
+
 using Rendering::Renderer;
 using Core::Scene;
 
-int main() {
-    Application appState;
+namespace {
+    void PrintUsage(const char* program) {
+        std::cerr << "Usage: " << program << " [--frames N] [--headless] [--gpu-profile file.csv]\n"
+            << "  --frames N            render N frames without the intro nor input, then print the frame times\n"
+            << "  --headless            no window (needs --frames), for machines without a display\n"
+            << "  --gpu-profile file    write the GPU time of each pass and frame to a CSV file\n";
+    }
+
+    bool ParseOptions(int argc, char* argv[], Application::Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+                options.numFrames = std::atoi(argv[++i]);
+                if (options.numFrames <= 0) {
+                    return false;
+                }
+            }
+            else if (std::strcmp(argv[i], "--headless") == 0) {
+                options.headless = true;
+            }
+            else if (std::strcmp(argv[i], "--gpu-profile") == 0 && i + 1 < argc) {
+                options.gpuProfilePath = argv[++i];
+            }
+            else {
+                return false;
+            }
+        }
+        return options.headless == false || options.numFrames > 0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Application::Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // the renderer is made with the application, so the mode must be set before
+    Renderer::SetHeadless(options.headless);
+    Application appState(options);
     appState.Run();
     return 0;
 }
\ No newline at end of file
@@ -196,6 +196,32 @@ Mat4 LookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &up)
 }
 
 
+/******************************************************************************/
+/*!
+\fn     void FrustumPlanes(const Mat4 &viewProj, Vec4 planes[6])
+\brief
+        Extract the 6 clipping planes from a view-projection matrix
+        (Gribb & Hartmann). A point p is inside plane (a, b, c, d) when
+        a*p.x + b*p.y + c*p.z + d >= 0. The planes are not normalized.
+\param  viewProj
+        projection * view, so the planes come out in world space
+\param  planes
+        left, right, bottom, top, near, far
+*/
+/******************************************************************************/
+void FrustumPlanes(const Mat4 &viewProj, Vec4 planes[6])
+{
+    const Mat4 rows = glm::transpose(viewProj);
+
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[3] + rows[2];
+    planes[5] = rows[3] - rows[2];
+}
+
+
 /******************************************************************************/
 /*!
 \fn     Vec3 Normalize(Vec3 v)
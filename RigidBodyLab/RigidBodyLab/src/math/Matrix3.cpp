@@ -1,4 +1,5 @@
 #include "math/Matrix3.h"
+#include <cfloat>
 #include <iostream>
 
 using namespace Math;
@@ -5,6 +5,12 @@
 
 using namespace Math;
 
+namespace {
+    // lane i of a register, as the MSVC-only '.m128_f32[i]' but portable
+    inline float& Lane(__m128& v, int i) { return reinterpret_cast<float*>(&v)[i]; }
+    inline float Lane(const __m128& v, int i) { return reinterpret_cast<const float*>(&v)[i]; }
+}
+
 //'_mm_set_ps' takes four arguments, and it places the first argument in the highest bitsand the last in the lowest bits of the register.
 //Essentially, it stores the values in REVERSE order.
 Matrix4::Matrix4(float value) {
@@ -138,14 +144,16 @@ Matrix4 Matrix4::operator*(const Matrix4& other) const {
         for (int j{}; j < 4; ++j) { // rows (in the result)
 
             // perform the dot product of the i-th row of 'this' with the j-th column of 'other'
-            __m128 row = _mm_setr_ps(columns[0].m128_f32[i], columns[1].m128_f32[i], columns[2].m128_f32[i], columns[3].m128_f32[i]);
-            __m128 col = _mm_setr_ps(other.columns[j].m128_f32[0], other.columns[j].m128_f32[1], other.columns[j].m128_f32[2], other.columns[j].m128_f32[3]);
+            __m128 row = _mm_setr_ps(Lane(columns[0], i), Lane(columns[1], i), Lane(columns[2], i), Lane(columns[3], i));
+            __m128 col = other.columns[j];
 
+            // (m0 + m1) + (m2 + m3), as two '_mm_hadd_ps' would, but with SSE2 only (SSE3 is not in the x86-64 baseline)
             __m128 mul = _mm_mul_ps(row, col);
-            mul = _mm_hadd_ps(mul, mul);
-            mul = _mm_hadd_ps(mul, mul);
+            __m128 swapped = _mm_shuffle_ps(mul, mul, _MM_SHUFFLE(2, 3, 0, 1));
+            __m128 sums = _mm_add_ps(mul, swapped);
+            sums = _mm_add_ss(sums, _mm_movehl_ps(swapped, sums));
 
-            result.columns[j].m128_f32[i] = _mm_cvtss_f32(mul);
+            Lane(result.columns[j], i) = _mm_cvtss_f32(sums);
         }
     }
     return result;
@@ -163,10 +171,10 @@ Matrix4& Matrix4::operator*=(const Matrix4& other) {
 
 
 Vector3 Matrix4::operator*(const Vector4& vec) const {
-    float x = columns[0].m128_f32[0] * vec.vec3.x + columns[1].m128_f32[0] * vec.vec3.y + columns[2].m128_f32[0] * vec.vec3.z + vec.w * columns[3].m128_f32[0];
-    float y = columns[0].m128_f32[1] * vec.vec3.x + columns[1].m128_f32[1] * vec.vec3.y + columns[2].m128_f32[1] * vec.vec3.z + vec.w * columns[3].m128_f32[1];
-    float z = columns[0].m128_f32[2] * vec.vec3.x + columns[1].m128_f32[2] * vec.vec3.y + columns[2].m128_f32[2] * vec.vec3.z + vec.w * columns[3].m128_f32[2];
-    //float w = columns[0].m128_f32[3] * vec.x + columns[1].m128_f32[3] * vec.y + columns[2].m128_f32[3] * vec.z + columns[3].m128_f32[3];
+    float x = Lane(columns[0], 0) * vec.vec3.x + Lane(columns[1], 0) * vec.vec3.y + Lane(columns[2], 0) * vec.vec3.z + vec.w * Lane(columns[3], 0);
+    float y = Lane(columns[0], 1) * vec.vec3.x + Lane(columns[1], 1) * vec.vec3.y + Lane(columns[2], 1) * vec.vec3.z + vec.w * Lane(columns[3], 1);
+    float z = Lane(columns[0], 2) * vec.vec3.x + Lane(columns[1], 2) * vec.vec3.y + Lane(columns[2], 2) * vec.vec3.z + vec.w * Lane(columns[3], 2);
+    //float w = Lane(columns[0], 3) * vec.x + Lane(columns[1], 3) * vec.y + Lane(columns[2], 3) * vec.z + Lane(columns[3], 3);
 
     //if (w != 1.f && w != 0.f) {
     //    x /= w;
@@ -250,7 +258,7 @@ float Math::Matrix4::Get(int row, int column) const {
     if (row < 0 || row > 3 || column < 0 || column > 3) {
         throw std::out_of_range("Index out of bounds for Matrix4");
     }
-    return columns[row].m128_f32[column];
+    return Lane(columns[row], column);
 }
 
 
@@ -259,7 +267,7 @@ void Math::Matrix4::Set(int row, int column, float value) {
     if (row < 0 || row > 3 || column < 0 || column > 3) {
         throw std::out_of_range("Index out of bounds for Matrix4");
     }
-    columns[row].m128_f32[column] = value;
+    Lane(columns[row], column) = value;
 }
 
 Matrix3 Matrix4::Extract3x3Matrix() const {
@@ -283,7 +291,7 @@ Math::Matrix4::operator glm::mat4() const noexcept {
     glm::mat4 result;
     for (int row = 0; row < 4; ++row) {
         for (int col = 0; col < 4; ++col) {
-            result[row][col] = columns[row].m128_f32[col];
+            result[row][col] = Lane(columns[row], col);
         }
     }
     return result;
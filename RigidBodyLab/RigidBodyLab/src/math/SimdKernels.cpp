@@ -0,0 +1,119 @@
+#include <math/SimdKernels.h>
+#include <utilities/Logger.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace Math
+{
+    // defined in SimdKernels_<level>.cpp
+    extern const SimdKernelTable SIMD_KERNELS_SSE2;
+    extern const SimdKernelTable SIMD_KERNELS_AVX2;
+    extern const SimdKernelTable SIMD_KERNELS_AVX512;
+}
+
+namespace
+{
+    struct CpuidRegisters {
+        unsigned int eax, ebx, ecx, edx;
+    };
+
+    CpuidRegisters Cpuid(unsigned int leaf, unsigned int subLeaf = 0) {
+        CpuidRegisters regs{};
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subLeaf));
+        regs = { static_cast<unsigned int>(info[0]), static_cast<unsigned int>(info[1]),
+                 static_cast<unsigned int>(info[2]), static_cast<unsigned int>(info[3]) };
+#else
+        __cpuid_count(leaf, subLeaf, regs.eax, regs.ebx, regs.ecx, regs.edx);
+#endif
+        return regs;
+    }
+
+    // XCR0: which register states the OS saves on context switches
+    unsigned long long ReadXCR0() {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        unsigned int lo, hi;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+    }
+
+    constexpr unsigned int CPUID1_ECX_FMA = 1u << 12;
+    constexpr unsigned int CPUID1_ECX_OSXSAVE = 1u << 27;
+    constexpr unsigned int CPUID1_ECX_AVX = 1u << 28;
+    constexpr unsigned int CPUID7_EBX_AVX2 = 1u << 5;
+    constexpr unsigned int CPUID7_EBX_AVX512F = 1u << 16;
+
+    constexpr unsigned long long XCR0_YMM = 0x6;    // XMM | YMM
+    constexpr unsigned long long XCR0_ZMM = 0xE6;   // XMM | YMM | opmask | ZMM_Hi256 | Hi16_ZMM
+}
+
+const char* Math::ToString(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::SSE2:   return "SSE2";
+    case SimdLevel::AVX2:   return "AVX2";
+    case SimdLevel::AVX512: return "AVX-512";
+    default:                return "unknown";
+    }
+}
+
+Math::SimdLevel Math::DetectSimdLevel()
+{
+    // SSE2 is part of the x86-64 baseline
+    if (Cpuid(0).eax < 7) {
+        return SimdLevel::SSE2;
+    }
+
+    const CpuidRegisters leaf1 = Cpuid(1);
+    const CpuidRegisters leaf7 = Cpuid(7);
+
+    const unsigned int avxBits = CPUID1_ECX_OSXSAVE | CPUID1_ECX_AVX | CPUID1_ECX_FMA;
+    if ((leaf1.ecx & avxBits) != avxBits) {
+        return SimdLevel::SSE2;
+    }
+
+    const unsigned long long xcr0 = ReadXCR0();
+    if ((xcr0 & XCR0_YMM) != XCR0_YMM || (leaf7.ebx & CPUID7_EBX_AVX2) == 0) {
+        return SimdLevel::SSE2;
+    }
+
+    if ((xcr0 & XCR0_ZMM) == XCR0_ZMM && (leaf7.ebx & CPUID7_EBX_AVX512F) != 0) {
+        return SimdLevel::AVX512;
+    }
+    return SimdLevel::AVX2;
+}
+
+const Math::SimdKernelTable& Math::GetSimdKernels()
+{
+    static const SimdKernelTable& kernels = [] () -> const SimdKernelTable& {
+        const SimdKernelTable& selected = *GetSimdKernels(DetectSimdLevel());
+        Logger::Log("Math::GetSimdKernels(): using ", ToString(selected.level), " kernels");
+        return selected;
+    }();
+
+    return kernels;
+}
+
+const Math::SimdKernelTable* Math::GetSimdKernels(SimdLevel level)
+{
+    static const SimdLevel detected = DetectSimdLevel();
+
+    if (level > detected) {
+        return nullptr;
+    }
+
+    switch (level) {
+    case SimdLevel::SSE2:   return &SIMD_KERNELS_SSE2;
+    case SimdLevel::AVX2:   return &SIMD_KERNELS_AVX2;
+    case SimdLevel::AVX512: return &SIMD_KERNELS_AVX512;
+    default:                return nullptr;
+    }
+}
@@ -0,0 +1,31 @@
+// Compiled with /arch:AVX2 (MSVC) or -mavx2 -mfma, see CMakeLists.txt.
+// Only reached through GetSimdKernels() after cpuid confirmed AVX2 support.
+#include <math/SimdKernelsImpl.h>
+#include <immintrin.h>
+
+namespace
+{
+    struct LaneAVX2 {
+        __m256 v;
+
+        static constexpr std::size_t WIDTH = 8;
+
+        static LaneAVX2 Load(const float* ptr) { return { _mm256_loadu_ps(ptr) }; }
+        static LaneAVX2 Set1(float value) { return { _mm256_set1_ps(value) }; }
+        void Store(float* ptr) const { _mm256_storeu_ps(ptr, v); }
+
+        friend LaneAVX2 operator+(LaneAVX2 a, LaneAVX2 b) { return { _mm256_add_ps(a.v, b.v) }; }
+        friend LaneAVX2 operator-(LaneAVX2 a, LaneAVX2 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+        friend LaneAVX2 operator*(LaneAVX2 a, LaneAVX2 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+        friend LaneAVX2 operator/(LaneAVX2 a, LaneAVX2 b) { return { _mm256_div_ps(a.v, b.v) }; }
+        friend LaneAVX2 Abs(LaneAVX2 a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v) }; }
+        friend LaneAVX2 SelectIfLess(LaneAVX2 a, LaneAVX2 b, LaneAVX2 x, LaneAVX2 y) {
+            return { _mm256_blendv_ps(y.v, x.v, _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)) };
+        }
+    };
+}
+
+namespace Math
+{
+    extern const SimdKernelTable SIMD_KERNELS_AVX2 = MakeKernelTable<LaneAVX2>(SimdLevel::AVX2);
+}
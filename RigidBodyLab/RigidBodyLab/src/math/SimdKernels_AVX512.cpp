@@ -0,0 +1,31 @@
+// Compiled with /arch:AVX512 (MSVC) or -mavx512f, see CMakeLists.txt.
+// Only reached through GetSimdKernels() after cpuid confirmed AVX-512F support.
+#include <math/SimdKernelsImpl.h>
+#include <immintrin.h>
+
+namespace
+{
+    struct LaneAVX512 {
+        __m512 v;
+
+        static constexpr std::size_t WIDTH = 16;
+
+        static LaneAVX512 Load(const float* ptr) { return { _mm512_loadu_ps(ptr) }; }
+        static LaneAVX512 Set1(float value) { return { _mm512_set1_ps(value) }; }
+        void Store(float* ptr) const { _mm512_storeu_ps(ptr, v); }
+
+        friend LaneAVX512 operator+(LaneAVX512 a, LaneAVX512 b) { return { _mm512_add_ps(a.v, b.v) }; }
+        friend LaneAVX512 operator-(LaneAVX512 a, LaneAVX512 b) { return { _mm512_sub_ps(a.v, b.v) }; }
+        friend LaneAVX512 operator*(LaneAVX512 a, LaneAVX512 b) { return { _mm512_mul_ps(a.v, b.v) }; }
+        friend LaneAVX512 operator/(LaneAVX512 a, LaneAVX512 b) { return { _mm512_div_ps(a.v, b.v) }; }
+        friend LaneAVX512 Abs(LaneAVX512 a) { return { _mm512_abs_ps(a.v) }; }
+        friend LaneAVX512 SelectIfLess(LaneAVX512 a, LaneAVX512 b, LaneAVX512 x, LaneAVX512 y) {
+            return { _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ), y.v, x.v) };
+        }
+    };
+}
+
+namespace Math
+{
+    extern const SimdKernelTable SIMD_KERNELS_AVX512 = MakeKernelTable<LaneAVX512>(SimdLevel::AVX512);
+}
@@ -0,0 +1,31 @@
+#include <math/SimdKernelsImpl.h>
+#include <emmintrin.h>
+
+namespace
+{
+    struct LaneSSE2 {
+        __m128 v;
+
+        static constexpr std::size_t WIDTH = 4;
+
+        static LaneSSE2 Load(const float* ptr) { return { _mm_loadu_ps(ptr) }; }
+        static LaneSSE2 Set1(float value) { return { _mm_set1_ps(value) }; }
+        void Store(float* ptr) const { _mm_storeu_ps(ptr, v); }
+
+        friend LaneSSE2 operator+(LaneSSE2 a, LaneSSE2 b) { return { _mm_add_ps(a.v, b.v) }; }
+        friend LaneSSE2 operator-(LaneSSE2 a, LaneSSE2 b) { return { _mm_sub_ps(a.v, b.v) }; }
+        friend LaneSSE2 operator*(LaneSSE2 a, LaneSSE2 b) { return { _mm_mul_ps(a.v, b.v) }; }
+        friend LaneSSE2 operator/(LaneSSE2 a, LaneSSE2 b) { return { _mm_div_ps(a.v, b.v) }; }
+        friend LaneSSE2 Abs(LaneSSE2 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.f), a.v) }; }
+        friend LaneSSE2 SelectIfLess(LaneSSE2 a, LaneSSE2 b, LaneSSE2 x, LaneSSE2 y) {
+            //no blendv before SSE4.1
+            const __m128 mask = _mm_cmplt_ps(a.v, b.v);
+            return { _mm_or_ps(_mm_and_ps(mask, x.v), _mm_andnot_ps(mask, y.v)) };
+        }
+    };
+}
+
+namespace Math
+{
+    extern const SimdKernelTable SIMD_KERNELS_SSE2 = MakeKernelTable<LaneSSE2>(SimdLevel::SSE2);
+}
@@ -1,5 +1,7 @@
 #include <physics/CollisionManager.h>
 #include <utilities/ThreadPool.h>
+#include <cfloat>
+#include <cmath>
 
 Math::Vector3 Physics::CollisionManager::GetBoxContactVertexLocal(const Vector3& axis1, const Vector3& axis2, const Vector3& axis3, Vector3 collisionNormal, std::function<bool(float, float)> cmp) const {
     Vector3 contactPoint{ 0.5f,0.5f,0.5f };
@@ -168,6 +170,7 @@ void Physics::CollisionManager::FindCollisionFeaturesSphereBox(const SphereColli
     if (distanceSquared > radius * radius) {
         return; // No collision
     }
+    ++m_stats.pairsOverlapping;
 
     // If a collision is detected, populate and return CollisionData
     CollisionData collisionData;
@@ -205,6 +208,7 @@ void Physics::CollisionManager::FindCollisionFeaturesBoxBox(const BoxCollider* b
     if (distanceVec.LengthSquared() > (radius1 + radius2) * (radius1 + radius2)) {
         return; // No collision
     }
+    ++m_stats.pairsOverlapping;
 
     // Axes to test for potential separating planes
     std::vector<Vector3> axes(NUM_AXES, Vector3{});
@@ -267,12 +271,14 @@ void Physics::CollisionManager::FindCollisionFeaturesBoxBox(const BoxCollider* b
 void Physics::CollisionManager::Reset() { 
 
     m_collisions.clear(); 
+    m_stats = {};
 }
 
 void Physics::CollisionManager::CheckCollision(Core::Object* obj1, Core::Object* obj2) {
     const Collider* collider1 = obj1->GetCollider();
     const Collider* collider2 = obj2->GetCollider();
     if (collider1 && collider2 && collider1->GetCollisionEnabled() && collider2->GetCollisionEnabled()) {
+        ++m_stats.pairsTested;
 
         if (const auto* sphere1 = dynamic_cast<const SphereCollider*>(collider1)) {
             // Sphere-Box collision
@@ -317,6 +323,8 @@ void Physics::CollisionManager::CheckCollision(Core::Object* obj1, Core::Object*
 }
 
 void Physics::CollisionManager::ResolveCollision(float dt) {
+    m_stats.contacts = m_collisions.size();
+    m_stats.solverIterations = m_collisions.empty() ? 0 : m_iterationLimit;
 
     for (int i = 0; i < m_iterationLimit; ++i) {
         for (auto& contact : m_collisions) {
@@ -495,7 +503,7 @@ void Physics::CollisionManager::SequentialImpulse(CollisionData& contact, float
     // Compute the impulse
     float jacobianImpulse = ((-(1 + restitutionTerm) * relativeSpeed) + baumgarte) / effectiveMass;
 
-    if (isnan(jacobianImpulse)) {
+    if (std::isnan(jacobianImpulse)) {
         return;
     }
 
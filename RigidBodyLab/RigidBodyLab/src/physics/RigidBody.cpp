@@ -6,9 +6,20 @@ using namespace Physics;
 
 void RigidBody::Integrate(float duration)
 {
-    if (massInverse == 0.0f) {
+    if (IntegrateMotion(duration) == false) {
         return;
     }
+
+    //5.update accordingly
+    transform.Update();
+    TransformInertiaTensor();
+}
+
+bool RigidBody::IntegrateMotion(float duration)
+{
+    if (massInverse == 0.0f) {
+        return false;
+    }
     
     //0. apply gravitational force
     static Vector3 gravity(0,GRAVITY, 0);
@@ -30,12 +41,10 @@ void RigidBody::Integrate(float duration)
     transform.m_orientation += transform.m_orientation.RotateByVector(angularVelocity, duration / 2.0f);
     transform.m_orientation.Normalize();
 
-    //5.update accordingly
-    transform.Update();
-    TransformInertiaTensor();
-
     force.Clear();
     torque.Clear();
+
+    return true;
 }
 
 void RigidBody::AddForce(const Vector3& _force){
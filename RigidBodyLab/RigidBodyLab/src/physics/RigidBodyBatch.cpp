@@ -0,0 +1,85 @@
+#include <physics/RigidBodyBatch.h>
+#include <physics/RigidBody.h>
+#include <algorithm>
+
+using namespace Physics;
+
+void RigidBodyBatch::Reserve(size_t count)
+{
+    if (count <= m_capacity) {
+        return;
+    }
+    // grow geometrically, the planes are re-filled every update so nothing has to be preserved
+    m_capacity = std::max(count, m_capacity * 2);
+    m_planes.resize(NUM_PLANES * m_capacity);
+}
+
+void RigidBodyBatch::UpdateTransforms()
+{
+    const size_t count = m_bodies.size();
+    if (count == 0) {
+        return;
+    }
+    Reserve(count);
+
+    float* qw = GetPlane(QUAT_W);
+    float* qx = GetPlane(QUAT_X);
+    float* qy = GetPlane(QUAT_Y);
+    float* qz = GetPlane(QUAT_Z);
+    float* px = GetPlane(POS_X);
+    float* py = GetPlane(POS_Y);
+    float* pz = GetPlane(POS_Z);
+
+    Math::ConstMat3SoA invInertia;
+    Math::Mat4SoA localToWorld;
+    Math::Mat3SoA invInertiaWorld;
+    for (int e{}; e < 9; ++e) {
+        invInertia.e[e] = GetPlane(INV_INERTIA + e);
+        invInertiaWorld.e[e] = GetPlane(INV_INERTIA_WORLD + e);
+    }
+    for (int e{}; e < 16; ++e) {
+        localToWorld.e[e] = GetPlane(LOCAL_TO_WORLD + e);
+    }
+
+    //1. gather (AoS -> SoA)
+    for (size_t i{}; i < count; ++i) {
+        const RigidBody& body = *m_bodies[i];
+        const Quaternion& q = body.transform.m_orientation;
+        const Vector3& p = body.transform.m_position;
+
+        qw[i] = q.w;
+        qx[i] = q.x;
+        qy[i] = q.y;
+        qz[i] = q.z;
+        px[i] = p.x;
+        py[i] = p.y;
+        pz[i] = p.z;
+
+        for (int col{}; col < 3; ++col) {
+            for (int row{}; row < 3; ++row) {
+                GetPlane(INV_INERTIA + col * 3 + row)[i] = body.inverseInertiaTensor.entries[col][row];
+            }
+        }
+    }
+
+    //2. one call for every body, SIMD across bodies
+    Math::GetSimdKernels().updateRigidTransforms({ qw, qx, qy, qz }, { px, py, pz }, invInertia, localToWorld, invInertiaWorld, count);
+
+    //3. scatter (SoA -> AoS)
+    for (size_t i{}; i < count; ++i) {
+        RigidBody& body = *m_bodies[i];
+
+        for (int col{}; col < 4; ++col) {
+            body.transform.m_localToWorld.columns[col] = _mm_set_ps(
+                localToWorld.e[col * 4 + 3][i], localToWorld.e[col * 4 + 2][i],
+                localToWorld.e[col * 4 + 1][i], localToWorld.e[col * 4][i]);
+        }
+        body.transform.m_version = Core::Transform::NextVersion();
+
+        for (int col{}; col < 3; ++col) {
+            for (int row{}; row < 3; ++row) {
+                body.inverseInertiaTensorWorld.entries[col][row] = invInertiaWorld.e[col * 3 + row][i];
+            }
+        }
+    }
+}
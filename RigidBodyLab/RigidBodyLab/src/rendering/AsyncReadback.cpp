@@ -0,0 +1,138 @@
+#include <glad/glad.h>
+#include <rendering/AsyncReadback.h>
+#include <utilities/Logger.h>
+#include <cstring>
+
+using namespace Rendering;
+
+
+/******************************************************************************/
+/*!
+\fn     void Init(int width, int height)
+\brief
+        (Re)allocate the pixel buffers for rectangles of the given size.
+        Requests still in flight are dropped.
+*/
+/******************************************************************************/
+void AsyncReadback::Init(int width, int height)
+{
+    Release();
+    m_width = width;
+    m_height = height;
+
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(width) * height * 4;
+    for (Slot& slot : m_slots) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void AsyncReadback::Release()
+{
+    for (Slot& slot : m_slots) {
+        if (slot.fence) {
+            glDeleteSync(static_cast<GLsync>(slot.fence));
+        }
+        glDeleteBuffers(1, &slot.pbo);
+        slot = {};
+    }
+    m_oldest = 0;
+    m_numPending = 0;
+}
+
+
+/******************************************************************************/
+/*!
+\fn     bool Request(std::uint64_t id, int x, int y)
+\brief
+        Queue the copy of the width x height rectangle at (x, y) of the
+        current read framebuffer and read buffer.
+\param  id
+        Returned with the pixels, to tell which frame they belong to.
+\return
+        false if every slot is still waiting for the GPU; the request is
+        then dropped rather than stalling.
+*/
+/******************************************************************************/
+bool AsyncReadback::Request(std::uint64_t id, int x, int y)
+{
+    if (m_width == 0 || m_numPending == RING_SIZE) {
+        ++m_numDropped;
+        return false;
+    }
+
+    Slot& slot = m_slots[(m_oldest + m_numPending) % RING_SIZE];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glReadPixels(x, y, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.id = id;
+    ++m_numPending;
+    return true;
+}
+
+
+/******************************************************************************/
+/*!
+\fn     bool Poll(Frame& frame, bool wait)
+\brief
+        Copy out the pixels of the oldest request if the GPU is done with it.
+\param  wait
+        Block until the oldest request is done instead of giving up, e.g.
+        to drain the ring at the end of a run.
+\return
+        Whether frame was filled. When the fence wait or the mapping of the
+        buffer fails, the error is logged, false is returned and the request
+        stays the oldest pending one, to be tried again. Pixels lost while
+        mapped cannot be read again: that request is counted as dropped.
+*/
+/******************************************************************************/
+bool AsyncReadback::Poll(Frame& frame, bool wait)
+{
+    if (m_numPending == 0) {
+        return false;
+    }
+
+    Slot& slot = m_slots[m_oldest];
+    const GLuint64 timeout = wait ? GL_TIMEOUT_IGNORED : 0;
+    const GLenum status = glClientWaitSync(static_cast<GLsync>(slot.fence), GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    if (status == GL_WAIT_FAILED) {
+        Logger::Log("Error: AsyncReadback cannot wait for the fence of frame ", slot.id, " (GL error ", glGetError(), ")");
+        return false;
+    }
+
+    const size_t bytes = static_cast<size_t>(m_width) * m_height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    if (data == nullptr) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        Logger::Log("Error: AsyncReadback cannot map the pixels of frame ", slot.id, " (GL error ", glGetError(), ")");
+        return false;
+    }
+    frame.id = slot.id;
+    frame.width = m_width;
+    frame.height = m_height;
+    frame.pixels.resize(bytes);
+    std::memcpy(frame.pixels.data(), data, bytes);
+    const bool unmapped = glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_TRUE;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glDeleteSync(static_cast<GLsync>(slot.fence));
+    slot.fence = nullptr;
+    m_oldest = (m_oldest + 1) % RING_SIZE;
+    --m_numPending;
+
+    if (unmapped == false) {
+        /*  The buffer store was lost while mapped, what was copied out is undefined */
+        Logger::Log("Error: AsyncReadback lost the pixels of frame ", frame.id, " while they were mapped");
+        ++m_numDropped;
+        return false;
+    }
+    return true;
+}
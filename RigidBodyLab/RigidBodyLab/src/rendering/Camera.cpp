@@ -194,10 +194,10 @@ ViewMat()
     float alphaAng = ONE_STEP * alpha;
     float betaAng = ONE_STEP * beta;
 
-    float ca = std::cosf(alphaAng);
-    float sa = std::sinf(alphaAng);
-    float cb = std::cosf(betaAng);
-    float sb = std::sinf(betaAng);
+    float ca = std::cos(alphaAng);
+    float sa = std::sin(alphaAng);
+    float cb = std::cos(betaAng);
+    float sb = std::sin(betaAng);
 
     float eyeProjXZ = radius * ca;
     pos = lookAt + Vec3(eyeProjXZ * cb, radius * sa, eyeProjXZ * sb);
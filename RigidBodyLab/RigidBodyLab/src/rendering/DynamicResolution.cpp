@@ -0,0 +1,78 @@
+#include <rendering/DynamicResolution.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace Rendering;
+
+namespace
+{
+    float FloorToStep(float scale) { return std::floor(scale / DynamicResolution::SCALE_STEP + 1e-4f) * DynamicResolution::SCALE_STEP; }
+}
+
+
+DynamicResolution::DynamicResolution(float budgetMs, float minScale, float maxScale)
+    : m_budgetMs{ budgetMs }
+    , m_minScale{ minScale }
+    , m_maxScale{ maxScale }
+    , m_scale{ maxScale }
+{
+}
+
+
+/*  The current scale is clamped to the new limits; a wider range only takes effect through Update() */
+void DynamicResolution::SetLimits(float minScale, float maxScale)
+{
+    m_minScale = std::min(minScale, maxScale);
+    m_maxScale = maxScale;
+    m_scale = std::clamp(m_scale, m_minScale, m_maxScale);
+}
+
+
+/******************************************************************************/
+/*!
+\fn     float Update(float gpuMs, float cpuMs)
+\brief
+        Feed the times of one measured frame and get the scale to render the
+        next one at, see the class comment.
+\param  gpuMs
+        GPU time of the frame, from a timer query.
+\param  cpuMs
+        CPU time the renderer spent on the frame.
+\return
+        The new scale.
+*/
+/******************************************************************************/
+float DynamicResolution::Update(float gpuMs, float cpuMs)
+{
+    if (m_framesToSettle > 0) {
+        --m_framesToSettle;
+        return m_scale;
+    }
+
+    const float prevScale = m_scale;
+    if (gpuMs > m_budgetMs) {
+        const float fit = m_scale * std::sqrt(HEADROOM * m_budgetMs / gpuMs);
+        m_scale = std::max(FloorToStep(fit), m_minScale);
+        m_framesUnderBudget = 0;
+    }
+    else if (gpuMs < RAISE_BELOW * m_budgetMs && cpuMs <= m_budgetMs) {
+        if (++m_framesUnderBudget >= RAISE_AFTER_FRAMES) {
+            m_scale = std::min(FloorToStep(m_scale) + SCALE_STEP, m_maxScale);
+            m_framesUnderBudget = 0;
+        }
+    }
+    else {
+        m_framesUnderBudget = 0;
+    }
+
+    if (m_scale != prevScale) {
+        m_framesToSettle = SETTLE_FRAMES;
+    }
+    return m_scale;
+}
+
+
+int DynamicResolution::ScaleSize(int size, float scale)
+{
+    return std::max(static_cast<int>(std::lround(size * scale)), 1);
+}
@@ -0,0 +1,281 @@
+#include <glad/glad.h>
+#include <rendering/GLStateCache.h>
+#include <utilities/ToUnderlyingEnum.h>
+#include <cstring>
+#include <numeric>
+
+using namespace Rendering;
+
+unsigned GLStateStats::TotalIssued() const
+{
+    return std::accumulate(issued.begin(), issued.end(), 0u);
+}
+
+unsigned GLStateStats::TotalSkipped() const
+{
+    return std::accumulate(skipped.begin(), skipped.end(), 0u);
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void BeginFrame()
+\brief
+        Keep the counters of the frame that just ended and start new ones.
+        The shadowed bindings are dropped as well, since ImGui and the resource
+        uploads between two frames bind things without going through the cache.
+        Uniform values are kept: nothing outside the cache sets the uniforms
+        of the renderer's programs.
+*/
+/******************************************************************************/
+void GLStateCache::BeginFrame()
+{
+    m_lastFrameStats = m_frameStats;
+    m_frameStats = {};
+    Invalidate();
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void Invalidate()
+\brief
+        Forget the bindings and the enabled state, so that the next call of
+        each kind is issued. Uniform values are not affected, see
+        ForgetProgram.
+*/
+/******************************************************************************/
+void GLStateCache::Invalidate()
+{
+    m_program = UNKNOWN;
+    m_vertexArray = UNKNOWN;
+    m_activeUnit = -1;
+    m_textures.fill(UNKNOWN);
+    m_textureTargets.fill(UNKNOWN_ENUM);
+    m_cullFace = UNKNOWN_ENUM;
+    m_cullFaceEnabled = -1;
+    m_depthTestEnabled = -1;
+    m_depthMask = -1;
+}
+
+
+/******************************************************************************/
+/*!
+n     void ForgetProgram(GLuint program)
+rief
+        Drop the uniform values recorded for a program. Linking resets the
+        uniforms of a program to their defaults, and a deleted program's name
+        may be handed out again, so either must be followed by this.
+*/
+/******************************************************************************/
+void GLStateCache::ForgetProgram(GLuint program)
+{
+    for (auto it = m_uniforms.begin(); it != m_uniforms.end();) {
+        if (static_cast<GLuint>(it->first >> 32) == program) {
+            it = m_uniforms.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void GLStateCache::Count(GLStateCall call, bool issued)
+{
+    if (issued) {
+        ++m_frameStats.issued[TO_INT(call)];
+    }
+    else {
+        ++m_frameStats.skipped[TO_INT(call)];
+    }
+}
+
+void GLStateCache::UseProgram(GLuint program)
+{
+    const bool changed = program != m_program;
+    if (changed) {
+        glUseProgram(program);
+        m_program = program;
+    }
+    Count(GLStateCall::PROGRAM, changed);
+}
+
+void GLStateCache::BindVertexArray(GLuint vao)
+{
+    const bool changed = vao != m_vertexArray;
+    if (changed) {
+        glBindVertexArray(vao);
+        m_vertexArray = vao;
+    }
+    Count(GLStateCall::VERTEX_ARRAY, changed);
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void BindTexture(int unit, GLenum target, GLuint texture)
+\brief
+        Bind a texture to a texture unit, switching the active unit only when
+        the binding actually has to change.
+        A unit remembers one target; binding another target on it is always
+        issued, so at worst a redundant bind goes through.
+*/
+/******************************************************************************/
+void GLStateCache::BindTexture(int unit, GLenum target, GLuint texture)
+{
+    const bool tracked = unit >= 0 && unit < NUM_TEXTURE_UNITS;
+    if (tracked && m_textures[unit] == texture && m_textureTargets[unit] == target) {
+        Count(GLStateCall::TEXTURE, false);
+        return;
+    }
+
+    if (unit != m_activeUnit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        m_activeUnit = unit;
+        Count(GLStateCall::ACTIVE_TEXTURE, true);
+    }
+    glBindTexture(target, texture);
+    Count(GLStateCall::TEXTURE, true);
+
+    if (tracked) {
+        m_textures[unit] = texture;
+        m_textureTargets[unit] = target;
+    }
+}
+
+void GLStateCache::CullFace(GLenum face)
+{
+    const bool changed = face != m_cullFace;
+    if (changed) {
+        glCullFace(face);
+        m_cullFace = face;
+    }
+    Count(GLStateCall::CULL_FACE, changed);
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void SetCapability(GLenum cap, bool enabled)
+\brief
+        glEnable/glDisable. Only GL_DEPTH_TEST and GL_CULL_FACE are shadowed,
+        other capabilities are always issued.
+*/
+/******************************************************************************/
+void GLStateCache::SetCapability(GLenum cap, bool enabled)
+{
+    int* state = nullptr;
+    if (cap == GL_DEPTH_TEST) {
+        state = &m_depthTestEnabled;
+    }
+    else if (cap == GL_CULL_FACE) {
+        state = &m_cullFaceEnabled;
+    }
+
+    if (state && *state == static_cast<int>(enabled)) {
+        Count(GLStateCall::CAPABILITY, false);
+        return;
+    }
+
+    if (enabled) {
+        glEnable(cap);
+    }
+    else {
+        glDisable(cap);
+    }
+    if (state) {
+        *state = enabled;
+    }
+    Count(GLStateCall::CAPABILITY, true);
+}
+
+void GLStateCache::DepthMask(bool enabled)
+{
+    const bool changed = m_depthMask != static_cast<int>(enabled);
+    if (changed) {
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+        m_depthMask = enabled;
+    }
+    Count(GLStateCall::DEPTH_MASK, changed);
+}
+
+
+/******************************************************************************/
+/*!
+\fn     bool SetUniform(GLint location, const void* value, int size)
+\brief
+        Record a uniform value of the program in use.
+\param  size
+        Number of 32-bit components of the value.
+\return
+        Whether the value differs from the last one sent, i.e. whether the
+        caller has to issue the glUniform* call.
+*/
+/******************************************************************************/
+bool GLStateCache::SetUniform(GLint location, const void* value, int size)
+{
+    /*  GL silently ignores location -1 (uniform optimized out), so there is nothing to send */
+    if (location < 0) {
+        Count(GLStateCall::UNIFORM, false);
+        return false;
+    }
+    if (m_program == UNKNOWN) {
+        Count(GLStateCall::UNIFORM, true);
+        return true;
+    }
+
+    UniformValue& cached = m_uniforms[(static_cast<std::uint64_t>(m_program) << 32) | static_cast<std::uint32_t>(location)];
+    const size_t bytes = size * sizeof(std::uint32_t);
+    if (cached.bits.size() == static_cast<size_t>(size) && std::memcmp(cached.bits.data(), value, bytes) == 0) {
+        Count(GLStateCall::UNIFORM, false);
+        return false;
+    }
+
+    cached.bits.resize(size);
+    std::memcpy(cached.bits.data(), value, bytes);
+    Count(GLStateCall::UNIFORM, true);
+    return true;
+}
+
+void GLStateCache::Uniform1i(GLint location, GLint value)
+{
+    if (SetUniform(location, &value, 1)) {
+        glUniform1i(location, value);
+    }
+}
+
+void GLStateCache::Uniform1f(GLint location, GLfloat value)
+{
+    if (SetUniform(location, &value, 1)) {
+        glUniform1f(location, value);
+    }
+}
+
+void GLStateCache::Uniform2f(GLint location, GLfloat x, GLfloat y)
+{
+    const GLfloat value[2] = { x, y };
+    if (SetUniform(location, value, 2)) {
+        glUniform2f(location, x, y);
+    }
+}
+
+void GLStateCache::Uniform3fv(GLint location, const GLfloat* value)
+{
+    if (SetUniform(location, value, 3)) {
+        glUniform3fv(location, 1, value);
+    }
+}
+
+void GLStateCache::Uniform4fv(GLint location, const GLfloat* value, GLsizei count)
+{
+    if (SetUniform(location, value, 4 * count)) {
+        glUniform4fv(location, count, value);
+    }
+}
+
+void GLStateCache::UniformMatrix4fv(GLint location, const GLfloat* value, GLsizei count)
+{
+    if (SetUniform(location, value, 16 * count)) {
+        glUniformMatrix4fv(location, count, GL_FALSE, value);
+    }
+}
@@ -0,0 +1,87 @@
+#include <glad/glad.h>
+#include <rendering/GpuProfiler.h>
+
+using namespace Rendering;
+
+
+void GpuProfiler::Release()
+{
+    for (Buffer& buffer : m_buffers) {
+        glDeleteQueries(static_cast<GLsizei>(buffer.queries.size()), buffer.queries.data());
+        buffer = {};
+    }
+    m_depth = 0;
+}
+
+
+/******************************************************************************/
+/*!
+\fn     bool BeginFrame(std::uint64_t frameIndex)
+\brief
+        Move on to the next buffer of queries: the frame that last used it is
+        added to the log if the GPU is done with all of its queries, dropped
+        otherwise, and the buffer is handed to this frame.
+\return
+        Whether a frame was added to the log.
+*/
+/******************************************************************************/
+bool GpuProfiler::BeginFrame(std::uint64_t frameIndex)
+{
+    m_current = (m_current + 1) % NUM_BUFFERS;
+    Buffer& buffer = m_buffers[m_current];
+
+    bool added = false;
+    if (buffer.passes.empty() == false)
+    {
+        bool done = true;
+        for (size_t q = 0; q < buffer.passes.size() && done; ++q) {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(buffer.queries[q], GL_QUERY_RESULT_AVAILABLE, &available);
+            done = available == GL_TRUE;
+        }
+
+        if (done) {
+            std::vector<float> passMs(m_log.GetNumPasses(), ProfileLog::NOT_RUN);
+            for (size_t q = 0; q < buffer.passes.size(); ++q) {
+                GLuint64 elapsedNs = 0;
+                glGetQueryObjectui64v(buffer.queries[q], GL_QUERY_RESULT, &elapsedNs);
+                float& ms = passMs[buffer.passes[q]];
+                ms = (ms == ProfileLog::NOT_RUN ? 0.f : ms) + static_cast<float>(elapsedNs) * 1e-6f;
+            }
+            m_log.AddFrame(buffer.frameIndex, std::move(passMs));
+            added = true;
+        }
+        else {
+            ++m_numDropped;
+        }
+    }
+
+    buffer.passes.clear();
+    buffer.frameIndex = frameIndex;
+    return added;
+}
+
+
+void GpuProfiler::Begin(const char* pass)
+{
+    if (m_depth++ > 0) {
+        return;
+    }
+
+    Buffer& buffer = m_buffers[m_current];
+    if (buffer.passes.size() == buffer.queries.size()) {
+        GLuint query;
+        glGenQueries(1, &query);
+        buffer.queries.push_back(query);
+    }
+    glBeginQuery(GL_TIME_ELAPSED, buffer.queries[buffer.passes.size()]);
+    buffer.passes.push_back(m_log.GetPassIndex(pass));
+}
+
+
+void GpuProfiler::End()
+{
+    if (--m_depth == 0) {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+}
@@ -0,0 +1,136 @@
+#include <rendering/HeadlessContext.h>
+#include <utilities/Logger.h>
+
+#ifdef RIGIDBODYLAB_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+#endif
+
+using namespace Rendering;
+
+#ifdef RIGIDBODYLAB_HAS_EGL
+
+namespace
+{
+    bool HasExtension(EGLDisplay display, const char* name)
+    {
+        const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+        return extensions != nullptr && std::strstr(extensions, name) != nullptr;
+    }
+
+    /*  The surfaceless platform needs neither a display server nor a GPU */
+    EGLDisplay GetDisplay()
+    {
+        if (HasExtension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+            auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+            if (getPlatformDisplay != nullptr) {
+                EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+                if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+                    return display;
+                }
+            }
+        }
+        EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+            return display;
+        }
+        return EGL_NO_DISPLAY;
+    }
+}
+
+
+/******************************************************************************/
+/*!
+\fn     bool Create(int majorVersion, int minorVersion)
+\brief
+        Create a core profile context of the given version and make it
+        current, without any surface.
+\return
+        Whether the context was created; the reason is logged otherwise.
+*/
+/******************************************************************************/
+bool HeadlessContext::Create(int majorVersion, int minorVersion)
+{
+    Destroy();
+
+    EGLDisplay display = GetDisplay();
+    if (display == EGL_NO_DISPLAY) {
+        Logger::Log("Error: no EGL display for the headless context");
+        return false;
+    }
+    m_display = display;
+
+    if (HasExtension(display, "EGL_KHR_surfaceless_context") == false || eglBindAPI(EGL_OPENGL_API) == EGL_FALSE) {
+        Logger::Log("Error: EGL cannot make an OpenGL context without a surface");
+        Destroy();
+        return false;
+    }
+
+    const EGLint configAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config{};
+    EGLint numConfigs = 0;
+    eglChooseConfig(display, configAttribs, &config, 1, &numConfigs);
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE };
+    // no config is fine where EGL_KHR_no_config_context is supported, since nothing is ever drawn to a surface
+    EGLContext context = eglCreateContext(display, numConfigs > 0 ? config : EGLConfig{}, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        Logger::Log("Error: cannot create an OpenGL ", majorVersion, ".", minorVersion, " core context with EGL");
+        Destroy();
+        return false;
+    }
+    m_context = context;
+
+    if (eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_FALSE) {
+        Logger::Log("Error: cannot make the headless context current");
+        Destroy();
+        return false;
+    }
+    Logger::Log("Renderer: headless OpenGL context from ", eglQueryString(display, EGL_VENDOR));
+    return true;
+}
+
+
+void HeadlessContext::Destroy()
+{
+    if (m_display == nullptr) {
+        return;
+    }
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_context != nullptr) {
+        eglDestroyContext(m_display, m_context);
+    }
+    eglTerminate(m_display);
+    m_context = nullptr;
+    m_display = nullptr;
+}
+
+
+void* HeadlessContext::GetProcAddress(const char* name)
+{
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+#else
+
+bool HeadlessContext::Create(int, int)
+{
+    Logger::Log("Error: this build has no headless context (EGL was not found)");
+    return false;
+}
+
+void HeadlessContext::Destroy()
+{
+}
+
+void* HeadlessContext::GetProcAddress(const char*)
+{
+    return nullptr;
+}
+
+#endif
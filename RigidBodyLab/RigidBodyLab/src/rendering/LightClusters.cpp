@@ -0,0 +1,139 @@
+#include <rendering/LightClusters.h>
+#include <math/SimdKernels.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace Rendering;
+
+
+/******************************************************************************/
+/*!
+\fn     void SetProjection(const Mat4& projMat, float nearPlane, float farPlane)
+\brief
+        Rebuild the view-space boxes of the clusters for a perspective
+        projection. Nothing is done if the projection did not change.
+        A cluster is the part of its tile's frustum between two slice depths;
+        its box encloses the 8 corners of that part.
+*/
+/******************************************************************************/
+void LightClusters::SetProjection(const Mat4& projMat, float nearPlane, float farPlane)
+{
+    if (projMat == m_projMat && nearPlane == m_nearPlane && farPlane == m_farPlane) {
+        return;
+    }
+    m_projMat = projMat;
+    m_nearPlane = nearPlane;
+    m_farPlane = farPlane;
+
+    m_sliceScale = NUM_SLICES / std::log(farPlane / nearPlane);
+    m_sliceBias = -std::log(nearPlane) * m_sliceScale;
+
+    for (std::vector<float>* component : { &m_centerX, &m_centerY, &m_centerZ, &m_halfX, &m_halfY, &m_halfZ }) {
+        component->resize(NUM_CLUSTERS);
+    }
+    m_overlap.resize(TILES_PER_SLICE);
+    m_ranges.assign(2 * NUM_CLUSTERS, 0);
+
+    /*  A view-space point at depth d (z = -d) projects to ndc.x = (P[0][0] * x - P[2][0] * d) / d,
+        so the tile borders at depth d are x = d * (ndc.x + P[2][0]) / P[0][0], same for y.
+    */
+    auto Extent = [](float ndcMin, float ndcMax, float offset, float scale, float dNear, float dFar, float& center, float& half) {
+        const float a = dNear * (ndcMin + offset) / scale, b = dNear * (ndcMax + offset) / scale;
+        const float c = dFar * (ndcMin + offset) / scale, d = dFar * (ndcMax + offset) / scale;
+        const float lo = std::min({ a, b, c, d }), hi = std::max({ a, b, c, d });
+        center = 0.5f * (lo + hi);
+        half = 0.5f * (hi - lo);
+    };
+
+    const float depthRatio = farPlane / nearPlane;
+    for (int s = 0; s < NUM_SLICES; ++s)
+    {
+        const float dNear = nearPlane * std::pow(depthRatio, static_cast<float>(s) / NUM_SLICES);
+        const float dFar = nearPlane * std::pow(depthRatio, static_cast<float>(s + 1) / NUM_SLICES);
+
+        for (int ty = 0; ty < TILES_Y; ++ty) {
+            for (int tx = 0; tx < TILES_X; ++tx)
+            {
+                const int c = s * TILES_PER_SLICE + ty * TILES_X + tx;
+                Extent(-1.f + 2.f * tx / TILES_X, -1.f + 2.f * (tx + 1) / TILES_X, projMat[2][0], projMat[0][0],
+                    dNear, dFar, m_centerX[c], m_halfX[c]);
+                Extent(-1.f + 2.f * ty / TILES_Y, -1.f + 2.f * (ty + 1) / TILES_Y, projMat[2][1], projMat[1][1],
+                    dNear, dFar, m_centerY[c], m_halfY[c]);
+                m_centerZ[c] = -0.5f * (dNear + dFar);
+                m_halfZ[c] = 0.5f * (dFar - dNear);
+            }
+        }
+    }
+}
+
+
+int LightClusters::GetSlice(float depth) const
+{
+    const int slice = static_cast<int>(std::floor(std::log(depth) * m_sliceScale + m_sliceBias));
+    return std::clamp(slice, 0, NUM_SLICES - 1);
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void AssignLights(const Vec4* lightSpheresVF, int numLights)
+\brief
+        Rebuild the per-cluster light lists. Every light is only tested
+        against the slices its depth range [depth - radius, depth + radius]
+        crosses, one slice of boxes per SIMD call.
+        The (cluster, light) pairs found are then counting-sorted by cluster,
+        which keeps the lights of a cluster in increasing index order.
+\param  lightSpheresVF
+        Per light, the view-frame position in xyz and the radius of
+        influence in w.
+*/
+/******************************************************************************/
+void LightClusters::AssignLights(const Vec4* lightSpheresVF, int numLights)
+{
+    const Math::SimdKernelTable& kernels = Math::GetSimdKernels();
+
+    m_pairs.clear();
+    std::fill(m_ranges.begin(), m_ranges.end(), 0);
+
+    for (int l = 0; l < numLights; ++l)
+    {
+        const Vec4& sphere = lightSpheresVF[l];
+        const float depth = -sphere.z;
+        if (depth + sphere.w < m_nearPlane || depth - sphere.w > m_farPlane) {
+            continue;
+        }
+
+        const int firstSlice = GetSlice(std::max(depth - sphere.w, m_nearPlane));
+        const int lastSlice = GetSlice(std::min(depth + sphere.w, m_farPlane));
+        for (int s = firstSlice; s <= lastSlice; ++s)
+        {
+            const int base = s * TILES_PER_SLICE;
+            kernels.sphereOverlapsBoxes(&sphere.x,
+                { m_centerX.data() + base, m_centerY.data() + base, m_centerZ.data() + base },
+                { m_halfX.data() + base, m_halfY.data() + base, m_halfZ.data() + base },
+                m_overlap.data(), TILES_PER_SLICE);
+
+            for (int t = 0; t < TILES_PER_SLICE; ++t) {
+                if (m_overlap[t] != 0.f) {
+                    m_pairs.push_back(base + t);
+                    m_pairs.push_back(l);
+                    ++m_ranges[2 * (base + t) + 1];
+                }
+            }
+        }
+    }
+
+    /*  Offsets first point past the end of each cluster's list, and walking the pairs
+        backwards moves them down to the start while filling the list in order.
+    */
+    std::uint32_t offset = 0;
+    for (int c = 0; c < NUM_CLUSTERS; ++c) {
+        offset += m_ranges[2 * c + 1];
+        m_ranges[2 * c] = offset;
+    }
+    m_indices.resize(offset);
+    for (size_t p = m_pairs.size(); p > 0; p -= 2) {
+        const std::uint32_t cluster = m_pairs[p - 2];
+        m_indices[--m_ranges[2 * cluster]] = m_pairs[p - 1];
+    }
+}
@@ -1,9 +1,12 @@
 #ifdef _MSC_VER
 #define _CRT_SECURE_NO_WARNINGS
+#define strtok_r strtok_s
 #endif
 
 #include <rendering/Mesh.h>
 #include <algorithm>//std::all_of
+#include <cfloat>
+#include <cstring>
 
 using namespace Rendering;
 using Math::Matrix4;
@@ -15,6 +18,7 @@ void addIndex(Mesh& mesh, int index);
 void ComputeTangentsBitangents(VertexBuffer& vertices, const IndexBuffer& indices);
 void ComputeNormals(Mesh& mesh);
 void ComputeUVs(Mesh& mesh);
+void ComputeVertexBounds(Mesh& mesh);
 
 Math::Matrix4 Rendering::Mesh::GetBoundingBoxMat() const {
     return Matrix4::Scale(m_boundingBox.extents) *Matrix4::Translate(-m_boundingBox.center);
@@ -62,6 +66,8 @@ Mesh Rendering::Mesh::CreatePlane(int stacks, int slices)
     BuildIndexBuffer(stacks, slices, mesh);
     ComputeTangentsBitangents(mesh.vertexBuffer, mesh.indexBuffer);
 
+    ComputeVertexBounds(mesh);
+
     return mesh;
 }
 
@@ -150,6 +156,8 @@ Mesh Rendering::Mesh::CreateCube(int length, int height, int width)
     mesh.numIndices = mesh.indexBuffer.size();
     mesh.numTris = mesh.numIndices / 3;
 
+    ComputeVertexBounds(mesh);
+
     return mesh;
 }
 
@@ -204,6 +212,8 @@ Mesh Rendering::Mesh::CreateSphere(int stacks, int slices)
     BuildIndexBuffer(stacks, slices, mesh);
     ComputeTangentsBitangents(mesh.vertexBuffer, mesh.indexBuffer);
 
+    ComputeVertexBounds(mesh);
+
     return mesh;
 }
 
@@ -389,7 +399,7 @@ bool readDataLine(char* lineBuf, int* lineNum, FILE* fp, int MAX_LINE_LEN);
 
 /******************************************************************************/
 /*!
-\fn     bool LoadOBJMesh(Mesh &mesh, char *filename)
+\fn     bool LoadOBJMesh(Mesh &mesh, const char *filename)
 \brief
         Load a mesh from an OBJ file. This function supports reading vertex
         positions and normals, and faces containing any number of vertices.
@@ -402,7 +412,7 @@ bool readDataLine(char* lineBuf, int* lineNum, FILE* fp, int MAX_LINE_LEN);
         The vertex index to be added.
 */
 /******************************************************************************/
-Mesh Rendering::Mesh::LoadOBJMesh(char* filename, bool flipX)
+Mesh Rendering::Mesh::LoadOBJMesh(const char* filename, bool flipX)
 {
     Mesh mesh;
     Vec3 minPoint(FLT_MAX, FLT_MAX, FLT_MAX);
@@ -413,7 +423,7 @@ Mesh Rendering::Mesh::LoadOBJMesh(char* filename, bool flipX)
     int numLines;
 
     FILE* fp;
-    if (fopen_s(&fp, filename, "r") != 0)
+    if ((fp = fopen(filename, "r")) == nullptr)
     {
         std::cerr << "Failed to open " << filename << "\n";
         exit(1);
@@ -441,7 +451,7 @@ Mesh Rendering::Mesh::LoadOBJMesh(char* filename, bool flipX)
 		{
 			char dataType[MAX_LINE_LEN + 1];
 			float x, y, z;
-			sscanf_s(lineBuf, "%s %f %f %f", dataType, sizeof(dataType), &x, &y, &z);
+			sscanf(lineBuf, "%s %f %f %f", dataType, &x, &y, &z);   // dataType is as long as the line
 
             // flip the x coordinate if flipX is true
             if (flipX) {
@@ -475,12 +485,12 @@ Mesh Rendering::Mesh::LoadOBJMesh(char* filename, bool flipX)
 			char* tokWS, * ptrFront, * ptrRear;
 			char* ct;
 
-			tokWS = strtok_s(lineBuf, " ", &ct);
-			tokWS = strtok_s(NULL, " ", &ct);
+			tokWS = strtok_r(lineBuf, " ", &ct);
+			tokWS = strtok_r(NULL, " ", &ct);
 			while (tokWS != NULL)
 			{
 				faceData.push_back(tokWS);
-				tokWS = strtok_s(NULL, " ", &ct);
+				tokWS = strtok_r(NULL, " ", &ct);
 			}
 
 			if (faceData.size() > 3)
@@ -504,7 +514,7 @@ Mesh Rendering::Mesh::LoadOBJMesh(char* filename, bool flipX)
 				{
 					char* tokFront, * tokRear, * cF;
 					ptrRear = strrchr(faceData[i], '/');
-					tokFront = strtok_s(faceData[i], "/", &cF);
+					tokFront = strtok_r(faceData[i], "/", &cF);
 					vertNum = atoi(tokFront) - 1;
 
 					if (ptrRear == ptrFront)
@@ -516,10 +526,10 @@ Mesh Rendering::Mesh::LoadOBJMesh(char* filename, bool flipX)
 					{
 						if (ptrRear != ptrFront + 1)
 						{
-							tokRear = strtok_s(NULL, "/", &cF);
+							tokRear = strtok_r(NULL, "/", &cF);
 						}
 
-						tokRear = strtok_s(NULL, "/", &cF);
+						tokRear = strtok_r(NULL, "/", &cF);
 						mesh.indexBuffer.push_back(vertNum);
 						++mesh.numIndices;
 					}
@@ -543,6 +553,8 @@ Mesh Rendering::Mesh::LoadOBJMesh(char* filename, bool flipX)
     mesh.m_boundingBox.center = (minPoint + maxPoint) * 0.5f;// (=0.5 * 0.5)
     mesh.m_boundingBox.extents = 1.f / (maxPoint - minPoint);
     
+    ComputeVertexBounds(mesh);
+
     return mesh;
 }
 
@@ -691,8 +703,35 @@ void ComputeUVs(Mesh& mesh)
     }
 }
 
+/******************************************************************************/
+/*!
+\fn     void ComputeVertexBounds(Mesh &mesh)
+\brief
+        Compute the box enclosing the vertex positions of the mesh.
+\param  mesh
+        The mesh whose vertex buffer is already complete
+*/
+/******************************************************************************/
+void ComputeVertexBounds(Mesh& mesh)
+{
+    if (mesh.vertexBuffer.empty()) {
+        return;
+    }
+
+    Vec3 minPoint = mesh.vertexBuffer[0].pos;
+    Vec3 maxPoint = minPoint;
+    for (const Vertex& v : mesh.vertexBuffer) {
+        minPoint = Min(minPoint, v.pos);
+        maxPoint = Max(maxPoint, v.pos);
+    }
+
+    mesh.m_vertexBoundsCenter = (minPoint + maxPoint) * 0.5f;
+    mesh.m_vertexBoundsHalfSize = (maxPoint - minPoint) * 0.5f;
+}
+
 Rendering::Mesh::Mesh()
-    : numVertices(0), numTris(0), numIndices(0), VAO{}, VBO{}, IBO{}, m_boundingBox{}
+    : numVertices(0), numTris(0), numIndices(0), baseVertex{}, firstIndex{}, drawID{}, m_boundingBox{}
+    , m_vertexBoundsCenter{}, m_vertexBoundsHalfSize{}
 {
     vertexBuffer.clear();
     indexBuffer.clear();
@@ -0,0 +1,259 @@
+#include <rendering/OcclusionBuffer.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace Rendering;
+
+namespace
+{
+    // out = a * b, column-major
+    void MultiplyMat4(const float* a, const float* b, float* out)
+    {
+        for (int col = 0; col < 4; ++col) {
+            for (int row = 0; row < 4; ++row) {
+                out[col * 4 + row] = a[row] * b[col * 4] + a[4 + row] * b[col * 4 + 1]
+                                   + a[8 + row] * b[col * 4 + 2] + a[12 + row] * b[col * 4 + 3];
+            }
+        }
+    }
+
+    void TransformToClip(const float* mat, float x, float y, float z, float* clip)
+    {
+        for (int row = 0; row < 4; ++row) {
+            clip[row] = mat[row] * x + mat[4 + row] * y + mat[8 + row] * z + mat[12 + row];
+        }
+    }
+
+    // distance to the near plane in clip space, z >= -w inside
+    float NearDistance(const float* clip) { return clip[2] + clip[3]; }
+}
+
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+    : m_width{ (width + Math::OCCLUSION_ROW_ALIGNMENT - 1) / Math::OCCLUSION_ROW_ALIGNMENT * Math::OCCLUSION_ROW_ALIGNMENT }
+    , m_height{ height }
+    , m_depth(static_cast<std::size_t>(m_width) * height, 1.f)
+{
+}
+
+
+/******************************************************************************/
+/*!
+\fn     OccluderMesh Simplify(const float* positions, std::size_t stride, const int* indices, std::size_t numIndices, std::size_t maxTriangles)
+\brief
+        Build an occluder from mesh data by keeping its maxTriangles largest
+        triangles. Small triangles hide little, and dropping triangles keeps
+        the occluder inside the mesh.
+\param  positions
+        xyz of the first vertex, the next ones following every stride floats.
+*/
+/******************************************************************************/
+OccluderMesh OcclusionBuffer::Simplify(const float* positions, std::size_t stride, const int* indices, std::size_t numIndices,
+    std::size_t maxTriangles)
+{
+    const std::size_t numTris = numIndices / 3;
+    std::vector<float> areas(numTris);
+    for (std::size_t t = 0; t < numTris; ++t) {
+        const float* p0 = positions + indices[3 * t] * stride;
+        const float* p1 = positions + indices[3 * t + 1] * stride;
+        const float* p2 = positions + indices[3 * t + 2] * stride;
+        const float e1[3]{ p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        const float e2[3]{ p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        const float cx = e1[1] * e2[2] - e1[2] * e2[1];
+        const float cy = e1[2] * e2[0] - e1[0] * e2[2];
+        const float cz = e1[0] * e2[1] - e1[1] * e2[0];
+        areas[t] = cx * cx + cy * cy + cz * cz;     // squared, only the order matters
+    }
+
+    std::vector<std::size_t> order(numTris);
+    std::iota(order.begin(), order.end(), std::size_t{ 0 });
+    const std::size_t numKept = std::min(numTris, maxTriangles);
+    std::partial_sort(order.begin(), order.begin() + numKept, order.end(),
+        [&areas](std::size_t a, std::size_t b) { return areas[a] > areas[b]; });
+
+    /*  Only the vertices of the kept triangles are copied */
+    OccluderMesh occluder;
+    std::vector<unsigned> remap;
+    for (std::size_t k = 0; k < numKept; ++k) {
+        for (int v = 0; v < 3; ++v) {
+            const std::size_t src = static_cast<std::size_t>(indices[3 * order[k] + v]);
+            if (src >= remap.size()) {
+                remap.resize(src + 1, ~0u);
+            }
+            if (remap[src] == ~0u) {
+                remap[src] = static_cast<unsigned>(occluder.positions.size() / 3);
+                occluder.positions.insert(occluder.positions.end(), positions + src * stride, positions + src * stride + 3);
+            }
+            occluder.indices.push_back(remap[src]);
+        }
+    }
+    return occluder;
+}
+
+
+/*  Start a new frame of the buffer for the camera with the given projection * view */
+void OcclusionBuffer::Begin(const float* viewProj)
+{
+    std::copy(viewProj, viewProj + 16, m_viewProj);
+    std::fill(m_depth.begin(), m_depth.end(), 1.f);
+    m_numTriangles = 0;
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void AddOccluder(const OccluderMesh& mesh, const float* model)
+\brief
+        Draw an occluder into the buffer. Its triangles are clipped to the
+        near plane, projected to the buffer and rasterized in one batch.
+\param  model
+        Model matrix of the occluder, 16 column-major floats.
+*/
+/******************************************************************************/
+void OcclusionBuffer::AddOccluder(const OccluderMesh& mesh, const float* model)
+{
+    float mvp[16];
+    MultiplyMat4(m_viewProj, model, mvp);
+
+    const std::size_t numVertices = mesh.positions.size() / 3;
+    m_clipPositions.resize(4 * numVertices);
+    for (std::size_t v = 0; v < numVertices; ++v) {
+        const float* p = &mesh.positions[3 * v];
+        TransformToClip(mvp, p[0], p[1], p[2], &m_clipPositions[4 * v]);
+    }
+
+    m_triangles.clear();
+    for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        ClipAndProject(&m_clipPositions[4 * mesh.indices[i]], &m_clipPositions[4 * mesh.indices[i + 1]],
+            &m_clipPositions[4 * mesh.indices[i + 2]]);
+    }
+
+    const std::size_t numTris = m_triangles.size() / 9;
+    Math::GetSimdKernels().rasterizeOccluders(m_triangles.data(), numTris, m_depth.data(), m_width, m_height);
+    m_numTriangles += numTris;
+}
+
+
+/*  Sutherland-Hodgman against the near plane only: the rasterizer clamps to the buffer itself */
+void OcclusionBuffer::ClipAndProject(const float* a, const float* b, const float* c)
+{
+    const float* in[3]{ a, b, c };
+    float dist[3];
+    int numInside = 0;
+    for (int v = 0; v < 3; ++v) {
+        dist[v] = NearDistance(in[v]);
+        numInside += dist[v] >= 0.f;
+    }
+    if (numInside == 0) {
+        return;
+    }
+    if (numInside == 3) {
+        EmitTriangle(a, b, c);
+        return;
+    }
+
+    float polygon[4][4];
+    int numPoints = 0;
+    for (int v = 0; v < 3; ++v) {
+        const int next = (v + 1) % 3;
+        if (dist[v] >= 0.f) {
+            std::copy(in[v], in[v] + 4, polygon[numPoints++]);
+        }
+        if ((dist[v] >= 0.f) != (dist[next] >= 0.f)) {
+            // always from the inside end, so that a triangle sharing the edge gets the very same point
+            const int inside = dist[v] >= 0.f ? v : next, outside = inside == v ? next : v;
+            const float t = dist[inside] / (dist[inside] - dist[outside]);
+            for (int e = 0; e < 4; ++e) {
+                polygon[numPoints][e] = in[inside][e] + t * (in[outside][e] - in[inside][e]);
+            }
+            ++numPoints;
+        }
+    }
+    for (int v = 2; v < numPoints; ++v) {
+        EmitTriangle(polygon[0], polygon[v - 1], polygon[v]);
+    }
+}
+
+
+void OcclusionBuffer::EmitTriangle(const float* a, const float* b, const float* c)
+{
+    for (const float* clip : { a, b, c }) {
+        const float w = std::max(clip[3], 1e-6f);
+        m_triangles.push_back((clip[0] / w * 0.5f + 0.5f) * m_width);
+        m_triangles.push_back((clip[1] / w * 0.5f + 0.5f) * m_height);
+        m_triangles.push_back(clip[2] / w * 0.5f + 0.5f);
+    }
+}
+
+
+/******************************************************************************/
+/*!
+\fn     bool IsBoxVisible(const float* center, const float* halfExtents) const
+\brief
+        Whether any part of a world-space box may be seen past the occluders:
+        its nearest depth is compared against every pixel its projection
+        touches. Boxes crossing the near plane are always visible, and so
+        are boxes off the buffer (frustum culling is not done here).
+*/
+/******************************************************************************/
+bool OcclusionBuffer::IsBoxVisible(const float* center, const float* halfExtents) const
+{
+    float minX = static_cast<float>(m_width), maxX = 0.f;
+    float minY = static_cast<float>(m_height), maxY = 0.f;
+    float minZ = 1.f;
+    for (int corner = 0; corner < 8; ++corner) {
+        float clip[4];
+        TransformToClip(m_viewProj,
+            center[0] + ((corner & 1) ? halfExtents[0] : -halfExtents[0]),
+            center[1] + ((corner & 2) ? halfExtents[1] : -halfExtents[1]),
+            center[2] + ((corner & 4) ? halfExtents[2] : -halfExtents[2]), clip);
+        if (NearDistance(clip) < 0.f || clip[3] <= 0.f) {
+            return true;
+        }
+        const float x = (clip[0] / clip[3] * 0.5f + 0.5f) * m_width;
+        const float y = (clip[1] / clip[3] * 0.5f + 0.5f) * m_height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, clip[2] / clip[3] * 0.5f + 0.5f);
+    }
+
+    const int x0 = std::max(static_cast<int>(std::floor(minX)), 0);
+    const int x1 = std::min(static_cast<int>(std::floor(maxX)), m_width - 1);
+    const int y0 = std::max(static_cast<int>(std::floor(minY)), 0);
+    const int y1 = std::min(static_cast<int>(std::floor(maxY)), m_height - 1);
+    if (x0 > x1 || y0 > y1) {
+        return true;
+    }
+
+    for (int y = y0; y <= y1; ++y) {
+        const float* row = &m_depth[static_cast<std::size_t>(y) * m_width];
+        for (int x = x0; x <= x1; ++x) {
+            if (minZ <= row[x]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+/*  visible[i] is cleared for the boxes found hidden, and their number returned; boxes already at 0 are not tested */
+std::size_t OcclusionBuffer::CullBoxes(Math::ConstVec3SoA centers, Math::ConstVec3SoA halfExtents, float* visible, std::size_t count) const
+{
+    std::size_t numHidden = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (visible[i] == 0.f) {
+            continue;
+        }
+        const float center[3]{ centers.x[i], centers.y[i], centers.z[i] };
+        const float half[3]{ halfExtents.x[i], halfExtents.y[i], halfExtents.z[i] };
+        if (IsBoxVisible(center, half) == false) {
+            visible[i] = 0.f;
+            ++numHidden;
+        }
+    }
+    return numHidden;
+}
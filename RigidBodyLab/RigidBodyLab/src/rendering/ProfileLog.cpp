@@ -0,0 +1,106 @@
+#include <rendering/ProfileLog.h>
+#include <algorithm>
+#include <fstream>
+
+using namespace Rendering;
+
+
+/*  Time of a pass, 0 if it did not run; TOTAL sums the passes that ran */
+float ProfileLog::Frame::GetMs(int pass) const
+{
+    if (pass == TOTAL) {
+        float total = 0.f;
+        for (float ms : passMs) {
+            total += std::max(ms, 0.f);
+        }
+        return total;
+    }
+    return pass < static_cast<int>(passMs.size()) ? std::max(passMs[pass], 0.f) : 0.f;
+}
+
+
+/*  Index of the pass with that name, added if it is new */
+int ProfileLog::GetPassIndex(const std::string& name)
+{
+    const auto found = std::find(m_passNames.begin(), m_passNames.end(), name);
+    if (found != m_passNames.end()) {
+        return static_cast<int>(found - m_passNames.begin());
+    }
+    m_passNames.push_back(name);
+    return static_cast<int>(m_passNames.size()) - 1;
+}
+
+
+void ProfileLog::AddFrame(std::uint64_t index, std::vector<float> passMs)
+{
+    if (m_frames.size() == MAX_FRAMES) {
+        m_frames.pop_front();
+    }
+    m_frames.push_back({ index, std::move(passMs) });
+}
+
+
+/*  Mean over the last numFrames frames, or fewer if not that many were recorded */
+float ProfileLog::GetAverageMs(int pass, std::size_t numFrames) const
+{
+    const std::size_t count = std::min(numFrames, m_frames.size());
+    if (count == 0) {
+        return 0.f;
+    }
+    float sum = 0.f;
+    for (std::size_t i = m_frames.size() - count; i < m_frames.size(); ++i) {
+        sum += m_frames[i].GetMs(pass);
+    }
+    return sum / count;
+}
+
+
+float ProfileLog::GetMaxMs(int pass, std::size_t numFrames) const
+{
+    const std::size_t count = std::min(numFrames, m_frames.size());
+    float maxMs = 0.f;
+    for (std::size_t i = m_frames.size() - count; i < m_frames.size(); ++i) {
+        maxMs = std::max(maxMs, m_frames[i].GetMs(pass));
+    }
+    return maxMs;
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void WriteCsv(std::ostream& out) const
+\brief
+        Write every kept frame as one row: the frame index, the time of each
+        pass in ms, empty where the pass did not run, and their total.
+*/
+/******************************************************************************/
+void ProfileLog::WriteCsv(std::ostream& out) const
+{
+    out << "frame";
+    for (const std::string& name : m_passNames) {
+        out << ',' << name;
+    }
+    out << ",total\n";
+
+    for (const Frame& frame : m_frames) {
+        out << frame.index;
+        for (int pass = 0; pass < GetNumPasses(); ++pass) {
+            out << ',';
+            if (pass < static_cast<int>(frame.passMs.size()) && frame.passMs[pass] != NOT_RUN) {
+                out << frame.passMs[pass];
+            }
+        }
+        out << ',' << frame.GetMs(TOTAL) << '\n';
+    }
+}
+
+
+bool ProfileLog::WriteCsv(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+    WriteCsv(file);
+    return static_cast<bool>(file);
+}
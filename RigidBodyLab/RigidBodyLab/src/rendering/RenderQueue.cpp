@@ -0,0 +1,91 @@
+#include <rendering/RenderQueue.h>
+#include <array>
+#include <cstring>
+
+using namespace Rendering;
+
+
+/******************************************************************************/
+/*!
+\fn     std::uint64_t MakeKey(unsigned pass, unsigned program, bool cullFront, unsigned texture, unsigned mesh, float viewDepth)
+\brief
+        Pack the state of a draw into a sort key. Fields wider than their slot
+        are truncated to it.
+\param  viewDepth
+        Distance from the camera along the view direction. Negative values
+        (behind the camera) are clamped to 0.
+\return
+        The key, see the layout in RenderQueue.h.
+*/
+/******************************************************************************/
+std::uint64_t RenderQueue::MakeKey(unsigned pass, unsigned program, bool cullFront, unsigned texture, unsigned mesh, float viewDepth)
+{
+    auto Bits = [](unsigned value, int shift, int bits) {
+        return (static_cast<std::uint64_t>(value) & ((std::uint64_t(1) << bits) - 1)) << shift;
+    };
+
+    /*  The bit pattern of a non-negative float grows with its value,
+        so its top 16 bits (exponent and 7 bits of mantissa) are a valid depth ordering.
+    */
+    const float depth = viewDepth > 0.f ? viewDepth : 0.f;
+    std::uint32_t depthBits;
+    std::memcpy(&depthBits, &depth, sizeof(depthBits));
+
+    return Bits(pass, PASS_SHIFT, PASS_BITS)
+         | Bits(program, PROGRAM_SHIFT, PROGRAM_BITS)
+         | Bits(cullFront ? 1 : 0, CULL_SHIFT, CULL_BITS)
+         | Bits(texture, TEXTURE_SHIFT, TEXTURE_BITS)
+         | Bits(mesh, MESH_SHIFT, MESH_BITS)
+         | Bits(depthBits >> (32 - DEPTH_BITS), DEPTH_SHIFT, DEPTH_BITS);
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void Sort()
+\brief
+        Stable LSD radix sort of the items by key, one byte per pass.
+        The histograms of all bytes are gathered in one sweep, and bytes that
+        are the same for every item (e.g. the unused low bits, or the pass when
+        only one is drawn) are skipped.
+*/
+/******************************************************************************/
+void RenderQueue::Sort()
+{
+    constexpr int NUM_DIGITS = sizeof(std::uint64_t);
+    constexpr int RADIX = 256;
+
+    const size_t count = m_items.size();
+    if (count < 2) {
+        return;
+    }
+
+    std::array<std::array<size_t, RADIX>, NUM_DIGITS> histograms{};
+    for (const Item& item : m_items) {
+        for (int d = 0; d < NUM_DIGITS; ++d) {
+            ++histograms[d][(item.key >> (d * 8)) & 0xFF];
+        }
+    }
+
+    m_scratch.resize(count);
+    for (int d = 0; d < NUM_DIGITS; ++d)
+    {
+        std::array<size_t, RADIX>& histogram = histograms[d];
+        if (histogram[(m_items[0].key >> (d * 8)) & 0xFF] == count) {
+            continue;
+        }
+
+        /*  Bucket counts to bucket starts */
+        size_t offset = 0;
+        for (size_t& bucket : histogram) {
+            const size_t bucketSize = bucket;
+            bucket = offset;
+            offset += bucketSize;
+        }
+
+        for (const Item& item : m_items) {
+            m_scratch[histogram[(item.key >> (d * 8)) & 0xFF]++] = item;
+        }
+        m_items.swap(m_scratch);
+    }
+}
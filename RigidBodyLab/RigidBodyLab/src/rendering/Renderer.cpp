@@ -17,11 +17,17 @@
 #include <physics/Collider.h>
 #include <input/input.h>
 #include <math/Math.h>
+#include <math/SimdKernels.h>
 #include <utilities/ToUnderlyingEnum.h>
+#include <utilities/ThreadPool.h>
 #include <image_io.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <ctime>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <chrono>
 
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
@@ -29,6 +35,7 @@
 using Rendering::Renderer;
 using Core::Object;
 using Core::Scene;
+using Rendering::GLStateCache;
 
 
 /******************************************************************************/
@@ -73,33 +80,50 @@ void Renderer::SetUpSphereUniformLocations()
 
 /******************************************************************************/
 /*!
-\fn     void SetUpVertexData(Mesh &mesh)
+\fn     void SetUpMeshBuffers()
 \brief
-        Create VAO (graphics state), VBO (vertex data state) and
-        IBO (vertex index state) for the mesh, and feed vertex data into
-        the shaders.
-\param  mesh
-        The input mesh, whose VAO/VBO/IBO members will be updated and data
-        will be sent to shaders.
+        Pack the vertex/index data of every mesh into one VBO and one IBO,
+        behind a single VAO, and feed vertex data into the shaders.
+        Each mesh remembers where it starts (baseVertex/firstIndex), so any
+        mesh can be drawn without rebinding anything.
+        Also keeps a simplified copy of each mesh for occlusion culling.
 */
 /******************************************************************************/
-void Renderer::SetUpVertexData(Mesh& mesh)
-{ 
-    glGenVertexArrays(1, &mesh.VAO);
-    glBindVertexArray(mesh.VAO);
+void Renderer::SetUpMeshBuffers()
+{
+    ResourceManager& resourceManager = ResourceManager::GetInstance();
+    const int NUM_MESHES = TO_INT(MeshID::NUM_MESHES);
+
+    VertexBuffer vertices;
+    IndexBuffer indices;
+    for (int i = 0; i < NUM_MESHES; ++i) {
+        Mesh& mesh = *resourceManager.GetMesh(static_cast<MeshID>(i));
+        mesh.baseVertex = static_cast<GLint>(vertices.size());
+        mesh.firstIndex = static_cast<GLuint>(indices.size());
+        mesh.drawID = i;
+        vertices.insert(vertices.end(), mesh.vertexBuffer.begin(), mesh.vertexBuffer.end());
+        indices.insert(indices.end(), mesh.indexBuffer.begin(), mesh.indexBuffer.end());
+
+        /*  CPU copy for the occlusion buffer, indexed by drawID like the meshes */
+        m_occluderMeshes.push_back(OcclusionBuffer::Simplify(&mesh.vertexBuffer[0].pos.x, sizeof(Vertex) / sizeof(float),
+            mesh.indexBuffer.data(), mesh.indexBuffer.size(), MAX_OCCLUDER_TRIANGLES));
+    }
 
-    glGenBuffers(1, &mesh.VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glGenVertexArrays(1, &m_meshVAO);
+    glBindVertexArray(m_meshVAO);
+
+    glGenBuffers(1, &m_meshVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_meshVBO);
     /*  Copy vertex attributes to GPU */
     glBufferData(GL_ARRAY_BUFFER,
-        mesh.numVertices * vertexSize, &mesh.vertexBuffer[0],
+        vertices.size() * vertexSize, vertices.data(),
         GL_STATIC_DRAW);
 
-    glGenBuffers(1, &mesh.IBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.IBO);
-    /*  Copy vertex indices to GPU */
+    glGenBuffers(1, &m_meshIBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_meshIBO);
+    /*  Copy vertex indices to GPU (indices stay mesh-relative, baseVertex offsets them) */
     glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-        mesh.numIndices * indexSize, &mesh.indexBuffer[0],
+        indices.size() * indexSize, indices.data(),
         GL_STATIC_DRAW);
 
     /*  Send vertex attributes to shaders */
@@ -109,32 +133,87 @@ void Renderer::SetUpVertexData(Mesh& mesh)
         glVertexAttribPointer(vLayout[i].location, vLayout[i].size, vLayout[i].type,
             vLayout[i].normalized, vertexSize, (void*)vLayout[i].offset);
     }
+
+    /*  Per-instance model-view matrices, one column per attribute location.
+        Each draw picks its first entry through the base instance.
+    */
+    glGenBuffers(1, &m_instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    for (int col = 0; col < 4; ++col)
+    {
+        const GLuint mvLoc = MV_MATRIX_LOCATION + col;
+        const GLuint nmvLoc = NMV_MATRIX_LOCATION + col;
+
+        glEnableVertexAttribArray(mvLoc);
+        glVertexAttribPointer(mvLoc, 4, GL_FLOAT, GL_FALSE, sizeof(ObjectMVMatrices),
+            (void*)(offsetof(ObjectMVMatrices, mv) + col * sizeof(Vec4)));
+        glVertexAttribDivisor(mvLoc, 1);
+
+        glEnableVertexAttribArray(nmvLoc);
+        glVertexAttribPointer(nmvLoc, 4, GL_FLOAT, GL_FALSE, sizeof(ObjectMVMatrices),
+            (void*)(offsetof(ObjectMVMatrices, nmv) + col * sizeof(Vec4)));
+        glVertexAttribDivisor(nmvLoc, 1);
+    }
+
+    glGenBuffers(1, &m_drawIndirectBuffer);
+    glBindVertexArray(0);
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void LoadMultiDrawIndirect()
+\brief
+        Look up glMultiDrawElementsIndirect, if the context offers it
+        (core since GL 4.3, or through ARB_multi_draw_indirect).
+*/
+/******************************************************************************/
+void Renderer::LoadMultiDrawIndirect()
+{
+    m_multiDrawElementsIndirect = nullptr;
+
+    GLint major{}, minor{};
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool supported = major > 4 || (major == 4 && minor >= 3);
+
+    GLint numExtensions{};
+    glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+    for (GLint i = 0; i < numExtensions && supported == false; ++i) {
+        supported = std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), "GL_ARB_multi_draw_indirect") == 0;
+    }
+
+    if (supported) {
+        m_multiDrawElementsIndirect = GetProcAddress("glMultiDrawElementsIndirect");
+    }
+    Logger::Log("Renderer: ", m_multiDrawElementsIndirect ? "glMultiDrawElementsIndirect" : "glDrawElementsIndirect (per command)", " for indirect draws");
 }
 
 void Rendering::Renderer::SetUpShaders() {
     for (const auto& pair : m_shaderFileMap) {
         auto& shader = m_shaders[TO_INT(pair.first)];
         shader.LoadShader(pair.second.vertexShaderPath, pair.second.fragmentShaderPath);
+        m_glState.ForgetProgram(shader.GetProgramID());     // freshly linked, the cached uniforms are stale
     }
 
     // (1) SKYBOX_PROG
-    m_shaders[TO_INT(ProgType::SKYBOX_PROG)].Use();
+    UseProgram(ProgType::SKYBOX_PROG);
     SetUpSkyBoxUniformLocations();
 
     // (2) SPHERE_PROG
-    m_shaders[TO_INT(ProgType::SPHERE_PROG)].Use();
+    UseProgram(ProgType::SPHERE_PROG);
     SetUpSphereUniformLocations();
 
     // (3) DEFERRED_GEOM 
-	m_shaders[TO_INT(ProgType::DEFERRED_GEOMPASS)].Use();
+	UseProgram(ProgType::DEFERRED_GEOMPASS);
 	SetUpDeferredGeomUniformLocations();
 
     // (4) DEFERRED_LIGHT
-    m_shaders[TO_INT(ProgType::SHADOW_MAP)].Use();
+    UseProgram(ProgType::SHADOW_MAP);
     SetUpShadowMappingUniformLocations();
 
     // (5) DEFERRED_LIGHT
-	m_shaders[TO_INT(ProgType::DEFERRED_LIGHTPASS)].Use();
+	UseProgram(ProgType::DEFERRED_LIGHTPASS);
 	SetUpDeferredLightUniformLocations();
 
 }
@@ -146,17 +225,21 @@ void Rendering::Renderer::SetUpShaders() {
 \brief
 Set up the buffers for the outputs of geometry pass, which will then be
 used for lighting computation in light pass.
+The compact layout (m_compactGBuffer) stores albedo in RGBA8 with the object
+type in alpha, the octahedral-encoded normal in RG16, and no position at
+all: the light pass rebuilds it from depth. That is 12 bytes per pixel
+instead of 32.
 */
 /******************************************************************************/
 void Rendering::Renderer::SetUpDeferredGeomPassTextures()
 {
-    /*  Set up 16-bit floating-point, 4-component texture for color output */
+    /*  Set up 16-bit floating-point (8-bit normalized if compact), 4-component texture for color output */
      // Albedo (Color)
     constexpr int OFFSET = 20;
     glActiveTexture(GL_TEXTURE0+OFFSET);
     glGenTextures(1, &m_gColorTexID);
     glBindTexture(GL_TEXTURE_2D, m_gColorTexID);
-    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, Camera::DISPLAY_SIZE, Camera::DISPLAY_SIZE);
+    glTexStorage2D(GL_TEXTURE_2D, 1, m_compactGBuffer ? GL_RGBA8 : GL_RGBA16F, Camera::DISPLAY_SIZE, Camera::DISPLAY_SIZE);
     glGenerateMipmap(GL_TEXTURE_2D);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
@@ -165,19 +248,22 @@ void Rendering::Renderer::SetUpDeferredGeomPassTextures()
     Using 32 bits instead of 16 bits coz position may vary more widely and require
     higher accuracy.
     */
-    glActiveTexture(GL_TEXTURE1 + OFFSET);
-    glGenTextures(1, &m_gPosTexID);
-    glBindTexture(GL_TEXTURE_2D, m_gPosTexID);
-    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB32F, Camera::DISPLAY_SIZE, Camera::DISPLAY_SIZE);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    if (m_compactGBuffer == false) {
+        glActiveTexture(GL_TEXTURE1 + OFFSET);
+        glGenTextures(1, &m_gPosTexID);
+        glBindTexture(GL_TEXTURE_2D, m_gPosTexID);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB32F, Camera::DISPLAY_SIZE, Camera::DISPLAY_SIZE);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    }
 
-    /*  Set up 16-bit floating-point, 3-component texture for normal output */
+    /*  Set up 16-bit floating-point, 3-component texture for normal output
+        (16-bit normalized, 2-component octahedral encoding if compact) */
     glActiveTexture(GL_TEXTURE2 + OFFSET);
     glGenTextures(1, &m_gNrmTexID);
     glBindTexture(GL_TEXTURE_2D, m_gNrmTexID);
-    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, Camera::DISPLAY_SIZE, Camera::DISPLAY_SIZE);
+    glTexStorage2D(GL_TEXTURE_2D, 1, m_compactGBuffer ? GL_RG16 : GL_RGBA16F, Camera::DISPLAY_SIZE, Camera::DISPLAY_SIZE);
     glGenerateMipmap(GL_TEXTURE_2D);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
@@ -210,6 +296,27 @@ void Rendering::Renderer::SetUpDeferredGeomPassTextures()
     }
 }
 
+
+/******************************************************************************/
+/*!
+\fn     void DeleteDeferredGeomPassTextures()
+\brief
+        Release the G-buffer, e.g. before setting it up again in the other
+        layout.
+*/
+/******************************************************************************/
+void Rendering::Renderer::DeleteDeferredGeomPassTextures()
+{
+    glDeleteTextures(1, &m_gColorTexID);
+    glDeleteTextures(1, &m_gPosTexID);
+    glDeleteTextures(1, &m_gNrmTexID);
+    glDeleteTextures(1, &m_gDepthTexID);
+    glDeleteFramebuffers(1, &m_deferredGeomPassFBO);
+
+    m_gColorTexID = m_gPosTexID = m_gNrmTexID = m_gDepthTexID = 0;
+    m_deferredGeomPassFBO = 0;
+}
+
 /******************************************************************************/
 /*!
 \fn     void SetUpLightPassQuads()
@@ -253,7 +360,7 @@ void Rendering::Renderer::SetUpShadowMappingTextures() {
     glGenTextures(1, &m_sShdowMapDepthTexID);
     glBindTexture(GL_TEXTURE_2D, m_sShdowMapDepthTexID);
     //glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,Camera::DISPLAY_SIZE, Camera::DISPLAY_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, Camera::DISPLAY_SIZE, Camera::DISPLAY_SIZE);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, ShadowAtlas::ATLAS_SIZE, ShadowAtlas::ATLAS_SIZE);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -270,9 +377,207 @@ void Rendering::Renderer::SetUpShadowMappingTextures() {
         Logger::Log("Error: Framebuffer is not complete!");
     }
 
+    // the cached static layer, same format and layout so that its tiles can be blitted into the shadow atlas
+    glGenFramebuffers(1, &m_shadowStaticFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_shadowStaticFBO);
+
+    glGenTextures(1, &m_sShadowStaticDepthTexID);
+    glBindTexture(GL_TEXTURE_2D, m_sShadowStaticDepthTexID);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, ShadowAtlas::ATLAS_SIZE, ShadowAtlas::ATLAS_SIZE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_sShadowStaticDepthTexID, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        Logger::Log("Error: Static shadow framebuffer is not complete!");
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+
+/******************************************************************************/
+/*!
+\fn     void SetUpSphereCubeMapTarget()
+\brief
+        Create the framebuffer the sphere cube map is rendered with, with its
+        own depth buffer. Each face of the cube map is checked for
+        completeness; if any fails, the driver cannot render to cube map faces
+        and the copy fallback gets its face texture and pixel buffer.
+*/
+/******************************************************************************/
+void Rendering::Renderer::SetUpSphereCubeMapTarget()
+{
+    const ResourceManager& resourceManager = ResourceManager::GetInstance();
+    const int faceSize = resourceManager.m_skyboxFaceSize;
+
+    glGenFramebuffers(1, &m_sphereCubeFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_sphereCubeFBO);
+
+    glGenRenderbuffers(1, &m_sphereCubeDepthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_sphereCubeDepthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, faceSize, faceSize);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_sphereCubeDepthRBO);
+
+    m_sphereCubeDirect = true;
+    for (int f = 0; f < TO_INT(CubeFaceID::NUM_FACES) && m_sphereCubeDirect; ++f) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, resourceManager.m_sphereTexID, 0);
+        m_sphereCubeDirect = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    if (m_sphereCubeDirect == false)
+    {
+        glGenTextures(1, &m_sphereFaceTexID);
+        glBindTexture(GL_TEXTURE_2D, m_sphereFaceTexID);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, faceSize, faceSize);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_sphereFaceTexID, 0);
+
+        glGenBuffers(1, &m_sphereFacePBO);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_sphereFacePBO);
+        glBufferData(GL_PIXEL_PACK_BUFFER, TO_INT(CubeFaceID::NUM_FACES) * faceSize * faceSize * 4, nullptr, GL_STREAM_COPY);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            Logger::Log("Error: Sphere cube map framebuffer is not complete!");
+        }
+    }
+    Logger::Log("Renderer: sphere cube map ", m_sphereCubeDirect ? "rendered straight into its faces" : "copied from a face texture through a pixel buffer");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void CaptureFrame()
+\brief
+        Queue the readback of the lit frame from the back buffer (the output
+        target when headless), before the GUI is drawn over it. The pixel
+        buffers follow the framebuffer size.
+*/
+/******************************************************************************/
+void Rendering::Renderer::CaptureFrame()
+{
+    int width, height;
+    GetOutputSize(width, height);
+    if (width != m_frameReadback.GetWidth() || height != m_frameReadback.GetHeight()) {
+        m_frameReadback.Init(width, height);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_outputFBO);
+    glReadBuffer(m_outputFBO ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+    m_frameReadback.Request(m_frameIndex, 0, 0);
+}
+
+/******************************************************************************/
+/*!
+\fn     void MarkSphereFacesStale(const Vec3& center, const Vec3& half)
+\brief
+        Flag the faces of the sphere cube map whose view, from where each was
+        last rendered, contains part of a box.
+        Face +x sees the points whose x is positive and not smaller than |y|
+        and |z| (likewise for the other faces). Within an axis-aligned box the
+        largest x and the smallest |y|, |z| are reached independently, which
+        makes the test exact.
+*/
+/******************************************************************************/
+void Rendering::Renderer::MarkSphereFacesStale(const Vec3& center, const Vec3& half)
+{
+    for (int f = 0; f < TO_INT(CubeFaceID::NUM_FACES); ++f)
+    {
+        if (m_sphereFaceStale[f]) {
+            continue;
+        }
+        /*  Faces come in (+axis, -axis) pairs: RIGHT/LEFT, TOP/BOTTOM, BACK/FRONT */
+        const int axis = f / 2;
+        const float sign = (f % 2 == 0) ? 1.f : -1.f;
+        const Vec3 lo = center - half - m_sphereFaceCamPos[f];
+        const Vec3 hi = center + half - m_sphereFaceCamPos[f];
+
+        const float reach = std::max(sign * lo[axis], sign * hi[axis]);
+        bool inView = reach > 0.f;
+        for (int other = 0; other < 3 && inView; ++other) {
+            if (other != axis) {
+                const float nearest = (lo[other] <= 0.f && hi[other] >= 0.f) ? 0.f : std::min(std::abs(lo[other]), std::abs(hi[other]));
+                inView = reach >= nearest;
+            }
+        }
+        m_sphereFaceStale[f] = inView;
+    }
+}
+
+
+/*  Flag the mirror texture when a box touches the frustum it was rendered with */
+void Rendering::Renderer::MarkMirrorTexStale(const Vec3& center, const Vec3& half)
+{
+    if (m_mirrorTexStale) {
+        return;
+    }
+    for (const Vec4& plane : m_mirrorTexPlanes) {
+        const Vec3 normal(plane);
+        if (glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), half) < 0.f) {
+            return;
+        }
+    }
+    m_mirrorTexStale = true;
+}
+
+
+/******************************************************************************/
+/*!
+\fn     bool SelectSphereCubeFaces(const Scene& scene, float fps)
+\brief
+        Pick the sphere cube map faces rendered this frame.
+        When a refresh is due (ShouldUpdateSphereCubemap), the faces whose
+        view changed are queued: all of them if the sphere moved or an update
+        is forced, otherwise only those something moved in. Faces with nothing
+        new are skipped. Up to m_sphereFacesPerFrame queued faces are then
+        taken round-robin, which spreads a full refresh over several frames.
+\return
+        Whether any face is rendered this frame.
+*/
+/******************************************************************************/
+bool Rendering::Renderer::SelectSphereCubeFaces(const Scene& scene, float fps)
+{
+    m_sphereFaceRendered.fill(false);
+    if (!scene.m_idol) {
+        return false;
+    }
+
+    const Vec3 spherePos = { scene.m_idol->GetPosition().x, scene.m_idol->GetPosition().y, scene.m_idol->GetPosition().z };
+    const bool forced = m_shouldUpdateCubeMapForSphere;
+    /*  An idol without a rigid body does not move */
+    const Physics::RigidBody* idolBody = scene.m_idol->GetRigidBody();
+    const float idolSpeedSqrd = idolBody ? idolBody->GetLinearVelocity().LengthSquared() : 0.f;
+    if (ShouldUpdateSphereCubemap(idolSpeedSqrd, fps)) {
+        for (int f = 0; f < TO_INT(CubeFaceID::NUM_FACES); ++f) {
+            m_sphereFacePending[f] = m_sphereFacePending[f] || forced || m_sphereFaceStale[f] || spherePos != m_sphereFaceCamPos[f];
+        }
+    }
+    m_shouldUpdateCubeMapForSphere = false;
+
+    bool anyFace = false;
+    int budget = m_sphereFacesPerFrame;
+    for (int n = 0; n < TO_INT(CubeFaceID::NUM_FACES) && budget > 0; ++n)
+    {
+        const int f = (m_sphereNextFace + n) % TO_INT(CubeFaceID::NUM_FACES);
+        if (m_sphereFacePending[f] == false) {
+            continue;
+        }
+        m_sphereFacePending[f] = false;
+        m_sphereFaceStale[f] = false;
+        m_sphereFaceRendered[f] = true;
+        m_sphereFaceCamPos[f] = spherePos;
+        m_sphereNextFace = (f + 1) % TO_INT(CubeFaceID::NUM_FACES);
+        anyFace = true;
+        --budget;
+    }
+    return anyFace;
+}
+
 bool Rendering::Renderer::ShouldUpdateSphereCubemap(float speedSqrd, float fps) {
 
     if (m_shouldUpdateCubeMapForSphere) {
@@ -301,107 +606,549 @@ bool Rendering::Renderer::ShouldUpdateSphereCubemap(float speedSqrd, float fps)
 }
 
 void Rendering::Renderer::SendDeferredGeomProperties(const Scene& scene) {
+    /*  Light data comes from the light uniform block, see UploadLightBlock */
+    m_glState.Uniform1i(m_gNormalMappingOnLoc, m_parallaxMappingOn);
+    m_glState.Uniform1i(m_gParallaxMappingOnLoc, m_parallaxMappingOn);
+}
+
+void Rendering::Renderer::SendDeferredLightPassProperties(const Scene& scene)
+{
+    /*  Light data comes from the light uniform block, see UploadLightBlock */
+    m_glState.Uniform1i(m_lLightPassDebugLoc, m_gLightPassDebug);
+    m_glState.Uniform1i(m_lParallaxMappingOnLoc, m_parallaxMappingOn);
+    m_glState.Uniform1i(m_lBlinnPhongLightingLoc, m_gBlinnPhongLighting);
+    m_glState.Uniform1i(m_lNormalMappingObjTypeLoc, TO_INT(Core::ObjectType::NORMAL_MAPPED_PLANE));
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void SetUpLightBlock()
+\brief
+        Create the light uniform buffer, bind it to LIGHT_BLOCK_BINDING and
+        point the "LightBlock" block of the geometry and light pass programs
+        at that binding.
+*/
+/******************************************************************************/
+void Renderer::SetUpLightBlock()
+{
+    static_assert(offsetof(LightBlock, numLights) == 16 && offsetof(LightBlock, lightPosVF) == 32,
+        "LightBlock must follow the std140 layout of the shaders' LightBlock");
+    static_assert(offsetof(LightBlock, diffuse) == 32 + NUM_MAX_LIGHTS * sizeof(Vec4)
+        && offsetof(LightBlock, specular) == 32 + 2 * NUM_MAX_LIGHTS * sizeof(Vec4),
+        "LightBlock arrays must be tightly packed vec4s");
+    static_assert(offsetof(LightBlock, shadowSlot) == 32 + 3 * NUM_MAX_LIGHTS * sizeof(Vec4) && NUM_MAX_LIGHTS % 4 == 0,
+        "LightBlock shadow slots must pack into the shaders' ivec4 array");
+
+    glGenBuffers(1, &m_lightUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_lightUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, m_lightUBO);
+
+    for (ProgType type : { ProgType::DEFERRED_GEOMPASS, ProgType::DEFERRED_LIGHTPASS }) {
+        const GLuint prog = m_shaders[TO_INT(type)].GetProgramID();
+        const GLuint blockIdx = glGetUniformBlockIndex(prog, "LightBlock");
+        if (blockIdx != GL_INVALID_INDEX) {
+            glUniformBlockBinding(prog, blockIdx, LIGHT_BLOCK_BINDING);
+        }
+    }
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void UploadLightBlock(const Scene& scene)
+\brief
+        Gather ambient, light count, specular power and the per-light
+        view-frame position, diffuse and specular terms into the light block,
+        and send it with a single buffer update.
+        ambient, diffuse, specular are reflected components on the object
+        surface and can be used directly as intensities in the lighting equation.
+\param  scene
+        The scene whose lights are sent.
+*/
+/******************************************************************************/
+void Renderer::UploadLightBlock(const Scene& scene)
+{
     const int numLights = scene.GetNumLights();
-    glUniform1i(m_gNumLightsLoc, numLights);
-    glUniform1i(m_gNormalMappingOnLoc, m_parallaxMappingOn);
-    glUniform1i(m_gParallaxMappingOnLoc, m_parallaxMappingOn);
 
+    m_lightBlock.ambient = scene.m_ambientLightIntensity * scene.m_ambientAlbedo;
+    m_lightBlock.numLights = numLights;
+    m_lightBlock.specularPower = scene.m_specularPower;
     for (int i = 0; i < numLights; ++i) {
-        glUniform4fv(m_gLightPosVFLoc[i], 1, ValuePtr(scene.m_orbitalLights[i].m_lightPosVF));
+        const OrbitalLight& light = scene.m_orbitalLights[i];
+        m_lightBlock.lightPosVF[i] = Vec4(light.m_lightPosVF, light.m_radius);
+        m_lightBlock.diffuse[i] = light.m_intensity * scene.m_diffuseAlbedo;
+        m_lightBlock.specular[i] = light.m_intensity * scene.m_specularAlbedo;
     }
 
-    Vec4 ambient = scene.m_ambientLightIntensity * scene.m_ambientAlbedo;
-    Vec4 diffuse, specular;
+    /*  Only the header and the slots of the active lights are read by the shaders */
+    const size_t bytes = offsetof(LightBlock, specular) + numLights * sizeof(Vec4);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_lightUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, bytes, &m_lightBlock);
+}
 
-    /*  Send ambient, diffuse, specular, specularPower, and blinnPhongLighting(boolean) to shader. */
-    glUniform4fv(m_gAmbientLoc, 1, &ambient[0]);
-    glUniform1i(m_gSpecularPowerLoc, scene.m_specularPower);
 
-    for (int i = 0; i < numLights; ++i) {
-        diffuse = scene.m_orbitalLights[i].m_intensity * scene.m_diffuseAlbedo;
-        specular = scene.m_orbitalLights[i].m_intensity * scene.m_specularAlbedo;
+/******************************************************************************/
+/*!
+\fn     void SetUpLightClusters()
+\brief
+        Create the two texture buffers holding the per-cluster light lists.
+        The range buffer has a fixed size, the index buffer is resized on
+        every upload.
+*/
+/******************************************************************************/
+void Renderer::SetUpLightClusters()
+{
+    glGenBuffers(1, &m_clusterRangeBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_clusterRangeBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, 2 * LightClusters::NUM_CLUSTERS * sizeof(std::uint32_t), nullptr, GL_STREAM_DRAW);
 
-        glUniform4fv(m_gDiffuseLoc[i], 1, &diffuse[0]);
-        glUniform4fv(m_gSpecularLoc[i], 1, &specular[0]);
-        glUniform4fv(m_gLightPosVFLoc[i], 1, ValuePtr(scene.m_orbitalLights[i].m_lightPosVF));
-    }
+    glGenBuffers(1, &m_clusterIndexBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_clusterIndexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(std::uint32_t), nullptr, GL_STREAM_DRAW);
+
+    glGenTextures(1, &m_clusterRangeTex);
+    glBindTexture(GL_TEXTURE_BUFFER, m_clusterRangeTex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, m_clusterRangeBuffer);
+
+    glGenTextures(1, &m_clusterIndexTex);
+    glBindTexture(GL_TEXTURE_BUFFER, m_clusterIndexTex);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_clusterIndexBuffer);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
 }
 
-void Rendering::Renderer::SendDeferredLightPassProperties(const Scene& scene)
+
+/******************************************************************************/
+/*!
+\fn     void UpdateLightClusters(const Scene& scene)
+\brief
+        Assign the lights of the light block to the clusters of the main
+        camera and upload the resulting lists for the light pass.
+        Must run after UploadLightBlock, whose view-frame positions and radii
+        it reads.
+*/
+/******************************************************************************/
+void Renderer::UpdateLightClusters(const Scene& scene)
 {
-    const int numLights = scene.GetNumLights();
-    glUniform1i(m_lNumLightsLoc, numLights);
-    glUniform1i(m_lLightPassDebugLoc, m_gLightPassDebug);
-    glUniform1i(m_lParallaxMappingOnLoc, m_parallaxMappingOn);
-    glUniform1i(m_lBlinnPhongLightingLoc, m_gBlinnPhongLighting);
-    glUniform1i(m_lNormalMappingObjTypeLoc, TO_INT(Core::ObjectType::NORMAL_MAPPED_PLANE));
+    m_lightClusters.SetProjection(m_mainCamProjMat, mainCam.nearPlane, mainCam.farPlane);
+    m_lightClusters.AssignLights(m_lightBlock.lightPosVF, scene.GetNumLights());
 
-    /*  ambient, diffuse, specular are now reflected components on the object
-        surface and can be used directly as intensities in the lighting equation.
+    const std::vector<std::uint32_t>& ranges = m_lightClusters.GetRanges();
+    glBindBuffer(GL_TEXTURE_BUFFER, m_clusterRangeBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, ranges.size() * sizeof(std::uint32_t), ranges.data());
+
+    /*  Reallocating orphans last frame's list instead of waiting for the GPU to be done with it.
+        An empty buffer is not a valid texture buffer store, so keep at least one element.
     */
-    Vec4 ambient, diffuse, specular;
-    
-    ambient = scene.m_ambientLightIntensity * scene.m_ambientAlbedo;
+    const std::vector<std::uint32_t>& indices = m_lightClusters.GetIndices();
+    glBindBuffer(GL_TEXTURE_BUFFER, m_clusterIndexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(indices.size(), 1) * sizeof(std::uint32_t), nullptr, GL_STREAM_DRAW);
+    if (indices.empty() == false) {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, indices.size() * sizeof(std::uint32_t), indices.data());
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
 
-    /*  Send ambient, diffuse, specular, specularPower, and blinnPhongLighting(boolean) to shader. */
-    glUniform4fv(m_lAmbientLoc, 1, &ambient[0]);
-    glUniform1i(m_lSpecularPowerLoc, scene.m_specularPower);
 
-    for (int i = 0; i < numLights; ++i) {
-        diffuse = scene.m_orbitalLights[i].m_intensity * scene.m_diffuseAlbedo;
-        specular = scene.m_orbitalLights[i].m_intensity * scene.m_specularAlbedo;
+void Rendering::WorldBoundsSoA::Resize(size_t size)
+{
+    for (std::vector<float>* component : { &centerX, &centerY, &centerZ, &halfX, &halfY, &halfZ }) {
+        component->resize(size);
+    }
+}
+
+void Rendering::WorldBoundsSoA::Set(size_t idx, const Vec3& center, const Vec3& half)
+{
+    centerX[idx] = center.x;
+    centerY[idx] = center.y;
+    centerZ[idx] = center.z;
+    halfX[idx] = half.x;
+    halfY[idx] = half.y;
+    halfZ[idx] = half.z;
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void UpdateObjectMatrices(const Core::Scene& scene)
+\brief
+        Refresh the world-space model and normal matrices of the objects whose
+        model version changed since the last frame (moved, re-meshed, rescaled...).
+        Everything else keeps its cached matrices, including the inverse.
+        Also resizes the model-view slabs when objects were added or removed.
+\param  scene
+        The scene whose objects are cached, index for index.
+*/
+/******************************************************************************/
+void Renderer::UpdateObjectMatrices(const Core::Scene& scene)
+{
+    const size_t objSize = scene.m_objects.size();
+    m_objectMatrices.resize(objSize);
+    m_objectBounds.Resize(objSize);
 
-		glUniform4fv(m_lDiffuseLoc[i], 1, &diffuse[0]);
-		glUniform4fv(m_lSpecularLoc[i], 1, &specular[0]);
-        glUniform4fv(m_lLightPosVFLoc[i], 1, ValuePtr(scene.m_orbitalLights[i].m_lightPosVF));
+    for (size_t i = 0; i < objSize; ++i)
+    {
+        const Core::Object* obj = scene.m_objects[i].get();
+        const uint64_t version = obj->GetModelVersion();
+
+        ObjectMatrices& cache = m_objectMatrices[i];
+        if (cache.object == obj && cache.version == version) {
+            continue;
+        }
+        cache.object = obj;
+        cache.version = version;
+        cache.changedFrame = m_frameIndex;
+        cache.model = obj->GetModelMatrix();
+        cache.normalModel = Transpose(Inverse(cache.model));
+
+        /*  World AABB of the transformed vertex box: |upper 3x3| maps half sizes to half sizes */
+        const Mesh& mesh = *obj->GetMesh();
+        const Vec3 center = Vec3(cache.model * Vec4(mesh.m_vertexBoundsCenter, 1.f));
+        const Mat3 absRotScale = Mat3(Vec3(glm::abs(cache.model[0])), Vec3(glm::abs(cache.model[1])), Vec3(glm::abs(cache.model[2])));
+
+        /*  The sphere cube map faces that saw the object where it was, or see it where it is now, are outdated */
+        const Vec3 oldCenter(m_objectBounds.centerX[i], m_objectBounds.centerY[i], m_objectBounds.centerZ[i]);
+        const Vec3 oldHalf(m_objectBounds.halfX[i], m_objectBounds.halfY[i], m_objectBounds.halfZ[i]);
+        MarkSphereFacesStale(oldCenter, oldHalf);
+        MarkMirrorTexStale(oldCenter, oldHalf);
+        m_objectBounds.Set(i, center, absRotScale * mesh.m_vertexBoundsHalfSize);
+        MarkSphereFacesStale(center, absRotScale * mesh.m_vertexBoundsHalfSize);
+        MarkMirrorTexStale(center, absRotScale * mesh.m_vertexBoundsHalfSize);
+    }
+
+    /*  Indices shift when objects are removed, so a resized slab is rebuilt from scratch.
+        Versions start at 1, hence 0 never matches an object.
+    */
+    if (m_mvSlabSize != objSize) {
+        m_sphereFaceStale.fill(true);   // removed objects leave no box behind to test
+        m_mirrorTexStale = true;
+        m_mvSlabSize = objSize;
+        m_mvMatrices.assign(TO_INT(MVSlabID::NUM_SLABS) * objSize, ObjectMVMatrices{});
+        m_mvMatrixVersions.assign(TO_INT(MVSlabID::NUM_SLABS) * objSize, 0);
+        m_mvSlabVisibility.assign(TO_INT(MVSlabID::NUM_SLABS) * objSize, 1.f);
     }
 }
 
 
 /******************************************************************************/
 /*!
-\fn     ComputeObjMVMats(Mat4 MVMat[], Mat4 NMVMat[], const Mat4& viewMat)
+\fn     void SetMVSlabView(MVSlabID slab, const Mat4& viewMat, const Mat4& projMat, bool viewChanged)
 \brief
-        Compute the modelview matrices for positions and normals.
-\param  MVMat
-        Modelview matrix for positions to be computed.
-\param  NMVMat
-        Modelview matrix for normals to be computed.
+        Mark the slab as used this frame and hand it the camera's matrices.
+\param  slab
+        The pass the view belongs to.
 \param  viewMat
-        Given view matrix.
+        The camera's view matrix.
+\param  projMat
+        The camera's projection matrix, for the culling planes.
+\param  viewChanged
+        Whether the view differs from the one given last time.
 */
 /******************************************************************************/
-void Renderer::ComputeMainCamObjMVMats(const Core::Scene& scene)
+void Renderer::SetMVSlabView(MVSlabID slab, const Mat4& viewMat, const Mat4& projMat, bool viewChanged)
 {
-    const size_t objSize = scene.m_objects.size();
-    for (int i = 0; i < objSize; ++i)
+    MVSlabView& slabView = m_mvSlabViews[TO_INT(slab)];
+    slabView.active = true;
+
+    const Mat4 viewProj = projMat * viewMat;
+    slabView.viewProj = viewProj;
+
+    Vec4 planes[6];
+    FrustumPlanes(viewProj, planes);
+    if (std::equal(std::begin(planes), std::end(planes), std::begin(slabView.frustumPlanes)) == false) {
+        std::copy(std::begin(planes), std::end(planes), std::begin(slabView.frustumPlanes));
+        m_mvMatricesDirty = true;   // culling may differ even if no matrix does (e.g. projection only)
+    }
+    if (viewChanged) {
+        const Mat4 invView = Inverse(viewMat);
+        slabView.view = viewMat;
+        slabView.viewInvTrans = Transpose(invView);
+        slabView.camPos = Vec3(invView[3]);
+        slabView.viewChanged = true;    // stays set until the slab is actually rebuilt
+    }
+}
+
+
+/******************************************************************************/
+/*!
+\fn     bool ComputeObjMVMats(MVSlabID slab, size_t begin, size_t end)
+\brief
+        Compute the modelview matrices for positions and normals of objects
+        [begin, end) in one slab.
+        Only objects that changed since their matrices were last built are
+        touched, unless the view itself changed. Either way this is two matrix
+        products per object; the inverse comes from the model cache:
+        transpose(inverse(V * M)) == transpose(inverse(V)) * transpose(inverse(M))
+        Ranges never overlap, so this is safe to run on several threads at once.
+\return
+        Whether any matrix was written.
+*/
+/******************************************************************************/
+bool Renderer::ComputeObjMVMats(MVSlabID slab, size_t begin, size_t end)
+{
+    const MVSlabView& slabView = m_mvSlabViews[TO_INT(slab)];
+    const size_t slabOffset = GetMVMatrixIdx(slab, 0);
+
+    bool written = false;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const ObjectMatrices& obj = m_objectMatrices[i];
+        uint64_t& builtFrom = m_mvMatrixVersions[slabOffset + i];
+        if (!slabView.viewChanged && builtFrom == obj.version) {
+            continue;
+        }
+        ObjectMVMatrices& mvMats = m_mvMatrices[slabOffset + i];
+        mvMats.mv = slabView.view * obj.model;
+        mvMats.nmv = slabView.viewInvTrans * obj.normalModel;
+        builtFrom = obj.version;
+        written = true;
+    }
+    return written;
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void ComputeAllObjMVMats()
+\brief
+        Frustum-cull, occlusion-cull and fill every active slab. Large scenes
+        are split into chunks and spread over the thread pool; small ones are
+        not worth the hand-off. Occlusion culling always goes to the pool, one
+        job per slab. Culled objects still get their matrices so that the slab
+        stays valid when they come back into view.
+*/
+/******************************************************************************/
+void Renderer::ComputeAllObjMVMats()
+{
+    static constexpr size_t OBJECTS_PER_JOB = 256;
+
+    const Math::SimdKernelTable& kernels = Math::GetSimdKernels();
+    const Math::ConstVec3SoA centers{ m_objectBounds.centerX.data(), m_objectBounds.centerY.data(), m_objectBounds.centerZ.data() };
+    const Math::ConstVec3SoA halfSizes{ m_objectBounds.halfX.data(), m_objectBounds.halfY.data(), m_objectBounds.halfZ.data() };
+
+    ThreadPool& pool = ThreadPool::GetInstance();
+    std::vector<std::future<bool>> jobs;
+    m_numOccludedObjects.fill(0);
+
+    for (int s = 0; s < TO_INT(MVSlabID::NUM_SLABS); ++s)
+    {
+        if (m_mvSlabViews[s].active == false) {
+            continue;
+        }
+        const MVSlabID slab = static_cast<MVSlabID>(s);
+
+        /*  One culling result per camera, reused by every draw of the pass */
+        kernels.cullBoxes(&m_mvSlabViews[s].frustumPlanes[0].x, 6, centers, halfSizes,
+            m_mvSlabVisibility.data() + GetMVMatrixIdx(slab, 0), m_mvSlabSize);
+        if (m_occlusionCullingOn) {
+            jobs.push_back(pool.enqueue([this, slab]() { OcclusionCullSlab(slab); return false; }));
+        }
+
+        if (m_mvSlabSize <= OBJECTS_PER_JOB) {
+            m_mvMatricesDirty |= ComputeObjMVMats(slab, 0, m_mvSlabSize);
+            continue;
+        }
+        for (size_t begin = 0; begin < m_mvSlabSize; begin += OBJECTS_PER_JOB) {
+            const size_t end = std::min(begin + OBJECTS_PER_JOB, m_mvSlabSize);
+            jobs.push_back(pool.enqueue([this, slab, begin, end]() { return ComputeObjMVMats(slab, begin, end); }));
+        }
+    }
+
+    for (auto& job : jobs) {
+        m_mvMatricesDirty |= job.get();
+    }
+
+    for (MVSlabView& slabView : m_mvSlabViews) {
+        if (slabView.active) {
+            slabView.viewChanged = false;
+        }
+        slabView.active = false;
+    }
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void OcclusionCullSlab(MVSlabID slab)
+\brief
+        Rasterize the occluders drawn in the slab into its occlusion buffer,
+        then cull the objects of the slab hidden behind them. Runs after the
+        frustum culling of the slab, whose result it refines; an occluder
+        containing the camera is left out, as it would hide everything.
+        Touches nothing but the slab's own visibility and buffer, so slabs
+        can be culled in parallel.
+*/
+/******************************************************************************/
+void Renderer::OcclusionCullSlab(MVSlabID slab)
+{
+    const MVSlabView& slabView = m_mvSlabViews[TO_INT(slab)];
+    OcclusionBuffer& buffer = m_occlusionBuffers[TO_INT(slab)];
+    float* visibility = m_mvSlabVisibility.data() + GetMVMatrixIdx(slab, 0);
+
+    buffer.Begin(&slabView.viewProj[0].x);
+    for (size_t i = 0; i < m_mvSlabSize; ++i)
     {
-        Mat4 objMat = scene.m_objects[i]->GetModelMatrix();
-        m_mainCamMVMat[i] = m_mainCamViewMat * objMat;
-        m_mainCamNormalMVMat[i] = Transpose(Inverse(m_mainCamMVMat[i]));
+        const Core::Object& obj = *m_objectMatrices[i].object;
+        if (obj.IsOccluder() == false || obj.IsVisible() == false || visibility[i] == 0.f || IsDrawnInSlab(obj.GetObjType(), slab) == false) {
+            continue;
+        }
+        const Vec3 toCam = slabView.camPos - Vec3(m_objectBounds.centerX[i], m_objectBounds.centerY[i], m_objectBounds.centerZ[i]);
+        if (std::abs(toCam.x) <= m_objectBounds.halfX[i] && std::abs(toCam.y) <= m_objectBounds.halfY[i] && std::abs(toCam.z) <= m_objectBounds.halfZ[i]) {
+            continue;
+        }
+        buffer.AddOccluder(m_occluderMeshes[obj.GetMesh()->drawID], &m_objectMatrices[i].model[0].x);
     }
+    if (buffer.GetNumTriangles() == 0) {
+        return;
+    }
+
+    const Math::ConstVec3SoA centers{ m_objectBounds.centerX.data(), m_objectBounds.centerY.data(), m_objectBounds.centerZ.data() };
+    const Math::ConstVec3SoA halfSizes{ m_objectBounds.halfX.data(), m_objectBounds.halfY.data(), m_objectBounds.halfZ.data() };
+    m_numOccludedObjects[TO_INT(slab)] = static_cast<int>(buffer.CullBoxes(centers, halfSizes, visibility, m_mvSlabSize));
 }
 
-void Renderer::ComputePlanarMirrorCamObjMVMats(const Core::Scene& scene)
+
+/******************************************************************************/
+/*!
+\fn     bool IsDrawnInSlab(Core::ObjectType type, MVSlabID slab)
+\brief
+        Whether objects of a type are rendered in the pass reading this slab.
+        The mirror pass leaves out both mirrors (the sphere gets its own
+        program there, the plane mirror would reflect itself), and the sphere
+        cube map leaves out the plane mirror to avoid inter-reflection.
+*/
+/******************************************************************************/
+bool Renderer::IsDrawnInSlab(Core::ObjectType type, MVSlabID slab)
+{
+    if (slab == MVSlabID::MIRROR_CAM) {
+        return type != Core::ObjectType::REFLECTIVE_FLAT && type != Core::ObjectType::REFLECTIVE_CURVED;
+    }
+    if (slab != MVSlabID::MAIN_CAM) {
+        return type != Core::ObjectType::REFLECTIVE_FLAT;
+    }
+    return true;
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void BuildDrawBatches(const Core::Scene& scene)
+\brief
+        Queue every object drawn in an active slab with a sort key of
+        (slab, type, cull mode, image, mesh, depth), radix-sort the queue and
+        copy the model-view matrices in that order. Objects sharing a mesh
+        become one instanced indirect command; commands sharing the GL state
+        (type, image) become one batch, submitted with a single multi-draw call.
+        Within a command the instances go front to back.
+        Skipped when neither the matrices, the culling, nor the set of
+        passes to draw changed since the last build.
+\param  scene
+        The scene whose objects are batched.
+*/
+/******************************************************************************/
+void Renderer::BuildDrawBatches(const Core::Scene& scene)
+{
+    unsigned activeSlabMask = 0;
+    for (int s = 0; s < TO_INT(MVSlabID::NUM_SLABS); ++s) {
+        if (m_mvSlabViews[s].active) {
+            activeSlabMask |= 1u << s;
+        }
+    }
+    if (m_mvMatricesDirty == false && activeSlabMask == m_batchedSlabMask) {
+        return;
+    }
+    m_batchedSlabMask = activeSlabMask;
+
+    /*  The geometry pass has a single program; the object type picks its variant
+        (object type uniform, normal mapping), so it takes the program field of the key.
+    */
+    m_renderQueue.Clear();
+    for (int s = 0; s < TO_INT(MVSlabID::NUM_SLABS); ++s)
+    {
+        if ((activeSlabMask & (1u << s)) == 0) {
+            continue;
+        }
+        const MVSlabID slab = static_cast<MVSlabID>(s);
+
+        for (int i = 0; i < m_mvSlabSize; ++i)
+        {
+            const Core::Object& obj = *scene.m_objects[i];
+            if (obj.IsVisible() == false || IsInFrustum(slab, i) == false || IsDrawnInSlab(obj.GetObjType(), slab) == false) {
+                continue;
+            }
+            const float viewDepth = -m_mvMatrices[GetMVMatrixIdx(slab, i)].mv[3][2];
+            m_renderQueue.Push(RenderQueue::MakeKey(s, TO_INT(obj.GetObjType()), obj.GetObjType() == Core::ObjectType::REFLECTIVE_FLAT,
+                TO_INT(obj.GetImageID()), obj.GetMesh()->drawID, viewDepth), i);
+        }
+    }
+    m_renderQueue.Sort();
+
+    for (std::vector<DrawBatch>& batches : m_drawBatches) {
+        batches.clear();
+    }
+    m_instanceMatrices.clear();
+    m_drawCommands.clear();
+
+    uint64_t batchState = ~uint64_t(0);
+    const Mesh* commandMesh = nullptr;
+    for (const RenderQueue::Item& item : m_renderQueue.GetItems())
+    {
+        const Core::Object& obj = *scene.m_objects[item.objIdx];
+        const Mesh* mesh = obj.GetMesh();
+        const MVSlabID slab = static_cast<MVSlabID>(RenderQueue::GetPass(item.key));
+        std::vector<DrawBatch>& batches = m_drawBatches[TO_INT(slab)];
+
+        if ((item.key & RenderQueue::STATE_MASK) != batchState) {
+            batches.push_back({ obj.GetImageID(), obj.GetObjType(), static_cast<GLuint>(m_drawCommands.size()), 0 });
+            batchState = item.key & RenderQueue::STATE_MASK;
+            commandMesh = nullptr;
+        }
+        if (mesh != commandMesh) {
+            m_drawCommands.push_back({ static_cast<GLuint>(mesh->numIndices), 0, mesh->firstIndex, mesh->baseVertex,
+                                       static_cast<GLuint>(m_instanceMatrices.size()) });
+            ++batches.back().commandCount;
+            commandMesh = mesh;
+        }
+        m_instanceMatrices.push_back(m_mvMatrices[GetMVMatrixIdx(slab, item.objIdx)]);
+        ++m_drawCommands.back().instanceCount;
+    }
+
+    UploadDrawData();
+    m_mvMatricesDirty = false;
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void UploadDrawData()
+\brief
+        Copy the instance matrices and the indirect commands of all batches
+        to the GPU, one buffer update each.
+*/
+/******************************************************************************/
+void Renderer::UploadDrawData()
 {
-    const size_t objSize = scene.m_objects.size();
-    for (int i = 0; i < objSize; ++i)
-    {
-        Mat4 objMat = scene.m_objects[i]->GetModelMatrix();
-        m_mirrorCamMVMat[i] = m_mirrorCamViewMat * objMat;
-        m_mirrorCamNormalMVMat[i] = Transpose(Inverse(m_mirrorCamMVMat[i]));
-    }
-}
+    auto Upload = [](GLenum target, GLuint buffer, size_t& bufferSize, const void* data, size_t bytes) {
+        if (bytes == 0) {
+            return;
+        }
+        glBindBuffer(target, buffer);
+        if (bytes > bufferSize) {
+            glBufferData(target, bytes, data, GL_DYNAMIC_DRAW);
+            bufferSize = bytes;
+        }
+        else {
+            glBufferSubData(target, 0, bytes, data);
+        }
+    };
 
-void Renderer::ComputeSphericalMirrorCamObjMVMats(int faceIdx,const Core::Scene& scene)
-{
-    const size_t objSize = scene.m_objects.size();
-    for (int i = 0; i < objSize; ++i)
-    {
-        Mat4 objMat = scene.m_objects[i]->GetModelMatrix();
-        m_sphereCamMVMat[i][faceIdx] = m_sphereCamViewMat[faceIdx] * objMat;
-        m_sphereCamNormalMVMat[i][faceIdx] = Transpose(Inverse(m_sphereCamMVMat[i][faceIdx]));
-    }
+    Upload(GL_ARRAY_BUFFER, m_instanceBuffer, m_instanceBufferSize,
+        m_instanceMatrices.data(), m_instanceMatrices.size() * sizeof(ObjectMVMatrices));
+    Upload(GL_DRAW_INDIRECT_BUFFER, m_drawIndirectBuffer, m_drawIndirectBufferSize,
+        m_drawCommands.data(), m_drawCommands.size() * sizeof(DrawElementsIndirectCommand));
 }
 
 
@@ -420,11 +1167,13 @@ void Renderer::ComputeMainCamMats(const Core::Scene& scene)
     }
 
     /*  Update view transform matrix */
-    if (mainCam.moved || mirrorCam.moved){
+    const bool viewChanged = mainCam.moved;
+    if (viewChanged) {
         m_mainCamViewMat = mainCam.ViewMat();
-        ComputeMainCamObjMVMats(scene);
     }
 
+    /*  Objects that moved are refreshed even when the camera did not */
+    SetMVSlabView(MVSlabID::MAIN_CAM, m_mainCamViewMat, m_mainCamProjMat, viewChanged);
 }
 
 
@@ -433,6 +1182,8 @@ void Renderer::ComputeMainCamMats(const Core::Scene& scene)
 \fn     void ComputeMirrorCamMats(const Core::Scene& scene)
 \brief
         Compute the view/projection and other related matrices for mirror camera.
+        Only done when the main camera or the mirror moved, which is also when
+        the visibility of the mirror and the size of its texture may change.
 */
 /******************************************************************************/
 void Renderer::ComputeMirrorCamMats(const Core::Scene& scene)
@@ -441,35 +1192,31 @@ void Renderer::ComputeMirrorCamMats(const Core::Scene& scene)
         return;
     }
 
-	//check if mirror has moved (check only the translation not rotation for now)
-	// Thresholds for movement
-	static constexpr float POSITION_THRESHOLD = 0.01f;
+    /*  Check if the mirror has moved, turned or been rescaled; a resting mirror still drifts a little */
+    static constexpr float MOVE_THRESHOLD = 0.01f;
 
-	static Math::Vector3 previousMirrorPos = scene.m_mirror->GetPosition();
-	const Math::Vector3& currentMirrorPos = previousMirrorPos;
-
-    Math::Vector3 positionDelta = currentMirrorPos - previousMirrorPos;
-	previousMirrorPos = currentMirrorPos;
-	
-    if (positionDelta.Length() > POSITION_THRESHOLD) {
-		mirrorCam.moved = true;
-	}
+    const Mat4 mirrorMat = scene.m_mirror->GetModelMatrix();
+    for (int col = 0; col < 4; ++col) {
+        const Vec4 delta = glm::abs(mirrorMat[col] - m_mirrorModelMat[col]);
+        if (std::max(std::max(delta.x, delta.y), std::max(delta.z, delta.w)) > MOVE_THRESHOLD) {
+            mirrorCam.moved = true;
+        }
+    }
 
-    if (mainCam.moved||mirrorCam.moved)
+    bool viewChanged = false;
+    if (mainCam.moved || mainCam.resized || mirrorCam.moved || m_renderScaleChanged)
     {
-
-        Mat4 mirrorMat=scene.m_mirror->GetModelMatrix();
+        m_mirrorModelMat = mirrorMat;
         Vec3 mainCamMirrorFrame = Vec3(Inverse(mirrorMat) * Vec4(mainCam.pos, 1.0));
 
-        /*  If user camera is behind mirror, then mirror is not visible and no need to compute anything */
-        if (mainCamMirrorFrame.z >= 0)
-        {
-            m_mirrorVisible = false;
+        /*  If user camera is behind mirror (or the mirror is off-screen), then mirror is not visible
+            and no need to compute anything
+        */
+        m_mirrorVisible = mainCamMirrorFrame.z < 0 && UpdateMirrorTexSize(scene);
+        if (m_mirrorVisible == false) {
             return;
         }
-        else {
-            m_mirrorVisible = true;
-        }
+        m_mirrorTexStale = true;
 
         /*  In mirror frame, mirror camera position is defined as (x, y, -z) in which (x, y, z) is the
             user camera position in mirror frame.
@@ -488,8 +1235,8 @@ void Renderer::ComputeMirrorCamMats(const Core::Scene& scene)
         mirrorCam.lookAt = Vec3(mirrorMat* Vec4{ mirrorCenter,1.f });
 
         m_mirrorCamViewMat = LookAt(mirrorCam.pos, mirrorCam.lookAt, mirrorCam.upVec);
+        viewChanged = true;
 
-        ComputePlanarMirrorCamObjMVMats(scene);
         /*  Compute mirror camera projection matrix */
         /*  In mirror frame, the mirror camera view direction is towards the center of the mirror,
             which is the origin of this frame.
@@ -566,9 +1313,116 @@ void Renderer::ComputeMirrorCamMats(const Core::Scene& scene)
         //mirrorCam.topPlane *= viewAngleAdjustFactor;
         m_mirrorCamProjMat = mirrorCam.ProjMat();
     }
+
+    if (m_mirrorVisible) {
+        SetMVSlabView(MVSlabID::MIRROR_CAM, m_mirrorCamViewMat, m_mirrorCamProjMat, viewChanged);
+    }
+}
+
+
+/******************************************************************************/
+/*!
+\fn     bool UpdateMirrorTexSize(const Core::Scene& scene)
+\brief
+        Test the mirror quad against the main camera frustum, and size the
+        mirror texture after the screen area of the quad: the largest power
+        of two fraction of mirrorCam.width still giving a texel per pixel.
+\return
+        False when the quad is outside the frustum; the size is kept then.
+*/
+/******************************************************************************/
+bool Renderer::UpdateMirrorTexSize(const Core::Scene& scene)
+{
+    const Mesh& mesh = *scene.m_mirror->GetMesh();
+    const Vec3& center = mesh.m_vertexBoundsCenter;
+    const Vec3& half = mesh.m_vertexBoundsHalfSize;
+    const MVSlabView& mainView = m_mvSlabViews[TO_INT(MVSlabID::MAIN_CAM)];
+
+    /*  The mirror quad lies in the xy plane of the mirror frame */
+    Vec4 corners[4];
+    for (int c = 0; c < 4; ++c) {
+        corners[c] = m_mirrorModelMat * Vec4(center.x + ((c & 1) ? half.x : -half.x), center.y + ((c & 2) ? half.y : -half.y), center.z, 1.f);
+    }
+    for (const Vec4& plane : mainView.frustumPlanes) {
+        if (std::all_of(std::begin(corners), std::end(corners), [&plane](const Vec4& corner) { return glm::dot(plane, corner) < 0.f; })) {
+            return false;
+        }
+    }
+
+    /*  Screen bounds of the quad, clipped to the screen; a corner behind the camera means the whole screen */
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (const Vec4& corner : corners) {
+        const Vec4 clip = mainView.viewProj * corner;
+        if (clip.w <= 0.f) {
+            minX = minY = -INFINITY;
+            maxX = maxY = INFINITY;
+            break;
+        }
+        const float x = (clip.x / clip.w * 0.5f + 0.5f) * mainCam.width;
+        const float y = (clip.y / clip.w * 0.5f + 0.5f) * mainCam.height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    }
+    const float width = std::max(std::min(maxX, static_cast<float>(mainCam.width)) - std::max(minX, 0.f), 0.f);
+    const float height = std::max(std::min(maxY, static_cast<float>(mainCam.height)) - std::max(minY, 0.f), 0.f);
+    const float side = std::sqrt(width * height) * m_renderScale;  // texels of the mirror in the G-buffer
+
+    int size = mirrorCam.width;
+    while (size / 2 >= MIRROR_MIN_TEX_SIZE && size / 2 >= side) {
+        size /= 2;
+    }
+    m_mirrorTexSize = size;
+    return true;
 }
 
 
+/******************************************************************************/
+/*!
+\fn     void UpdateRenderScale()
+\brief
+        Collect the pass times of a past frame from the GPU profiler, if the
+        GPU is done with it, and let the dynamic resolution controller pick
+        the scale from their total. The G-buffer area and the mip level the
+        sphere cube map is rendered to are then set for this frame.
+*/
+/******************************************************************************/
+void Renderer::UpdateRenderScale()
+{
+    if (m_gpuProfiler.BeginFrame(m_frameIndex))
+    {
+        const ProfileLog& log = m_gpuProfiler.GetLog();
+        m_gpuFrameMs = log.GetFrame(log.GetNumFrames() - 1).GetMs(ProfileLog::TOTAL);
+        if (m_dynamicResolutionOn) {
+            m_dynamicResolution.Update(m_gpuFrameMs, m_cpuFrameMs);
+        }
+    }
+
+    /*  The G-buffer textures are DISPLAY_SIZE square, so a larger window is upscaled at any scale */
+    const float scale = m_dynamicResolutionOn ? m_dynamicResolution.GetScale() : 1.f;
+    m_renderScaleChanged = scale != m_renderScale;
+    m_renderScale = scale;
+    m_renderWidth = std::min(DynamicResolution::ScaleSize(mainCam.width, scale), Camera::DISPLAY_SIZE);
+    m_renderHeight = std::min(DynamicResolution::ScaleSize(mainCam.height, scale), Camera::DISPLAY_SIZE);
+
+    /*  One mip level per halving of the scale, switched between refreshes so that the faces match.
+        A coarser level already holds the faces (glGenerateMipmap), a finer one holds them as they
+        were before the drop and is refreshed.
+    */
+    const int level = std::clamp(static_cast<int>(std::lround(-std::log2(scale))), 0, SPHERE_CUBE_MAX_LEVEL);
+    if (level != m_sphereCubeLevel
+        && std::none_of(m_sphereFacePending.begin(), m_sphereFacePending.end(), [](bool pending) { return pending; }))
+    {
+        if (level < m_sphereCubeLevel) {
+            m_sphereFacePending.fill(true);
+        }
+        m_sphereCubeLevel = level;
+        m_glState.BindTexture(TO_INT(ActiveTexID::COLOR), GL_TEXTURE_CUBE_MAP, ResourceManager::GetInstance().m_sphereTexID);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, level);
+    }
+}
+
 /******************************************************************************/
 /*!
 \fn     void ComputeSphereCamMats()
@@ -612,14 +1466,15 @@ void Renderer::ComputeSphereCamMats(const Core::Scene& scene)
         -BASIS[1]  // FRONT flipped
     };
 
-    for (int f = 0; f < TO_INT(CubeFaceID::NUM_FACES); ++f)
-    {
-        Vec3 spherePos = { scene.m_idol->GetPosition().x,scene.m_idol->GetPosition().y,scene.m_idol->GetPosition().z };
-        m_sphereCamViewMat[f] = LookAt(spherePos, spherePos + lookAt[f], upVec[f]);
-        ComputeSphericalMirrorCamObjMVMats(f, scene);
+    Vec3 spherePos = { scene.m_idol->GetPosition().x,scene.m_idol->GetPosition().y,scene.m_idol->GetPosition().z };
+    const bool viewChanged = spherePos != m_sphereCamPos;
+    if (viewChanged) {
+        m_sphereCamPos = spherePos;
+        for (int f = 0; f < TO_INT(CubeFaceID::NUM_FACES); ++f)
+        {
+            m_sphereCamViewMat[f] = LookAt(spherePos, spherePos + lookAt[f], upVec[f]);
+        }
     }
-
-
     /*  Use Perspective function to ompute the projection matrix m_sphereCamProjMat so that
         from the camera position at the cube center, we see a complete face of the cube.
         The near plane distance is 0.01f. The far plane distance is equal to mainCam's farPlane.
@@ -629,123 +1484,266 @@ void Renderer::ComputeSphereCamMats(const Core::Scene& scene)
     constexpr float aspectRatio = 1.f;
     constexpr float nearPlane = 0.01f; // near plane is 0.01, and far plane is the same as the main camera's far plane
     m_sphereCamProjMat = Perspective(fov, aspectRatio, nearPlane, mainCam.farPlane);
+
+    /*  Only the faces rendered this frame need their slab. A face skipped while the sphere
+        moved still holds matrices of an older view, hence the comparison with the slab's view.
+    */
+    for (int f = 0; f < TO_INT(CubeFaceID::NUM_FACES); ++f) {
+        if (m_sphereFaceRendered[f] == false) {
+            continue;
+        }
+        const MVSlabID slab = static_cast<MVSlabID>(TO_INT(MVSlabID::SPHERE_CAM) + f);
+        SetMVSlabView(slab, m_sphereCamViewMat[f], m_sphereCamProjMat, viewChanged || m_mvSlabViews[TO_INT(slab)].view != m_sphereCamViewMat[f]);
+    }
 }
 
-void Renderer::RenderGeometryPass(const Scene& scene, float fps) {
+void Renderer::RenderGeometryPass(const Scene& scene, bool updateSphereCubemap) {
+
+    //(1) reflection textures, each into its own framebuffer
+    if (updateSphereCubemap)
+    {
+        /*  Rendered straight into the faces of the cubemap texture, with a GPU-side copy
+            fallback for drivers that cannot render to cubemap faces.
+        */
+        GpuProfiler::Scope scope(m_gpuProfiler, "Sphere Cube Map");
+        RenderToSphereCubeMapTexture(scene);
+    }
+
+    /*  The texture for planar reflection is view-dependent, so it needs to be rendered on the fly,
+        whenever the mirror is visible and its camera or something it reflects moved
+    */
+    m_mirrorTexRendered = m_mirrorVisible && m_mirrorTexStale;
+    if (m_mirrorTexRendered) {
+        GpuProfiler::Scope scope(m_gpuProfiler, "Mirror");
+        RenderToMirrorTexture(scene);
+    }
 
-	m_shaders[TO_INT(ProgType::DEFERRED_GEOMPASS)].Use();
+    //(2) G-buffer
+    GpuProfiler::Scope scope(m_gpuProfiler, "Geometry");
+	UseProgram(ProgType::DEFERRED_GEOMPASS);
 
 	// Bind G-buffer framebuffer
 	glBindFramebuffer(GL_FRAMEBUFFER, m_deferredGeomPassFBO);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+	/*  The compact layout has no position attachment */
+	GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, m_compactGBuffer ? GL_NONE : GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
 	glDrawBuffers(3, drawBuffers);
 
 	GLfloat bgColor[4] = { 1.f, 1.2f, 1.f, 1.0f };
 	glClearBufferfv(GL_COLOR, 0, bgColor);//color
-	glClearBufferfv(GL_COLOR, 1, glm::value_ptr(glm::vec3(0.0f)));//pos
+	if (m_compactGBuffer == false) {
+		glClearBufferfv(GL_COLOR, 1, glm::value_ptr(glm::vec3(0.0f)));//pos
+	}
 	glClearBufferfv(GL_COLOR, 2, glm::value_ptr(glm::vec4(0.0f)));//normal
 	glClearBufferfv(GL_DEPTH, 0, &one);                           //depth
 
-    //(2) rendering objects 
-    if (scene.m_idol &&
-        (ShouldUpdateSphereCubemap(scene.m_idol->GetRigidBody()->GetLinearVelocity().LengthSquared(),fps) == true))
-    {
-        ComputeSphereCamMats(scene);
-
-        /*  Theoretically the rendering to cubemap texture can be done in the same way as 2D texture:
-            rendering straight to the GPU texture object, similar to what we do for the
-            2D mirror texture below.
-            However, some graphics drivers don't seem to implement the framebuffer cubemap texture properly.
-            So we do the cubemap texture generation manually here: copy the framebuffer to CPU texture data,
-            then copy that data to the GPU texture object.
-        */
-        RenderToSphereCubeMapTexture(scene);
-
-        m_shouldUpdateCubeMapForSphere = false;
-    }
-
-    /*  The texture for planar reflection is view-dependent, so it needs to be rendered on the fly,
-        whenever the mirror is visible and camera is moving
-    */
-    if (m_mirrorVisible && (mainCam.moved || mirrorCam.moved)) {
-        RenderToMirrorTexture(scene);
-    }
-
     /*  Render the scene, except the sphere to the screen */
     RenderToScreen(scene);
     /*  This is done separately, as it uses a different shader program for reflection/refraction */
     RenderSphere(scene);
 }
 
+/******************************************************************************/
+/*!
+\fn     void RenderShadowMap(Scene& scene)
+\brief
+        Render the shadow atlas.
+        The lights are ranked by how much of the screen they light, and the
+        atlas gives the most important ones a tile sized accordingly. Only
+        the tiles picked by the per-frame budget are rendered, in two
+        layers: casters are culled against the light frustum, those that
+        have not moved for a while are drawn into the static layer when the
+        light or that set of objects changed, the static tile is copied into
+        the atlas and the moving casters are drawn over it.
+        A light that moved since its tile was last rendered skips the static
+        layer and the copy: all its casters are drawn straight into the atlas.
+        The static layer is built at the next update of a light standing still.
+        Finally the tile of every light is sent through the light block.
+*/
+/******************************************************************************/
 void Renderer::RenderShadowMap(Scene& scene) {
-    m_shaders[TO_INT(ProgType::SHADOW_MAP)].Use();
-    glViewport(0, 0, Camera::DISPLAY_SIZE, Camera::DISPLAY_SIZE);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_shadowMapFBO);
-    glClear(GL_DEPTH_BUFFER_BIT);
+    const int numLights = scene.GetNumLights();
+    m_shadowImportance.resize(numLights);
+    for (int i = 0; i < numLights; ++i) {
+        m_shadowImportance[i] = ShadowAtlas::ScreenImportance(m_lightBlock.lightPosVF[i], m_mainCamProjMat, mainCam.nearPlane);
+    }
+    m_shadowAtlas.Plan(m_shadowImportance.data(), numLights, m_shadowUpdatesPerFrame);
 
+    /*  Layer membership does not depend on the light; any change invalidates every static tile */
     const size_t numObjs = scene.m_objects.size();
-    for (int i{}; i < numObjs; ++i) {
-        const auto& obj = *scene.m_objects[i];
-        if (obj.IsVisible() == false) {
-            continue;
+    bool membershipChanged = m_shadowStaticCaster.size() != numObjs;
+    m_shadowStaticCaster.resize(numObjs);
+    for (size_t i = 0; i < numObjs; ++i) {
+        const char isStatic = scene.m_objects[i]->IsVisible()
+            && m_frameIndex - m_objectMatrices[i].changedFrame >= SHADOW_STATIC_AFTER_FRAMES;
+        membershipChanged |= isStatic != m_shadowStaticCaster[i];
+        m_shadowStaticCaster[i] = isStatic;
+    }
+    if (membershipChanged) {
+        m_shadowAtlas.InvalidateStatic();
+    }
+
+    UseProgram(ProgType::SHADOW_MAP);
+    m_numStaticShadowCasters = 0;
+    m_numDynamicShadowCasters = 0;
+    m_numShadowStaticTilesRedrawn = 0;
+    m_shadowCasterVisible.resize(numObjs);
+
+    std::vector<ShadowAtlas::Tile>& tiles = m_shadowAtlas.GetTiles();
+    for (int t : m_shadowAtlas.GetUpdates())
+    {
+        ShadowAtlas::Tile& tile = tiles[t];
+        const Mat4& lightSpaceMat = scene.m_orbitalLights[tile.light].m_lightSpaceMat;
+
+        Vec4 lightPlanes[6];
+        FrustumPlanes(lightSpaceMat, lightPlanes);
+        Math::GetSimdKernels().cullBoxes(&lightPlanes[0].x, 6,
+            { m_objectBounds.centerX.data(), m_objectBounds.centerY.data(), m_objectBounds.centerZ.data() },
+            { m_objectBounds.halfX.data(), m_objectBounds.halfY.data(), m_objectBounds.halfZ.data() },
+            m_shadowCasterVisible.data(), numObjs);
+
+        auto DrawCasters = [&](bool staticLayer) {
+            int numCasters = 0;
+            for (size_t i = 0; i < numObjs; ++i) {
+                const auto& obj = *scene.m_objects[i];
+                if (obj.IsVisible() == false || (m_shadowStaticCaster[i] != 0) != staticLayer || m_shadowCasterVisible[i] == 0.f) {
+                    continue;
+                }
+                Mat4 mat = lightSpaceMat * m_objectMatrices[i].model;
+                m_glState.UniformMatrix4fv(m_sLightSpaceMatLoc, ValuePtr(mat));
+                RenderObj(obj);
+                ++numCasters;
+            }
+            return numCasters;
+        };
+
+        auto ClearTile = [&](GLuint fbo) {
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            m_glState.SetCapability(GL_SCISSOR_TEST, true);
+            glScissor(tile.x, tile.y, tile.size, tile.size);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            m_glState.SetCapability(GL_SCISSOR_TEST, false);
+        };
+
+        glViewport(tile.x, tile.y, tile.size, tile.size);
+        const bool staticReusable = tile.staticValid && tile.staticMat == lightSpaceMat;
+        const bool lightMoved = tile.rendered == false || tile.renderedMat != lightSpaceMat;
+        if (staticReusable == false && lightMoved) {
+            /*  The static layer would not survive the next update, draw everything in place */
+            ClearTile(m_shadowMapFBO);
+            m_numStaticShadowCasters += DrawCasters(true);
+            tile.staticValid = false;
+        }
+        else {
+            if (staticReusable == false) {
+                ClearTile(m_shadowStaticFBO);
+                m_numStaticShadowCasters += DrawCasters(true);
+                tile.staticValid = true;
+                tile.staticMat = lightSpaceMat;
+                ++m_numShadowStaticTilesRedrawn;
+            }
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, m_shadowStaticFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_shadowMapFBO);
+            glBlitFramebuffer(tile.x, tile.y, tile.x + tile.size, tile.y + tile.size, tile.x, tile.y, tile.x + tile.size, tile.y + tile.size,
+                GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, m_shadowMapFBO);
         }
-        Mat4 mat = scene.m_orbitalLights[0].m_lightSpaceMat * obj.GetModelMatrix();
-        glUniformMatrix4fv(m_sLightSpaceMatLoc, 1, GL_FALSE, ValuePtr(mat));
-        RenderObj(obj);
+        m_numDynamicShadowCasters += DrawCasters(false);
+        m_shadowAtlas.MarkRendered(t, lightSpaceMat);
     }
+    m_numShadowTilesRendered = static_cast<int>(m_shadowAtlas.GetUpdates().size());
+
+    /*  A light whose tile was never rendered yet goes unshadowed */
+    std::fill(m_lightBlock.shadowSlot, m_lightBlock.shadowSlot + numLights, -1);
+    for (int t = 0; t < static_cast<int>(tiles.size()); ++t) {
+        if (tiles[t].rendered) {
+            m_lightBlock.shadowSlot[tiles[t].light] = t;
+        }
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, m_lightUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(LightBlock, shadowSlot), numLights * sizeof(GLint), m_lightBlock.shadowSlot);
 }
 
 void Renderer::RenderLightPass(const Scene& scene) {
-    /*  Bind framebuffer to 0 to render to the screen */
+    /*  Bind the output framebuffer: 0 to render to the screen, the offscreen target when headless */
     /*  Disable depth test since we only render flat textures */
     /*  Disable writing to depth buffer */
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    m_shaders[TO_INT(ProgType::DEFERRED_LIGHTPASS)].Use();
+    glBindFramebuffer(GL_FRAMEBUFFER, m_outputFBO);
+    glViewport(0, 0, mainCam.width, mainCam.height);
+    UseProgram(ProgType::DEFERRED_LIGHTPASS);
 
     glClearColor(0.f, 0.f, 0.f, 1.f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glDisable(GL_DEPTH_TEST);
-    glDepthMask(GL_FALSE);
+    m_glState.SetCapability(GL_DEPTH_TEST, false);
+    m_glState.DepthMask(false);
 
     // Bind the color texture to texture unit 0
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_gColorTexID);
-    glUniform1i(m_lColorTexLoc, 0);
+    m_glState.BindTexture(0, GL_TEXTURE_2D, m_gColorTexID);
+    m_glState.Uniform1i(m_lColorTexLoc, 0);
 
     // Bind the position texture to texture unit 1
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, m_gPosTexID);
-    glUniform1i(m_lPosTexLoc, 1);
+    m_glState.BindTexture(1, GL_TEXTURE_2D, m_gPosTexID);
+    m_glState.Uniform1i(m_lPosTexLoc, 1);
 
     // Bind the normal texture to texture unit 2
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, m_gNrmTexID);
-    glUniform1i(m_lNrmTexLoc, 2);
+    m_glState.BindTexture(2, GL_TEXTURE_2D, m_gNrmTexID);
+    m_glState.Uniform1i(m_lNrmTexLoc, 2);
 
     //Bind the depth texture to texture unit 3
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, m_gDepthTexID);
-    glUniform1i(m_lDepthTexLoc, 3);
+    m_glState.BindTexture(3, GL_TEXTURE_2D, m_gDepthTexID);
+    m_glState.Uniform1i(m_lDepthTexLoc, 3);
 
     //Bind the shadow depth texture to texture unit 4
-    glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_2D, m_sShdowMapDepthTexID);
-    glUniform1i(m_lShadowDepthTexLoc, 4);
+    m_glState.BindTexture(4, GL_TEXTURE_2D, m_sShdowMapDepthTexID);
+    m_glState.Uniform1i(m_lShadowDepthTexLoc, 4);
+
+    //Bind the per-cluster light lists to texture units 5 and 6
+    m_glState.BindTexture(5, GL_TEXTURE_BUFFER, m_clusterRangeTex);
+    m_glState.Uniform1i(m_lClusterRangeTexLoc, 5);
+    m_glState.BindTexture(6, GL_TEXTURE_BUFFER, m_clusterIndexTex);
+    m_glState.Uniform1i(m_lClusterIndexTexLoc, 6);
+    m_glState.Uniform1f(m_lClusterSliceScaleLoc, m_lightClusters.GetSliceScale());
+    m_glState.Uniform1f(m_lClusterSliceBiasLoc, m_lightClusters.GetSliceBias());
+
+    m_glState.Uniform1i(m_lCompactGBufferLoc, m_compactGBuffer);
+    m_glState.Uniform2f(m_lGBufferScaleLoc, static_cast<float>(m_renderWidth) / Camera::DISPLAY_SIZE,
+        static_cast<float>(m_renderHeight) / Camera::DISPLAY_SIZE);
+    if (m_compactGBuffer) {
+        Mat4 invProjMat = Inverse(m_mainCamProjMat);
+        m_glState.UniformMatrix4fv(m_lInvProjMatLoc, ValuePtr(invProjMat));
+    }
 
-    glBindVertexArray(quadVAO[TO_INT(DebugType::MAIN)]);
-    glUniform1i(m_lLightPassDebugLoc, TO_INT(DebugType::MAIN));
-    Mat4 mat = scene.m_orbitalLights[0].m_lightSpaceMat * Inverse(mainCam.ViewMat());
-    glUniformMatrix4fv(m_lLightSpaceMatLoc, 1, GL_FALSE, ValuePtr(mat));
+    m_glState.BindVertexArray(quadVAO[TO_INT(DebugType::MAIN)]);
+    m_glState.Uniform1i(m_lLightPassDebugLoc, TO_INT(DebugType::MAIN));
+    /*  Tiles are looked up with the light matrix they were rendered with, which may be a few frames old */
+    const Mat4 invViewMat = Inverse(mainCam.ViewMat());
+    const std::vector<ShadowAtlas::Tile>& tiles = m_shadowAtlas.GetTiles();
+    std::array<Mat4, ShadowAtlas::MAX_SHADOWED_LIGHTS> shadowMats;
+    std::array<Vec4, ShadowAtlas::MAX_SHADOWED_LIGHTS> shadowRects;
+    int primaryShadowSlot = -1;
+    for (size_t t = 0; t < tiles.size(); ++t) {
+        shadowMats[t] = tiles[t].renderedMat * invViewMat;
+        shadowRects[t] = Vec4(tiles[t].x, tiles[t].y, tiles[t].size, tiles[t].size) / static_cast<float>(ShadowAtlas::ATLAS_SIZE);
+        if (primaryShadowSlot < 0 && tiles[t].rendered) {
+            primaryShadowSlot = static_cast<int>(t);
+        }
+    }
+    if (tiles.empty() == false) {
+        const GLsizei numTiles = static_cast<GLsizei>(tiles.size());
+        m_glState.UniformMatrix4fv(m_lShadowMatsLoc, &shadowMats[0][0].x, numTiles);
+        m_glState.Uniform4fv(m_lShadowRectsLoc, &shadowRects[0].x, numTiles);
+    }
+    m_glState.Uniform1i(m_lPrimaryShadowSlotLoc, primaryShadowSlot);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
     if (m_buffersDisplay)
     {
         for (int i = TO_INT(DebugType::COLOR); i < TO_INT(DebugType::NUM_DEBUGTYPES); ++i)
         {
-            glUniform1i(m_lLightPassDebugLoc, i);
+            m_glState.Uniform1i(m_lLightPassDebugLoc, i);
             /*  Send corresponding quads to shader for rendering
                 debugging minimaps.
                 Appropriate flag (COLOR/POSITION/NORMAL/DEPTH) should
@@ -755,36 +1753,31 @@ void Renderer::RenderLightPass(const Scene& scene) {
             switch (i)
             {
             case TO_INT(DebugType::COLOR):
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, m_gColorTexID);
+                m_glState.BindTexture(0, GL_TEXTURE_2D, m_gColorTexID);
                 break;
             case TO_INT(DebugType::POSITION):
-                glActiveTexture(GL_TEXTURE1);
-                glBindTexture(GL_TEXTURE_2D, m_gPosTexID);
+                m_glState.BindTexture(1, GL_TEXTURE_2D, m_gPosTexID);
                 break;
             case TO_INT(DebugType::NORMAL):
-                glActiveTexture(GL_TEXTURE2);
-                glBindTexture(GL_TEXTURE_2D, m_gNrmTexID);
+                m_glState.BindTexture(2, GL_TEXTURE_2D, m_gNrmTexID);
                 break;
             case TO_INT(DebugType::DEPTH):
-                glActiveTexture(GL_TEXTURE3);
-                glBindTexture(GL_TEXTURE_2D, m_gDepthTexID);
+                m_glState.BindTexture(3, GL_TEXTURE_2D, m_gDepthTexID);
                 break;
             case TO_INT(DebugType::SHADOW_MAP_DEPTH):
-                glActiveTexture(GL_TEXTURE4);
-                glBindTexture(GL_TEXTURE_2D, m_sShdowMapDepthTexID);
+                m_glState.BindTexture(4, GL_TEXTURE_2D, m_sShdowMapDepthTexID);
                 break;
             }
-            glBindVertexArray(quadVAO[i]);
+            m_glState.BindVertexArray(quadVAO[i]);
             glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
         }
     }
 
     /*  Enable depth test again for rendering objects in the next frame */
-    glEnable(GL_DEPTH_TEST);
+    m_glState.SetCapability(GL_DEPTH_TEST, true);
 
     /*  Enable writing to depth buffer */
-    glDepthMask(GL_TRUE);
+    m_glState.DepthMask(true);
 }
 
 void Rendering::Renderer::RenderGui(Scene& scene, float fps) {
@@ -795,6 +1788,40 @@ void Rendering::Renderer::RenderGui(Scene& scene, float fps) {
     // displaying FPS
     ImGui::Text("Frame Rate: %.1f", fps);
 
+    // GL calls of the last frame, and how many of them the state cache dropped
+    const GLStateStats& glStats = m_glState.GetLastFrameStats();
+    ImGui::Text("GL State Calls: %u issued, %u skipped", glStats.TotalIssued(), glStats.TotalSkipped());
+    ImGui::Text("Shadow Atlas: %d lights, %d tiles rendered (%d static redrawn)", static_cast<int>(m_shadowAtlas.GetTiles().size()),
+        m_numShadowTilesRendered, m_numShadowStaticTilesRedrawn);
+    ImGui::Text("Shadow Casters: %d static, %d dynamic", m_numStaticShadowCasters, m_numDynamicShadowCasters);
+    ImGui::Text("Mirror: %s, %d^2 texels", m_mirrorVisible == false ? "not visible" : m_mirrorTexRendered ? "rendered" : "reused",
+        m_mirrorTexSize);
+    ImGui::Text("Occluded: %d main, %d mirror, %d sphere", m_numOccludedObjects[TO_INT(MVSlabID::MAIN_CAM)],
+        m_numOccludedObjects[TO_INT(MVSlabID::MIRROR_CAM)],
+        std::accumulate(m_numOccludedObjects.begin() + TO_INT(MVSlabID::SPHERE_CAM), m_numOccludedObjects.end(), 0));
+    ImGui::Text("Resolution: %d%% (%dx%d), GPU %.2f ms, CPU %.2f ms", static_cast<int>(std::lround(m_renderScale * 100.f)),
+        m_renderWidth, m_renderHeight, m_gpuFrameMs, m_cpuFrameMs);
+
+    // GPU time of each pass over the last frames profiled, skipped passes counting as 0 ms
+    if (ImGui::CollapsingHeader("GPU Passes", ImGuiTreeNodeFlags_DefaultOpen)) {
+        const ProfileLog& profile = m_gpuProfiler.GetLog();
+        for (int pass = 0; pass < profile.GetNumPasses(); ++pass) {
+            ImGui::Text("%-16s %6.2f ms avg, %6.2f ms max", profile.GetPassName(pass).c_str(), profile.GetAverageMs(pass),
+                profile.GetMaxMs(pass));
+        }
+        ImGui::Text("%-16s %6.2f ms avg, %6.2f ms max", "Total", profile.GetAverageMs(ProfileLog::TOTAL),
+            profile.GetMaxMs(ProfileLog::TOTAL));
+        ImGui::Text("%d frames recorded, %u dropped", static_cast<int>(profile.GetNumFrames()), m_gpuProfiler.GetNumDropped());
+        if (ImGui::Button("Export CSV")) {
+            const char* path = "gpu_profile.csv";
+            Logger::Log(ExportGpuProfile(path) ? "Renderer: GPU pass times written to " : "Error: cannot write ", path);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Clear")) {
+            m_gpuProfiler.GetLog().Clear();
+        }
+    }
+
     // sphere Reflection/Refraction settings
     int refTypeInt = static_cast<int>(m_sphereRef);
     const char* refTypes[] = { "Reflection Only", "Refraction Only", "Reflection & Refraction" };
@@ -804,15 +1831,49 @@ void Rendering::Renderer::RenderGui(Scene& scene, float fps) {
     if (m_sphereRef != RefType::REFLECTION_ONLY) {
         ImGui::SliderFloat("Sphere Refractive Index", &m_sphereRefIndex, 1.0f, 2.5f);
     }
+    ImGui::SliderInt("Sphere Faces / Frame", &m_sphereFacesPerFrame, 1, TO_INT(CubeFaceID::NUM_FACES));
+
+    // how many shadow atlas tiles may be re-rendered per frame
+    ImGui::SliderInt("Shadow Tiles / Frame", &m_shadowUpdatesPerFrame, 1, ShadowAtlas::MAX_SHADOWED_LIGHTS);
+
+    // the static shadow layer is only reused while the lights stand still
+    ImGui::Checkbox("Orbit Lights", &m_lightsOrbiting);
 
     // parallax Mapping Toggle
     bool& parallaxMappingOn = Renderer::GetInstance().GetParallaxMapping();
     if(ImGui::Checkbox("Parallax Mapping", &parallaxMappingOn)) {
-        glUniform1i(m_lParallaxMappingOnLoc, parallaxMappingOn);
+        UseProgram(ProgType::DEFERRED_LIGHTPASS);
+        m_glState.Uniform1i(m_lParallaxMappingOnLoc, parallaxMappingOn);
+        m_mirrorTexStale = true;    // the mirror shows the plane
     }
 
     ImGui::Checkbox("Display Debug Windows", &m_buffersDisplay);
 
+    // CPU occlusion culling of the objects hidden behind the occluders, in every pass
+    if (ImGui::Checkbox("Occlusion Culling", &m_occlusionCullingOn)) {
+        m_mvMatricesDirty = true;   // the culled objects come back
+    }
+
+    // render resolution driven by the frame time, see UpdateRenderScale
+    ImGui::Checkbox("Dynamic Resolution", &m_dynamicResolutionOn);
+    if (m_dynamicResolutionOn) {
+        float budgetMs = m_dynamicResolution.GetBudget();
+        if (ImGui::SliderFloat("Frame Budget (ms)", &budgetMs, 4.f, 50.f)) {
+            m_dynamicResolution.SetBudget(budgetMs);
+        }
+        float minScale = m_dynamicResolution.GetMinScale();
+        if (ImGui::SliderFloat("Min Resolution Scale", &minScale, 0.25f, 1.f)) {
+            m_dynamicResolution.SetLimits(minScale, m_dynamicResolution.GetMaxScale());
+        }
+    }
+
+    // G-buffer layout, to compare the bandwidth of both
+    if (ImGui::Checkbox("Compact G-buffer", &m_compactGBuffer)) {
+        DeleteDeferredGeomPassTextures();
+        SetUpDeferredGeomPassTextures();
+        m_glState.Invalidate();     // the deleted textures may still be recorded as bound
+    }
+
     // obj List GUI
     static int selectedObject = -1;
     std::vector<std::string> objectNames;
@@ -921,7 +1982,7 @@ void Rendering::Renderer::RenderGui(Scene& scene, float fps) {
     if (ImGui::CollapsingHeader("Launch Projectile", ImGuiTreeNodeFlags_DefaultOpen)) {
         if (ImGui::Button("Shoot Projectile")) {
             // create and launch a projectile
-            scene.ShootProjectile({ mainCam.GetPos().x,mainCam.GetPos().y,mainCam.GetPos().z });
+            scene.ShootProjectile(mainCam.GetPos(), mainCam.GetLookAtVec() - mainCam.GetPos(), mainCam.GetUpVec());
         }
         UpdateGuiToObjectIndexMap(scene);
     }
@@ -931,13 +1992,13 @@ void Rendering::Renderer::RenderGui(Scene& scene, float fps) {
         int numLights = scene.GetNumLights();
 
         if (ImGui::Button("Add Light") && numLights < NUM_MAX_LIGHTS) {
-            UpdateNumLights(scene.AddLight());
+            scene.AddLight();
             m_shouldUpdateCubeMapForSphere = true;
         }
         ImGui::SameLine();
 
         if (ImGui::Button("Remove Light") && numLights > 0) {
-            UpdateNumLights(scene.RemoveLight());
+            scene.RemoveLight();
             m_shouldUpdateCubeMapForSphere = true;
         }
 
@@ -946,7 +2007,6 @@ void Rendering::Renderer::RenderGui(Scene& scene, float fps) {
             Vec4 lightColor = scene.GetLightColor(i);
             if (ImGui::ColorEdit3(("Light " + std::to_string(i) + " Color").c_str(), &lightColor.x)) {
                 scene.SetLightColor(lightColor, i);
-                SendLightColors(scene, i);
                 m_shouldUpdateCubeMapForSphere = true;
             }
         }
@@ -962,11 +2022,11 @@ void Rendering::Renderer::RenderGui(Scene& scene, float fps) {
         The object whose model-view matrices we want to send.
 */
 /******************************************************************************/
-void SendMVMat(const Mat4& mvMat, const Mat4& nmvMat, GLint mvMatLoc, GLint nmvMatLoc)
+void SendMVMat(GLStateCache& glState, const Mat4& mvMat, const Mat4& nmvMat, GLint mvMatLoc, GLint nmvMatLoc)
 {
     /*  Send transformation matrices to shaders */
-    glUniformMatrix4fv(mvMatLoc, 1, GL_FALSE, ValuePtr(mvMat));
-    glUniformMatrix4fv(nmvMatLoc, 1, GL_FALSE, ValuePtr(nmvMat));
+    glState.UniformMatrix4fv(mvMatLoc, ValuePtr(mvMat));
+    glState.UniformMatrix4fv(nmvMatLoc, ValuePtr(nmvMat));
 }
 
 
@@ -983,9 +2043,9 @@ void SendMVMat(const Mat4& mvMat, const Mat4& nmvMat, GLint mvMatLoc, GLint nmvM
         The location of the variable to send to.
 */
 /******************************************************************************/
-void SendViewMat(Mat4 viewMat, GLint viewMatLoc)
+void SendViewMat(GLStateCache& glState, const Mat4& viewMat, GLint viewMatLoc)
 {
-    glUniformMatrix4fv(viewMatLoc, 1, GL_FALSE, ValuePtr(viewMat));
+    glState.UniformMatrix4fv(viewMatLoc, ValuePtr(viewMat));
 }
 
 
@@ -998,9 +2058,9 @@ void SendViewMat(Mat4 viewMat, GLint viewMatLoc)
         The object whose projection matrix we want to send.
 */
 /******************************************************************************/
-void SendProjMat(const Mat4& projMat, GLint projMatLoc)
+void SendProjMat(GLStateCache& glState, const Mat4& projMat, GLint projMatLoc)
 {
-    glUniformMatrix4fv(projMatLoc, 1, GL_FALSE, ValuePtr(projMat));
+    glState.UniformMatrix4fv(projMatLoc, ValuePtr(projMat));
 }
 
 /******************************************************************************/
@@ -1014,11 +2074,10 @@ void SendProjMat(const Mat4& projMat, GLint projMatLoc)
         Location of the variable to send to.
 */
 /******************************************************************************/
-void SendCubeTexID(int texID, GLint texCubeLoc)
+void SendCubeTexID(GLStateCache& glState, GLuint texID, GLint texCubeLoc)
 {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texID);
-    glUniform1i(texCubeLoc, 0);
+    glState.BindTexture(0, GL_TEXTURE_CUBE_MAP, texID);
+    glState.Uniform1i(texCubeLoc, 0);
 }
 
 GLFWwindow* Rendering::Renderer::GetWindow() const {
@@ -1039,9 +2098,8 @@ void Rendering::Renderer::Reset() {
 /******************************************************************************/
 void Renderer::SendMirrorTexID()
 {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, ResourceManager::GetInstance().m_mirrorTexID);
-    glUniform1i(m_gColorTexLoc, 0);
+    m_glState.BindTexture(0, GL_TEXTURE_2D, ResourceManager::GetInstance().m_mirrorTexID);
+    m_glState.Uniform1i(m_gColorTexLoc, 0);
 }
 
 /******************************************************************************/
@@ -1057,11 +2115,10 @@ void Renderer::SendMirrorTexID()
         The location of the uniform sampler in the shader.
 */
 /******************************************************************************/
-void SendObjTexID(GLuint texID, int activeTex, GLint texLoc)
+void SendObjTexID(GLStateCache& glState, GLuint texID, int activeTex, GLint texLoc)
 {
-    glActiveTexture(GL_TEXTURE0 + activeTex);
-    glBindTexture(GL_TEXTURE_2D, texID);
-    glUniform1i(texLoc, activeTex);
+    glState.BindTexture(activeTex, GL_TEXTURE_2D, texID);
+    glState.Uniform1i(texLoc, activeTex);
 }
 
 
@@ -1077,13 +2134,15 @@ void Renderer::AttachScene(const Core::Scene& scene)
     
     //1. shader
     SetUpShaders();
-
-    //2. Send mesh data only
+    SetUpLightBlock();
+    UploadLightBlock(scene);
+    SetUpLightClusters();
+    UpdateLightClusters(scene);
+
+    //2. Send mesh data only (one VAO for every mesh, plus the instance and indirect buffers)
+    SetUpMeshBuffers();
+    LoadMultiDrawIndirect();
     ResourceManager& resourceManager = ResourceManager::GetInstance();
-    size_t NUM_MESHES = TO_INT(MeshID::NUM_MESHES);
-    for (int i = 0; i < NUM_MESHES; ++i) {
-        SetUpVertexData(*resourceManager.GetMesh(static_cast<MeshID>(i)));
-    }
 
     //3. obj textures
     resourceManager.SetUpTextures();
@@ -1094,11 +2153,13 @@ void Renderer::AttachScene(const Core::Scene& scene)
 	SetUpLightPassQuads();
     //6. (shadow mapping)
     SetUpShadowMappingTextures();
+    //7. Render target of the sphere reflection/refraction cube map
+    SetUpSphereCubeMapTarget();
 
-    m_shaders[TO_INT(ProgType::DEFERRED_LIGHTPASS)].Use();
+    UseProgram(ProgType::DEFERRED_LIGHTPASS);
     SendDeferredLightPassProperties(scene);
 
-    m_shaders[TO_INT(ProgType::DEFERRED_GEOMPASS)].Use();
+    UseProgram(ProgType::DEFERRED_GEOMPASS);
     SendDeferredGeomProperties(scene);
 
     /*  Drawing using filled mode */
@@ -1126,21 +2187,24 @@ void Renderer::AttachScene(const Core::Scene& scene)
 void Renderer::CleanUp()
 {
     // ImGui cleanup
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    if (m_window) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
 
     glBindVertexArray(0);
 
     ResourceManager& resourceManager = ResourceManager::GetInstance();
-    size_t NUM_MESHES = TO_INT(MeshID::NUM_MESHES);
-    for (int i = 0; i < NUM_MESHES; ++i)
-    {
-        Mesh* mesh = resourceManager.GetMesh(static_cast<MeshID>(i));
-        glDeleteVertexArrays(1, &mesh->VAO);
-        glDeleteBuffers(1, &mesh->VBO);
-        glDeleteBuffers(1, &mesh->IBO);
-    }
+    glDeleteVertexArrays(1, &m_meshVAO);
+    glDeleteBuffers(1, &m_meshVBO);
+    glDeleteBuffers(1, &m_meshIBO);
+    glDeleteBuffers(1, &m_drawIndirectBuffer);
+    glDeleteBuffers(1, &m_lightUBO);
+    glDeleteTextures(1, &m_clusterRangeTex);
+    glDeleteTextures(1, &m_clusterIndexTex);
+    glDeleteBuffers(1, &m_clusterRangeBuffer);
+    glDeleteBuffers(1, &m_clusterIndexBuffer);
 
     glDeleteTextures(TO_INT(ImageID::NUM_IMAGES), resourceManager.m_textureIDs.data());
     glDeleteTextures(1, &resourceManager.m_bumpTexID);
@@ -1149,18 +2213,26 @@ void Renderer::CleanUp()
     glDeleteTextures(1, &resourceManager.m_mirrorTexID);
     glDeleteTextures(1, &resourceManager.m_sphereTexID);
 
+    glDeleteBuffers(1, &m_instanceBuffer);
+
     glDeleteVertexArrays(TO_INT(DebugType::NUM_DEBUGTYPES), quadVAO);
     glDeleteBuffers(TO_INT(DebugType::NUM_DEBUGTYPES), quadVBO);
 
-    glDeleteTextures(1, &m_gColorTexID);
-    glDeleteTextures(1, &m_gPosTexID);
-    glDeleteTextures(1, &m_gNrmTexID);
-    glDeleteTextures(1, &m_gDepthTexID);
+    DeleteDeferredGeomPassTextures();
     glDeleteTextures(1, &m_sShdowMapDepthTexID);
 
-    glDeleteFramebuffers(1, &m_deferredGeomPassFBO);
     glDeleteFramebuffers(1, &m_shadowMapFBO);
+    glDeleteFramebuffers(1, &m_shadowStaticFBO);
+    glDeleteTextures(1, &m_sShadowStaticDepthTexID);
+    glDeleteFramebuffers(1, &m_sphereCubeFBO);
+    glDeleteRenderbuffers(1, &m_sphereCubeDepthRBO);
+    glDeleteTextures(1, &m_sphereFaceTexID);
+    glDeleteBuffers(1, &m_sphereFacePBO);
+    m_gpuProfiler.Release();
+    m_frameReadback.Release();
     glDeleteFramebuffers(1, &resourceManager.m_mirrorFrameBufferID);
+    glDeleteFramebuffers(1, &m_outputFBO);
+    glDeleteRenderbuffers(1, &m_outputColorRBO);
 }
 
 Rendering::Renderer::Renderer()
@@ -1170,24 +2242,56 @@ Rendering::Renderer::Renderer()
     , m_shouldUpdateCubeMapForSphere{ true }
     , m_sphereMirrorCubeMapFrameCounter{}
 
+    , m_mvSlabSize{}
+    , m_mvMatricesDirty{ false }
+    , m_batchedSlabMask{}
+    , m_instanceBuffer{}
+    , m_instanceBufferSize{}
+    , m_drawIndirectBuffer{}
+    , m_drawIndirectBufferSize{}
+    , m_meshVAO{}
+    , m_meshVBO{}
+    , m_meshIBO{}
+    , m_multiDrawElementsIndirect{ nullptr }
+
     , m_mainCamViewMat{}
     , m_mainCamProjMat{}
-    , m_mainCamMVMat{}
-    , m_mainCamNormalMVMat{}
 
     , m_mirrorCamViewMat{}
     , m_mirrorCamProjMat{}
-    , m_mirrorCamMVMat{}
-    , m_mirrorCamNormalMVMat{}
+
+    , m_lightBlock{}
+    , m_lightUBO{}
+    , m_clusterRangeBuffer{}
+    , m_clusterRangeTex{}
+    , m_clusterIndexBuffer{}
+    , m_clusterIndexTex{}
 
     , m_sphereCamProjMat{}
-    , m_sphereCamViewMat(TO_INT(CubeFaceID::NUM_FACES))
+    , m_sphereCamPos{ INFINITY }
+    , m_sphereCamViewMat{}
+    , m_sphereCubeFBO{}
+    , m_sphereCubeDepthRBO{}
+    , m_sphereCubeDirect{ true }
+    , m_sphereFaceTexID{}
+    , m_sphereFacePBO{}
     , m_gColorTexID {}
     , m_gPosTexID {}
     , m_gNrmTexID {}
     , m_gDepthTexID {}
     , m_deferredGeomPassFBO {}
 {
+    if (s_headless)
+    {
+        if (m_headlessContext.Create(4, 2) == false) {
+            std::cerr << "Failed to create the headless OpenGL context\n";
+            exit(EXIT_FAILURE);
+        }
+        InitRendering();
+        SetUpOutputTarget();
+    }
+    else
+    {
 	// Initialize GLFW
 	if (!glfwInit()) {
 		std::cerr << "Failed to initialize GLFW\n";
@@ -1224,6 +2328,7 @@ Rendering::Renderer::Renderer()
 
 	InitRendering();
 	InitImGui();
+    }
 
     m_shaderFileMap[ProgType::SKYBOX_PROG] = { "../RigidBodyLab/shaders/skybox.vs", "../RigidBodyLab/shaders/skybox.fs" };
     m_shaderFileMap[ProgType::SPHERE_PROG] = { "../RigidBodyLab/shaders/sphere.vs", "../RigidBodyLab/shaders/sphere.fs" };
@@ -1266,51 +2371,41 @@ void Renderer::Resize(GLFWwindow* window, int w, int h)
 void Rendering::Renderer::SetUpDeferredGeomUniformLocations()
 {
     GLuint prog = m_shaders[TO_INT(ProgType::DEFERRED_GEOMPASS)].GetProgramID();
-    m_gMVMatLoc = glGetUniformLocation(prog, "mvMat");
-    m_gNMVMatLoc = glGetUniformLocation(prog, "nmvMat");
     m_gProjMatLoc = glGetUniformLocation(prog, "projMat");
-    m_gNumLightsLoc = glGetUniformLocation(prog, "numLights");
     m_gObjectTypeLoc = glGetUniformLocation(prog, "objType");
     m_gNormalMappingOnLoc = glGetUniformLocation(prog, "normalMappingOn");
     m_gParallaxMappingOnLoc = glGetUniformLocation(prog, "parallaxMappingOn");
     m_gColorTexLoc = glGetUniformLocation(prog, "colorTex");
     m_gNormalTexLoc = glGetUniformLocation(prog, "normalTex");
     m_gBumpTexLoc = glGetUniformLocation(prog, "bumpTex");
-    m_gAmbientLoc = glGetUniformLocation(prog, "ambient");
-    m_gSpecularPowerLoc = glGetUniformLocation(prog, "specularPower");
-
-    for (int i = 0; i < NUM_MAX_LIGHTS; ++i) {
-        std::string index = std::to_string(i);
-        m_gLightPosVFLoc[i]= glGetUniformLocation(prog, ("lightPosVF[" + index + "]").c_str());
-        m_gDiffuseLoc[i] = glGetUniformLocation(prog, ("diffuse[" + index + "]").c_str());
-        m_gSpecularLoc[i] = glGetUniformLocation(prog, ("specular[" + index + "]").c_str());
-    }
+    m_gCompactGBufferLoc = glGetUniformLocation(prog, "compactGBuffer");
+    m_gMirrorTexScaleLoc = glGetUniformLocation(prog, "mirrorTexScale");
 }
 
 void Rendering::Renderer::SetUpDeferredLightUniformLocations() {
 	GLuint prog = m_shaders[TO_INT(ProgType::DEFERRED_LIGHTPASS)].GetProgramID();
     //m_lLightPassQuadLoc = glGetUniformLocation(prog, "");
-    m_lLightSpaceMatLoc = glGetUniformLocation(prog, "lightSpaceMat");
+    m_lShadowMatsLoc = glGetUniformLocation(prog, "shadowMats");
+    m_lShadowRectsLoc = glGetUniformLocation(prog, "shadowRects");
+    m_lPrimaryShadowSlotLoc = glGetUniformLocation(prog, "primaryShadowSlot");
 	m_lLightPassDebugLoc = glGetUniformLocation(prog, "lightPassDebug");
 	m_lColorTexLoc = glGetUniformLocation(prog, "colorTex");
-    m_lNumLightsLoc = glGetUniformLocation(prog, "numLights");
 	m_lPosTexLoc = glGetUniformLocation(prog, "posTex");
 	m_lNrmTexLoc = glGetUniformLocation(prog, "nrmTex");
     m_lTanTexLoc = glGetUniformLocation(prog, "tanTex");
     m_lDepthTexLoc = glGetUniformLocation(prog, "depthTex");
     m_lShadowDepthTexLoc = glGetUniformLocation(prog, "shadowMapDepthTex");
+    m_lClusterRangeTexLoc = glGetUniformLocation(prog, "clusterRangeTex");
+    m_lClusterIndexTexLoc = glGetUniformLocation(prog, "clusterIndexTex");
+    m_lClusterSliceScaleLoc = glGetUniformLocation(prog, "clusterSliceScale");
+    m_lClusterSliceBiasLoc = glGetUniformLocation(prog, "clusterSliceBias");
 
-    m_lAmbientLoc = glGetUniformLocation(prog, "ambient");
-    m_lSpecularPowerLoc= glGetUniformLocation(prog, "specularPower");
     m_lBlinnPhongLightingLoc = glGetUniformLocation(prog, "blinnPhongLighting");
     m_lParallaxMappingOnLoc = glGetUniformLocation(prog, "parallaxMappingOn");
     m_lNormalMappingObjTypeLoc = glGetUniformLocation(prog, "normalMappingObjType");
-    for (int i = 0; i < NUM_MAX_LIGHTS; ++i) {
-        std::string index = std::to_string(i);
-        m_lDiffuseLoc[i] = glGetUniformLocation(prog, ("diffuse[" + index + "]").c_str());
-        m_lSpecularLoc[i] = glGetUniformLocation(prog, ("specular[" + index + "]").c_str());
-        m_lLightPosVFLoc[i] = glGetUniformLocation(prog, ("lightPosVF[" + index + "]").c_str());
-    }
+    m_lCompactGBufferLoc = glGetUniformLocation(prog, "compactGBuffer");
+    m_lInvProjMatLoc = glGetUniformLocation(prog, "invProjMat");
+    m_lGBufferScaleLoc = glGetUniformLocation(prog, "gBufferScale");
 }
 
 void Rendering::Renderer::SetUpShadowMappingUniformLocations() {
@@ -1332,55 +2427,67 @@ void Renderer::InitImGui() {
 }
 
 void Renderer::InitRendering() {
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    const GLADloadproc loader = s_headless ? HeadlessContext::GetProcAddress : (GLADloadproc)glfwGetProcAddress;
+    if (!gladLoadGLLoader(loader)) {
         std::cerr << "Failed to initialize GLAD\n";
         exit(EXIT_FAILURE);
     }
 
     // Set up viewport
     int width, height;
-    glfwGetFramebufferSize(m_window.get(), &width, &height);
+    GetOutputSize(width, height);
     glViewport(0, 0, width, height);
 }
 
-void Rendering::Renderer::SendLightColors(Core::Scene& scene, int lightIdx)
+
+/******************************************************************************/
+/*!
+\fn     void SetUpOutputTarget()
+\brief
+        Create the framebuffer the lit frame is drawn into when headless,
+        since a context without a surface has no default framebuffer.
+*/
+/******************************************************************************/
+void Renderer::SetUpOutputTarget()
 {
-    //light pass shader
-    if (lightIdx >= scene.GetNumLights()) {
-        throw std::runtime_error("SendLightColors::light index out of range");
-    }
+    glGenRenderbuffers(1, &m_outputColorRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_outputColorRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, mainCam.width, mainCam.height);
 
-	//const int NumLights = scene.GetNumLights();
- //   for (int i = 0; i < NumLights; ++i) {
- //       scene.m_lightPosVF[i] = Vec3(m_mainCamViewMat * Vec4(scene.m_lightPosWF[i], 1.0f));
- //       glUniform3fv(m_lLightPosVFLoc[i], 1, ValuePtr(scene.m_lightPosVF[i]));
- //   }
+    glGenFramebuffers(1, &m_outputFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_outputFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_outputColorRBO);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        Logger::Log("Error: Output framebuffer is not complete!");
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
 
-    Vec4 diffuse = scene.m_orbitalLights[lightIdx].m_intensity * scene.m_diffuseAlbedo;
-    Vec4 specular = scene.m_orbitalLights[lightIdx].m_intensity* scene.m_specularAlbedo;
 
-    glUniform4fv(m_lDiffuseLoc[lightIdx], 1, ValuePtr(diffuse));
-    glUniform4fv(m_lSpecularLoc[lightIdx], 1, ValuePtr(specular));
-    
-    //-----------------------------------------------------------
-    //geom pass shader
-    m_shaders[TO_INT(ProgType::DEFERRED_GEOMPASS)].Use();
-	//for (int i = 0; i < NumLights; ++i) {
-	//	glUniform3fv(m_gLightPosVFLoc[i], 1, ValuePtr(scene.m_lightPosVF[i]));
-	//}
+/*  Size of the framebuffer the frame ends up in */
+void Renderer::GetOutputSize(int& width, int& height) const
+{
+    if (m_window) {
+        glfwGetFramebufferSize(m_window.get(), &width, &height);
+    }
+    else {
+        width = mainCam.width;
+        height = mainCam.height;
+    }
+}
 
-    glUniform4fv(m_gDiffuseLoc[lightIdx], 1, ValuePtr(diffuse));
-    glUniform4fv(m_gSpecularLoc[lightIdx], 1, ValuePtr(specular));
 
-    m_shouldUpdateCubeMapForSphere = true;
+/*  GL function by name, from whichever of GLFW or the headless context made the current context */
+GLFWglproc Renderer::GetProcAddress(const char* name) const
+{
+    return s_headless ? reinterpret_cast<GLFWglproc>(HeadlessContext::GetProcAddress(name)) : glfwGetProcAddress(name);
 }
 
-void Rendering::Renderer::UpdateNumLights(int numLights){
-    m_shaders[TO_INT(ProgType::DEFERRED_LIGHTPASS)].Use();
-    glUniform1i(m_lNumLightsLoc, numLights);
 
-    m_shaders[TO_INT(ProgType::DEFERRED_GEOMPASS)].Use();
-    glUniform1i(m_gNumLightsLoc, numLights);
+/*  Block until the GPU is done with every frame submitted, e.g. to time a run as a whole */
+void Renderer::WaitForGpu() const
+{
+    glFinish();
 }
 
 // Function to update the mapping when objects are added/removed
@@ -1396,29 +2503,18 @@ void Rendering::Renderer::UpdateGuiToObjectIndexMap(const Core::Scene& scene) {
 // Function to update light positions
 void Rendering::Renderer::UpdateOrbitalLights(Core::Scene& scene, float dt) {
 
-    Vec4 diffuse, specular;
-
     const int numLights = scene.GetNumLights();
     for (int i{}; i < numLights; ++i){
-        //update position & color
-        scene.m_orbitalLights[i].Update(dt);
-
-        diffuse = scene.m_orbitalLights[i].m_intensity * scene.m_diffuseAlbedo;
-        specular = scene.m_orbitalLights[i].m_intensity * scene.m_specularAlbedo;
-        glUniform4fv(m_lDiffuseLoc[i], 1, &diffuse[i]);
-        glUniform4fv(m_lSpecularLoc[i], 1, &specular[i]);
-
+        //update position & color, unless the orbit is paused
+        if (m_lightsOrbiting) {
+            scene.m_orbitalLights[i].Update(dt);
+        }
         scene.m_orbitalLights[i].m_lightPosVF = Vec3(m_mainCamViewMat * Vec4(scene.m_orbitalLights[i].m_lightPosWF, 1.0f));
-        glUniform3fv(m_lLightPosVFLoc[i], 1, ValuePtr(scene.m_orbitalLights[i].m_lightPosVF));
-    }
-
-    m_shaders[TO_INT(ProgType::DEFERRED_GEOMPASS)].Use();
-    for (int i = 0; i < numLights; ++i) {
-        glUniform3fv(m_gLightPosVFLoc[i], 1, ValuePtr(scene.m_orbitalLights[i].m_lightPosVF));
-        glUniform4fv(m_gDiffuseLoc[i], 1, &diffuse[i]);
-        glUniform4fv(m_gSpecularLoc[i], 1, &specular[i]);
     }
 
+    // one upload for both deferred programs, then the per-cluster lists built from it
+    UploadLightBlock(scene);
+    UpdateLightClusters(scene);
 }
 
 
@@ -1442,10 +2538,10 @@ void Renderer::RenderSkybox(const Mat4& viewMat)
 {
     glClearBufferfv(GL_DEPTH, 0, &one);
 
-    m_shaders[TO_INT(ProgType::SKYBOX_PROG)].Use();
+    UseProgram(ProgType::SKYBOX_PROG);
 
-    SendCubeTexID(ResourceManager::GetInstance().m_skyboxTexID, m_skyboxTexCubeLoc);
-    SendViewMat(viewMat, m_skyboxViewMatLoc);
+    SendCubeTexID(m_glState, ResourceManager::GetInstance().m_skyboxTexID, m_skyboxTexCubeLoc);
+    SendViewMat(m_glState, viewMat, m_skyboxViewMatLoc);
 
     /*  Just trigger the skybox shaders, which hard-code the full-screen quad drawing */
     /*  No vertices are actually sent */
@@ -1464,10 +2560,11 @@ void Renderer::RenderSkybox(const Mat4& viewMat)
 /******************************************************************************/
 void Renderer::RenderObj(const Core::Object& obj)
 {
-    /*  Tell shader to use obj's VAO for rendering */
+    /*  All meshes live in the shared buffers, at their own offsets */
     const Mesh& mesh = *obj.GetMesh();
-    glBindVertexArray(mesh.VAO);
-    glDrawElements(GL_TRIANGLES, mesh.numIndices, GL_UNSIGNED_INT, nullptr);
+    m_glState.BindVertexArray(m_meshVAO);
+    glDrawElementsBaseVertex(GL_TRIANGLES, mesh.numIndices, GL_UNSIGNED_INT,
+        reinterpret_cast<void*>(static_cast<size_t>(mesh.firstIndex) * indexSize), mesh.baseVertex);
 }
 
 
@@ -1488,26 +2585,31 @@ void Renderer::RenderSphere(const Core::Scene& scene)
         m_shouldUpdateCubeMapForSphere = true;
     }
 
-    m_shaders[TO_INT(ProgType::SPHERE_PROG)].Use();
+    UseProgram(ProgType::SPHERE_PROG);
 
-    SendCubeTexID(ResourceManager::GetInstance().m_sphereTexID, m_sphereTexCubeLoc);
+    SendCubeTexID(m_glState, ResourceManager::GetInstance().m_sphereTexID, m_sphereTexCubeLoc);
 
     /*  Indicate whether we want reflection/refraction or both */
-    glUniform1i(m_sphereRefLoc, TO_INT(m_sphereRef));
+    m_glState.Uniform1i(m_sphereRefLoc, TO_INT(m_sphereRef));
 
     /*  Set refractive index of the sphere */
-    glUniform1f(m_sphereRefIndexLoc, m_sphereRefIndex);
+    m_glState.Uniform1f(m_sphereRefIndexLoc, m_sphereRefIndex);
 
     /*  We need view mat to know our camera orientation */
-    SendViewMat(m_mainCamViewMat, m_sphereViewMatLoc);
-
-    // compute and send the model-view matrix for the sphere
-    Mat4 sphereMV = m_mainCamViewMat * scene.m_idol->GetModelMatrix();
-    Mat4 sphereNMV = Transpose(Inverse(sphereMV));
-    SendMVMat(sphereMV, sphereNMV, m_sphereMVMatLoc, m_sphereNMVMatLoc);
+    SendViewMat(m_glState, m_mainCamViewMat, m_sphereViewMatLoc);
+
+    // the idol is one of the scene objects, so its model-view matrices are already cached
+    const size_t objSize = m_objectMatrices.size();
+    for (size_t i = 0; i < objSize; ++i) {
+        if (m_objectMatrices[i].object == scene.m_idol) {
+            const ObjectMVMatrices& sphereMats = m_mvMatrices[GetMVMatrixIdx(MVSlabID::MAIN_CAM, i)];
+            SendMVMat(m_glState, sphereMats.mv, sphereMats.nmv, m_sphereMVMatLoc, m_sphereNMVMatLoc);
+            break;
+        }
+    }
 
     // send the projection matrix
-    SendProjMat(m_mainCamProjMat, m_sphereProjMatLoc);
+    SendProjMat(m_glState, m_mainCamProjMat, m_sphereProjMatLoc);
 
     // render the sphere
     RenderObj(*scene.m_idol);
@@ -1547,112 +2649,107 @@ void Renderer::RenderObjects(RenderPass renderPass, const Core::Scene& scene, in
     */
     ResourceManager& resourceManager = ResourceManager::GetInstance();
     if (renderPass == RenderPass::NORMAL) {
-        glViewport(0, 0, mainCam.width, mainCam.height);
+        glViewport(0, 0, m_renderWidth, m_renderHeight);   // lower-left part of the G-buffer, see UpdateRenderScale
         RenderSkybox(m_mainCamViewMat);
-        m_shaders[TO_INT(ProgType::DEFERRED_GEOMPASS)].Use();
-        SendProjMat(m_mainCamProjMat, m_gProjMatLoc);
+        UseProgram(ProgType::DEFERRED_GEOMPASS);
+        SendProjMat(m_glState, m_mainCamProjMat, m_gProjMatLoc);
     }
     else if (renderPass == RenderPass::MIRRORTEX_GENERATION) {
-        glViewport(0, 0, mirrorCam.width, mirrorCam.height);
+        glViewport(0, 0, m_mirrorTexSize, m_mirrorTexSize);
         RenderSkybox(m_mirrorCamViewMat);
-        m_shaders[TO_INT(ProgType::DEFERRED_GEOMPASS)].Use();
-        SendProjMat(m_mirrorCamProjMat, m_gProjMatLoc);
+        UseProgram(ProgType::DEFERRED_GEOMPASS);
+        SendProjMat(m_glState, m_mirrorCamProjMat, m_gProjMatLoc);
     }
     else if (renderPass == RenderPass::SPHERETEX_GENERATION) {
-        glViewport(0, 0, resourceManager.m_skyboxFaceSize, resourceManager.m_skyboxFaceSize);
+        glViewport(0, 0, resourceManager.m_skyboxFaceSize >> m_sphereCubeLevel, resourceManager.m_skyboxFaceSize >> m_sphereCubeLevel);
         RenderSkybox(m_sphereCamViewMat[faceIdx]);
-        m_shaders[TO_INT(ProgType::DEFERRED_GEOMPASS)].Use();
-        SendProjMat(m_sphereCamProjMat, m_gProjMatLoc);
+        UseProgram(ProgType::DEFERRED_GEOMPASS);
+        SendProjMat(m_glState, m_sphereCamProjMat, m_gProjMatLoc);
     }
 
 
-    /*  Send object texture and render them */
-    const size_t numObjs = scene.m_objects.size();
-    for (int i{}; i < numObjs; ++i) {
-        const auto& obj = *scene.m_objects[i];
-        if (obj.IsVisible() == false) {
-            continue;
-        }        
+    /*  Only the on-screen pass writes the G-buffer, the texture passes keep the plain color output */
+    m_glState.Uniform1i(m_gCompactGBufferLoc, renderPass == RenderPass::NORMAL && m_compactGBuffer);
+    m_glState.Uniform1f(m_gMirrorTexScaleLoc, static_cast<float>(m_mirrorTexSize) / mirrorCam.width);
+
+    /*  Which slab of the model-view matrix buffer this pass reads from */
+    MVSlabID slab = MVSlabID::MAIN_CAM;
+    if (renderPass == RenderPass::MIRRORTEX_GENERATION) {
+        slab = MVSlabID::MIRROR_CAM;
+    }
+    else if (renderPass == RenderPass::SPHERETEX_GENERATION) {
+        slab = static_cast<MVSlabID>(TO_INT(MVSlabID::SPHERE_CAM) + faceIdx);
+    }
 
+    /*  Send object texture and render them, one multi-draw per (type, image) batch.
+        The batches come sorted by state, so most of the calls below repeat the previous
+        batch's values and are dropped by the state cache.
+    */
+    m_glState.BindVertexArray(m_meshVAO);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_drawIndirectBuffer);
+
+    for (const DrawBatch& batch : m_drawBatches[TO_INT(slab)]) {
         // 1. Deferred Objects: Do not apply lighting effects to cube map textures.
         // 2. Sphere: Apply lighting effects directly to the sphere's surface.
-        glUniform1f(m_gObjectTypeLoc, renderPass == RenderPass::SPHERETEX_GENERATION ? 0 : static_cast<float>(obj.GetObjType()) / TO_INT(Core::ObjectType::NUM_OBJ_TYPES));
+        m_glState.Uniform1f(m_gObjectTypeLoc, renderPass == RenderPass::SPHERETEX_GENERATION ? 0 : static_cast<float>(batch.type) / TO_INT(Core::ObjectType::NUM_OBJ_TYPES));
 
-        if (obj.GetObjType() == Core::ObjectType::REFLECTIVE_CURVED && renderPass == RenderPass::MIRRORTEX_GENERATION) {//spherical mirror
-            continue;           /*  Will use sphere rendering program to apply reflection & refraction textures on sphere */
+        /*  Objects left out of a pass (mirrors in the mirror texture, the mirror in the sphere texture)
+            never make it into its batches, see IsDrawnInSlab.
+        */
+        if (batch.type == Core::ObjectType::REFLECTIVE_FLAT)
+        {
+            SendMirrorTexID();
         }
         else
         {
-            if (renderPass == RenderPass::MIRRORTEX_GENERATION && (obj.GetObjType() == Core::ObjectType::REFLECTIVE_FLAT))
-            {
-                continue;           /*  Not drawing objects behind mirror & mirror itself */
+            SendObjTexID(m_glState, resourceManager.GetTexture(batch.image), TO_INT(ActiveTexID::COLOR), m_gColorTexLoc);
+        }
+
+        if (batch.type == Core::ObjectType::NORMAL_MAPPED_PLANE)   /*  apply normal mapping / parallax mapping for the base */
+        {
+            SendObjTexID(m_glState, resourceManager.m_normalTexID, TO_INT(ActiveTexID::NORMAL), m_gNormalTexLoc);
+            m_glState.Uniform1i(m_gNormalMappingOnLoc, true);
+            m_glState.Uniform1i(m_gParallaxMappingOnLoc, m_parallaxMappingOn);
+
+            //either plane itself or reflected plane on the mirror
+            if (m_parallaxMappingOn || renderPass == RenderPass::MIRRORTEX_GENERATION) {
+                SendObjTexID(m_glState, resourceManager.m_bumpTexID, TO_INT(ActiveTexID::BUMP), m_gBumpTexLoc);
             }
-            else
-            {
-                if (renderPass == RenderPass::SPHERETEX_GENERATION && (obj.GetObjType() == Core::ObjectType::REFLECTIVE_FLAT)) {
-                    continue;           /*  Not drawing mirror when generating reflection/refraction texture for sphere to avoid inter-reflection */
-                }
-                else
-                {
-                    if (obj.GetObjType() == Core::ObjectType::REFLECTIVE_FLAT)
-                    {
-                        SendMirrorTexID();
-                    }
-                    else
-                    {
-                        SendObjTexID(resourceManager.GetTexture(obj.GetImageID()), TO_INT(ActiveTexID::COLOR), m_gColorTexLoc);
-                    }
-
-                    if (renderPass == RenderPass::NORMAL) {
-						SendMVMat(m_mainCamMVMat[i], m_mainCamNormalMVMat[i], m_gMVMatLoc, m_gNMVMatLoc);
-                    }
-                    else if (renderPass == RenderPass::MIRRORTEX_GENERATION) {
-                        SendMVMat(m_mirrorCamMVMat[i], m_mirrorCamNormalMVMat[i], m_gMVMatLoc, m_gNMVMatLoc);
-                    }
-                    else if (renderPass == RenderPass::SPHERETEX_GENERATION) {
-                        SendMVMat(m_sphereCamMVMat[i][faceIdx], m_sphereCamNormalMVMat[i][faceIdx], m_gMVMatLoc, m_gNMVMatLoc);
-                    }
-
-                    if (obj.GetObjType() == Core::ObjectType::NORMAL_MAPPED_PLANE)   /*  apply normal mapping / parallax mapping for the base */
-                    {
-                        SendObjTexID(resourceManager.m_normalTexID, TO_INT(ActiveTexID::NORMAL), m_gNormalTexLoc);
-                        glUniform1i(m_gNormalMappingOnLoc, true);
-                        glUniform1i(m_gParallaxMappingOnLoc, m_parallaxMappingOn);
-
-                        //either plane itself or reflected plane on the mirror
-                        if (m_parallaxMappingOn || renderPass==RenderPass::MIRRORTEX_GENERATION) {
-                            SendObjTexID(resourceManager.m_bumpTexID, TO_INT(ActiveTexID::BUMP), m_gBumpTexLoc);
-                        }
-                    }
-                    else                       /*  not apply normal mapping / parallax mapping for other objects */
-                    {
-                        glUniform1i(m_gNormalMappingOnLoc, false);
-                        glUniform1i(m_gParallaxMappingOnLoc, false);
-                    }
-
-                    /*  The mirror surface is rendered to face away to simulate the flipped effect.
-                        Hence we need to perform front-face culling for it.
-                        Other objects use back-face culling as usual.
-                    */
-                    if (obj.GetObjType() == Core::ObjectType::REFLECTIVE_FLAT) {
-                        glCullFace(GL_FRONT);
-                    }
-
-                    RenderObj(obj);
-
-                    /*  Trigger back-face culling again */
-                    if (obj.GetObjType() == Core::ObjectType::REFLECTIVE_FLAT) {
-                        glCullFace(GL_BACK);
-                    }
-                }
+        }
+        else                       /*  not apply normal mapping / parallax mapping for other objects */
+        {
+            m_glState.Uniform1i(m_gNormalMappingOnLoc, false);
+            m_glState.Uniform1i(m_gParallaxMappingOnLoc, false);
+        }
+
+        /*  The mirror surface is rendered to face away to simulate the flipped effect.
+            Hence we need to perform front-face culling for it.
+            Other objects use back-face culling as usual.
+        */
+        m_glState.CullFace(batch.type == Core::ObjectType::REFLECTIVE_FLAT ? GL_FRONT : GL_BACK);
+
+        /*  One command per mesh, each instancing the batch's objects of that mesh */
+        const size_t commandOffset = batch.firstCommand * sizeof(DrawElementsIndirectCommand);
+        if (m_multiDrawElementsIndirect) {
+            using MultiDrawElementsIndirectProc = void (APIENTRY*)(GLenum, GLenum, const void*, GLsizei, GLsizei);
+            reinterpret_cast<MultiDrawElementsIndirectProc>(m_multiDrawElementsIndirect)(
+                GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(commandOffset), batch.commandCount, 0);
+        }
+        else {
+            for (GLsizei c = 0; c < batch.commandCount; ++c) {
+                glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                    reinterpret_cast<const void*>(commandOffset + c * sizeof(DrawElementsIndirectCommand)));
             }
         }
     }
+
+    /*  Trigger back-face culling again */
+    m_glState.CullFace(GL_BACK);
 }
 
 /******************************************************************************/
 /*!
-\fn     void RenderToSphereCubeMapTexture(unsigned char *sphereCubeMapTexture[])
+\fn     void RenderToSphereCubeMapTexture(const Core::Scene& scene)
 \brief
         Render the scene to 6 faces of the cubemap for sphere
         reflection/refraction later.
@@ -1662,38 +2759,54 @@ void Renderer::RenderObjects(RenderPass renderPass, const Core::Scene& scene, in
 /******************************************************************************/
 void Renderer::RenderToSphereCubeMapTexture(const Core::Scene& scene)
 {
-    /*  Theoretically the rendering to cubemap texture can be done in the same way as 2D texture:
-        rendering straight to the GPU cubemap texture object, similar to what we do for the
-        2D mirror texture in RenderToMirrorTexture.
-        However, some graphics drivers don't seem to implement the framebuffer cubemap texture properly.
-        So we do the cubemap texture writing manually here: copy the framebuffer to CPU texture data,
-        then copy that data to GPU texture object later (in SetUpSphereTexture function).
+    /*  Each face is rendered straight into the GPU cubemap texture object, similar to what we do
+        for the 2D mirror texture in RenderToMirrorTexture.
+        Some graphics drivers don't implement the framebuffer cubemap texture properly (see
+        SetUpSphereCubeMapTarget). There, each face is rendered to a 2D texture, read into a pixel
+        buffer and copied from that buffer into the cubemap: the data never leaves the GPU and
+        nothing waits for the reads to finish.
     */
     ResourceManager& resourceManager = ResourceManager::GetInstance();
+    const int faceSize = resourceManager.m_skyboxFaceSize >> m_sphereCubeLevel;    // size of the level rendered to
+    const size_t faceBytes = static_cast<size_t>(faceSize) * faceSize * 4;
 
-    GLuint sphereFrameBufferID;
-    glGenFramebuffers(1, &sphereFrameBufferID);
-    glBindFramebuffer(GL_FRAMEBUFFER, sphereFrameBufferID);
-
-    GLuint sphereFrameBufferTexID;
-    glGenTextures(1, &sphereFrameBufferTexID);
-    glBindTexture(GL_TEXTURE_2D, sphereFrameBufferTexID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, resourceManager.m_skyboxFaceSize, resourceManager.m_skyboxFaceSize,0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_sphereCubeFBO);
+    if (m_sphereCubeDirect == false) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_sphereFacePBO);
+    }
 
     for (int i = 0; i < TO_INT(CubeFaceID::NUM_FACES); ++i)
     {
-        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, sphereFrameBufferTexID, 0);
+        if (m_sphereFaceRendered[i] == false) {
+            continue;
+        }
+        if (m_sphereCubeDirect) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, resourceManager.m_sphereTexID, m_sphereCubeLevel);
+        }
 
         RenderObjects(RenderPass::SPHERETEX_GENERATION, scene,i);
 
-        glReadBuffer(GL_COLOR_ATTACHMENT0);
-        glReadPixels(0, 0, resourceManager.m_skyboxFaceSize, resourceManager.m_skyboxFaceSize, GL_RGBA, GL_UNSIGNED_BYTE, resourceManager.m_sphereCubeMapData[i].get());
+        if (m_sphereCubeDirect == false) {
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+            glReadPixels(0, 0, faceSize, faceSize, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<void*>(i * faceBytes));
+        }
     }
 
-    glDeleteTextures(1, &sphereFrameBufferTexID);
-    glDeleteFramebuffers(1, &sphereFrameBufferID);
-
-    resourceManager.SetUpSphereCubeMapTexture();
+    m_glState.BindTexture(TO_INT(ActiveTexID::COLOR), GL_TEXTURE_CUBE_MAP, resourceManager.m_sphereTexID);
+    if (m_sphereCubeDirect == false)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_sphereFacePBO);
+        for (int i = 0; i < TO_INT(CubeFaceID::NUM_FACES); ++i) {
+            if (m_sphereFaceRendered[i] == false) {
+                continue;
+            }
+            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, m_sphereCubeLevel, 0, 0, faceSize, faceSize,
+                GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<void*>(i * faceBytes));
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 }
 
 
@@ -1703,12 +2816,17 @@ void Renderer::RenderToSphereCubeMapTexture(const Core::Scene& scene)
 \brief
         Render the scene to the texture for mirror reflection. This texture was
         already bound to mirrorFrameBufferID in SetUpMirrorTexture function.
+        The frustum it was rendered with is kept, see MarkMirrorTexStale.
 */
 /******************************************************************************/
 void Renderer::RenderToMirrorTexture(const Core::Scene& scene)
 {
     glBindFramebuffer(GL_FRAMEBUFFER, ResourceManager::GetInstance().m_mirrorFrameBufferID);
     RenderObjects(RenderPass::MIRRORTEX_GENERATION,scene);
+
+    const Vec4* planes = m_mvSlabViews[TO_INT(MVSlabID::MIRROR_CAM)].frustumPlanes;
+    std::copy(planes, planes + 6, m_mirrorTexPlanes);
+    m_mirrorTexStale = false;
 }
 
 
@@ -1737,38 +2855,74 @@ void Renderer::RenderToScreen(const Core::Scene& scene)
 /******************************************************************************/
 void Renderer::Render(Core::Scene& scene, float fps, float dt)
 {
+    const auto frameStart = std::chrono::steady_clock::now();
+    m_glState.BeginFrame();
+    UpdateRenderScale();
+
     // update matrix
+    UpdateObjectMatrices(scene);
     ComputeMainCamMats(scene);
     ComputeMirrorCamMats(scene);
 
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
+    const bool updateSphereCubemap = SelectSphereCubeFaces(scene, fps);
+    if (updateSphereCubemap) {
+        ComputeSphereCamMats(scene);
+    }
+
+    // model-view matrices of every pass, batched and uploaded once for the whole frame
+    ComputeAllObjMVMats();
+    BuildDrawBatches(scene);
+
+    if (m_window) {
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+    }
 
     // (1) Geometry Pass
-    RenderGeometryPass(scene,fps);
+    RenderGeometryPass(scene, updateSphereCubemap);
     // (2) shadow mapping
-    RenderShadowMap(scene);
+    {
+        GpuProfiler::Scope scope(m_gpuProfiler, "Shadow Map");
+        RenderShadowMap(scene);
+    }
     // (3) light pass
-    RenderLightPass(scene);
+    {
+        GpuProfiler::Scope scope(m_gpuProfiler, "Light Pass");
+        RenderLightPass(scene);
+    }
+    if (m_frameCaptureOn) {
+        CaptureFrame();
+    }
+    ++m_frameIndex;
     // (4) GUI
-    //RenderGui(scene, fps);
+    if (m_window) {
+        RenderGui(scene, fps);
+    }
 
     // Update lights here to reduce frame buffer swaps by 1
     UpdateOrbitalLights(scene, dt);
 
     // Rendering    
-    ImGui::Render();
-    int display_W, display_H;
-    glfwGetFramebufferSize(m_window.get(), &display_W, &display_H);
-    glViewport(0, 0, display_W, display_H);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    if (m_window) {
+        ImGui::Render();
+        int display_W, display_H;
+        glfwGetFramebufferSize(m_window.get(), &display_W, &display_H);
+        glViewport(0, 0, display_W, display_H);
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
 
     mainCam.moved = false;
     mainCam.resized = false;
-    mirrorCam.moved = true;
+    mirrorCam.moved = false;
 
-    glfwSwapBuffers(m_window.get());
+    m_cpuFrameMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    if (m_window) {
+        glfwSwapBuffers(m_window.get());
+    }
+    else {
+        glFlush();  // what the swap does otherwise, so that the GPU gets the frame
+    }
 }
 
 Rendering::Renderer::~Renderer() {
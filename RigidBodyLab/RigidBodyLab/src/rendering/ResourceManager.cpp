@@ -9,43 +9,10 @@
 using namespace Rendering;
 
 ResourceManager::ResourceManager()
-	:m_meshes{}, m_textureIDs{}
+	:m_meshLibrary{}, m_textureIDs{}
 {
     stbi_set_flip_vertically_on_load(true);
- 
-    m_meshes[TO_INT(MeshID::CUBE)] = std::make_unique<Mesh>(Mesh::CreateCube(1, 1, 1));
-    
-    m_meshes[TO_INT(MeshID::PLANE)] = std::make_unique<Mesh>(Mesh::CreatePlane(1, 1));
-    
-    m_meshes[TO_INT(MeshID::SPHERE)] = std::make_unique<Mesh>(Mesh::CreateSphere(16, 16));
-    
-    m_meshes[TO_INT(MeshID::VASE)] = std::make_unique<Mesh>(Mesh::LoadOBJMesh("../RigidBodyLab/models/vase.obj"));
-    
-    // adjust the teapot's bounding box. The original model has an elongated shape (oval), so we scale its x-dimension to achieve a more proportionate and visually pleasing appearance.
-    m_meshes[TO_INT(MeshID::TEAPOT)] = std::make_unique<Mesh>(Mesh::LoadOBJMesh("../RigidBodyLab/models/teapot.obj"));
-    m_meshes[TO_INT(MeshID::TEAPOT)]->m_boundingBox.extents.x *= 2.f; 
-    
-    m_meshes[TO_INT(MeshID::DIAMOND)] = std::make_unique<Mesh>(Mesh::LoadOBJMesh("../RigidBodyLab/models/diamond.obj"));
-    
-    m_meshes[TO_INT(MeshID::DODECAHEDRON)] = std::make_unique<Mesh>(Mesh::LoadOBJMesh("../RigidBodyLab/models/dodecahedron.obj"));
-    
-    m_meshes[TO_INT(MeshID::GOURD)] = std::make_unique<Mesh>(Mesh::LoadOBJMesh("../RigidBodyLab/models/gourd.obj"));
-    
-    // adjust the cat's bounding box. The original model has an elongated shape (oval), so we scale its x-dimension to achieve a more proportionate and visually pleasing appearance.
-    m_meshes[TO_INT(MeshID::CAT)] = std::make_unique<Mesh>(Mesh::LoadOBJMesh("../RigidBodyLab/models/cat.obj"));
-    m_meshes[TO_INT(MeshID::CAT)]->m_boundingBox.extents.x *= 2.f;
- 
-    m_meshes[TO_INT(MeshID::GIRL_RIGHTY)] = std::make_unique<Mesh>(Mesh::LoadOBJMesh("../RigidBodyLab/models/model.obj"));
-    //m_meshes[TO_INT(MeshID::GIRL_RIGHTY)]->m_boundingBox.extents.y *= 1.f;
-    m_meshes[TO_INT(MeshID::GIRL_RIGHTY)]->m_boundingBox.extents.x *= 0.5f;
-    m_meshes[TO_INT(MeshID::GIRL_RIGHTY)]->m_boundingBox.extents.z *= 0.5f;
-
-    //m_meshes[TO_INT(MeshID::GIRL_LEFTY)] = std::make_unique<Mesh>(Mesh::LoadOBJMesh("../RigidBodyLab/models/model.obj", true));
-    //m_meshes[TO_INT(MeshID::GIRL_LEFTY)]->m_boundingBox.extents.x *= 0.5f;
-    //m_meshes[TO_INT(MeshID::GIRL_LEFTY)]->m_boundingBox.extents.z *= 0.5f;
-
-    m_meshes[TO_INT(MeshID::GRIM_REAPER_LEFTY)] = std::make_unique<Mesh>(Mesh::LoadOBJMesh("../RigidBodyLab/models/death.obj"));
-    //m_meshes[TO_INT(MeshID::GRIM_REAPER_RIGHTY)] = std::make_unique<Mesh>(Mesh::LoadOBJMesh("../RigidBodyLab/models/death.obj", true));
+    m_meshLibrary.LoadDefaultMeshes();
 }
 
 ResourceManager& ResourceManager::GetInstance()
@@ -54,18 +21,6 @@ ResourceManager& ResourceManager::GetInstance()
     return instance;
 }
 
-Mesh* Rendering::ResourceManager::GetMesh(MeshID id) {
-    return m_meshes[TO_INT(id)].get();
-}
-
-const Mesh* Rendering::ResourceManager::GetMesh(MeshID id) const{
-    return m_meshes[TO_INT(id)].get();
-}
-
-void Rendering::ResourceManager::SetMesh(MeshID id, std::unique_ptr<Mesh> newMesh) {
-    m_meshes[TO_INT(id)] = std::move(newMesh);
-}
-
 GLuint Rendering::ResourceManager::GetTexture(ImageID id) {
 	return m_textureIDs[TO_INT(id)];
 }
@@ -241,14 +196,6 @@ void Rendering::ResourceManager::SetUpPlanarMirrorTexture()
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void Rendering::ResourceManager::InitSphericalMirrorTexture() {
-    //SetUp the cube map for the spherical mirror
-    const int numFaces = TO_INT(CubeFaceID::NUM_FACES);
-    for (int i = 0; i < numFaces; ++i) {
-        m_sphereCubeMapData[i] = std::make_unique<unsigned char[]>(m_skyboxFaceSize * m_skyboxFaceSize * 4);
-    }
-}
-
 /******************************************************************************/
 /*!
 \fn     void SetUpSkyBoxTexture()
@@ -324,7 +271,7 @@ void Rendering::ResourceManager::SetUpSkyBoxTexture()
     //    free(cubeFace[f].get());
     //}
 
-    InitSphericalMirrorTexture();
+    SetUpSphereCubeMapTexture();
 }
 
 //loads 6 separate skybox face textures
@@ -367,14 +314,16 @@ void Rendering::ResourceManager::SetUpSeparateSkyBoxTexture()
     // generate mipmaps for the cubemap
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
-    InitSphericalMirrorTexture();
+    SetUpSphereCubeMapTexture();
 }
 
 /******************************************************************************/
 /*!
-\fn     void SetUpSphereTexture()
+\fn     void SetUpSphereCubeMapTexture()
 \brief
 Set up texture object for rendering sphere reflection/refraction.
+The storage is allocated once, at the skybox face size; the renderer draws
+into its faces whenever the reflection has to be updated.
 */
 /******************************************************************************/
 
@@ -383,9 +332,11 @@ void Rendering::ResourceManager::SetUpSphereCubeMapTexture()
     glGenTextures(1, &m_sphereTexID);
     glBindTexture(GL_TEXTURE_CUBE_MAP, m_sphereTexID);
 
-    for (int f = 0; f < TO_INT(CubeFaceID::NUM_FACES); ++f)
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, 0, GL_RGBA8, m_skyboxFaceSize, m_skyboxFaceSize,
-            0, GL_RGBA, GL_UNSIGNED_BYTE, m_sphereCubeMapData[f].get());
+    int numLevels = 1;
+    while ((m_skyboxFaceSize >> numLevels) > 0) {
+        ++numLevels;
+    }
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, numLevels, GL_RGBA8, m_skyboxFaceSize, m_skyboxFaceSize);
 
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_REPEAT);
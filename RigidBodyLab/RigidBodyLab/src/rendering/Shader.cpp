@@ -1,4 +1,5 @@
 #include <rendering/Shader.h>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
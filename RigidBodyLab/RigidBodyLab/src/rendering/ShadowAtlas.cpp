@@ -0,0 +1,156 @@
+#include <rendering/ShadowAtlas.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace Rendering;
+
+
+/******************************************************************************/
+/*!
+\fn     float ScreenImportance(const Vec4& lightSphereVF, const Mat4& projMat, float nearPlane)
+\brief
+        How much of the screen the sphere of influence of a light covers:
+        0 when it is outside the view frustum, up to 1 when its diameter
+        spans the screen height or the camera is inside it.
+\param  lightSphereVF
+        View-frame position in xyz, radius of influence in w.
+*/
+/******************************************************************************/
+float ShadowAtlas::ScreenImportance(const Vec4& lightSphereVF, const Mat4& projMat, float nearPlane)
+{
+    const Vec3 center(lightSphereVF);
+    const float radius = lightSphereVF.w;
+    const float depth = -center.z;
+    if (depth + radius < nearPlane) {
+        return 0.f;
+    }
+
+    /*  The projection alone gives the frustum planes in the view frame */
+    Vec4 planes[6];
+    FrustumPlanes(projMat, planes);
+    for (const Vec4& plane : planes) {
+        if (glm::dot(Vec3(plane), center) + plane.w < -radius * glm::length(Vec3(plane))) {
+            return 0.f;
+        }
+    }
+
+    if (depth <= radius) {
+        return 1.f;
+    }
+    return std::min(radius * projMat[1][1] / depth, 1.f);
+}
+
+
+/******************************************************************************/
+/*!
+\fn     void Plan(const float* importance, int numLights, int updateBudget)
+\brief
+        Lay out the tiles of this frame and choose the ones to re-render,
+        see the class comment. A tile that keeps its light and its place in
+        the atlas keeps its content; any other tile starts out empty.
+\param  importance
+        Per light, its ScreenImportance(); lights at 0 get no tile.
+\param  updateBudget
+        Maximum number of tiles rendered this frame.
+*/
+/******************************************************************************/
+void ShadowAtlas::Plan(const float* importance, int numLights, int updateBudget)
+{
+    ++m_frame;
+    m_prevTiles.swap(m_tiles);
+    m_tiles.clear();
+
+    m_order.clear();
+    for (int l = 0; l < numLights; ++l) {
+        if (importance[l] > 0.f) {
+            m_order.push_back(l);
+        }
+    }
+    std::stable_sort(m_order.begin(), m_order.end(), [importance](int a, int b) { return importance[a] > importance[b]; });
+    if (m_order.size() > MAX_SHADOWED_LIGHTS) {
+        m_order.resize(MAX_SHADOWED_LIGHTS);
+    }
+
+    /*  Smallest power of two covering importance * MAX_TILE_SIZE, so sizes never increase along the order */
+    long long area = 0;
+    for (int l : m_order) {
+        Tile tile;
+        tile.light = l;
+        tile.importance = importance[l];
+        tile.size = MIN_TILE_SIZE;
+        while (tile.size < MAX_TILE_SIZE && tile.size < tile.importance * MAX_TILE_SIZE) {
+            tile.size *= 2;
+        }
+        area += static_cast<long long>(tile.size) * tile.size;
+        m_tiles.push_back(tile);
+    }
+
+    /*  Halving the last tile above the minimum size keeps the sizes non-increasing */
+    const long long atlasArea = static_cast<long long>(ATLAS_SIZE) * ATLAS_SIZE;
+    for (int t = static_cast<int>(m_tiles.size()) - 1; area > atlasArea && t >= 0; ) {
+        if (m_tiles[t].size == MIN_TILE_SIZE) {
+            --t;
+            continue;
+        }
+        area -= 3ll * (m_tiles[t].size / 2) * (m_tiles[t].size / 2);
+        m_tiles[t].size /= 2;
+    }
+
+    /*  With the tiles sorted largest first, every tile starts at a multiple of its own cell count
+        along the Z curve, so it covers an aligned square of cells.
+    */
+    int cursor = 0;
+    for (Tile& tile : m_tiles)
+    {
+        int cellX = 0, cellY = 0;
+        for (int bit = 0; (cursor >> (2 * bit)) != 0; ++bit) {
+            cellX |= ((cursor >> (2 * bit)) & 1) << bit;
+            cellY |= ((cursor >> (2 * bit + 1)) & 1) << bit;
+        }
+        tile.x = cellX * MIN_TILE_SIZE;
+        tile.y = cellY * MIN_TILE_SIZE;
+        cursor += (tile.size / MIN_TILE_SIZE) * (tile.size / MIN_TILE_SIZE);
+
+        for (const Tile& prev : m_prevTiles) {
+            if (prev.light == tile.light && prev.x == tile.x && prev.y == tile.y && prev.size == tile.size) {
+                tile.rendered = prev.rendered;
+                tile.renderedMat = prev.renderedMat;
+                tile.renderedFrame = prev.renderedFrame;
+                tile.staticValid = prev.staticValid;
+                tile.staticMat = prev.staticMat;
+                break;
+            }
+        }
+    }
+
+    /*  Empty tiles first, in importance order, then the most important and stalest */
+    auto Priority = [this](int t) {
+        const Tile& tile = m_tiles[t];
+        return tile.rendered ? tile.importance * static_cast<float>(m_frame - tile.renderedFrame) : FLT_MAX;
+    };
+    m_updates.clear();
+    for (int t = 0; t < static_cast<int>(m_tiles.size()); ++t) {
+        m_updates.push_back(t);
+    }
+    std::stable_sort(m_updates.begin(), m_updates.end(), [&Priority](int a, int b) { return Priority(a) > Priority(b); });
+    m_updates.resize(std::min<size_t>(m_updates.size(), std::max(updateBudget, 0)));
+}
+
+
+void ShadowAtlas::MarkRendered(int tileIdx, const Mat4& lightSpaceMat)
+{
+    Tile& tile = m_tiles[tileIdx];
+    tile.rendered = true;
+    tile.renderedMat = lightSpaceMat;
+    tile.renderedFrame = m_frame;
+}
+
+
+/*  The static layer of every tile has to be redrawn, e.g. when an object became static */
+void ShadowAtlas::InvalidateStatic()
+{
+    for (Tile& tile : m_tiles) {
+        tile.staticValid = false;
+    }
+}
@@ -5,6 +5,12 @@
 
 using namespace Math;
 
+namespace {
+    // lane i of a register, as the MSVC-only '.m128_f32[i]' but portable
+    inline float& Lane(__m128& v, int i) { return reinterpret_cast<float*>(&v)[i]; }
+    inline float Lane(const __m128& v, int i) { return reinterpret_cast<const float*>(&v)[i]; }
+}
+
 Matrix4::Matrix4(float value) {
     columns[0] = _mm_set_ps(0.0f, 0.0f, 0.0f, value);
     columns[1] = _mm_set_ps(0.0f, 0.0f, value, 0.0f);
@@ -135,14 +141,16 @@ Matrix4 Matrix4::operator*(const Matrix4& other) const {
     for (int i{}; i < 4; ++i) { // columns (in the result)
         for (int j{}; j < 4; ++j) { // rows (in the result)
 
-            __m128 row = _mm_setr_ps(columns[0].m128_f32[i], columns[1].m128_f32[i], columns[2].m128_f32[i], columns[3].m128_f32[i]);
-            __m128 col = _mm_setr_ps(other.columns[j].m128_f32[0], other.columns[j].m128_f32[1], other.columns[j].m128_f32[2], other.columns[j].m128_f32[3]);
+            __m128 row = _mm_setr_ps(Lane(columns[0], i), Lane(columns[1], i), Lane(columns[2], i), Lane(columns[3], i));
+            __m128 col = other.columns[j];
 
+            // (m0 + m1) + (m2 + m3), as two '_mm_hadd_ps' would, but with SSE2 only (SSE3 is not in the x86-64 baseline)
             __m128 mul = _mm_mul_ps(row, col);
-            mul = _mm_hadd_ps(mul, mul);
-            mul = _mm_hadd_ps(mul, mul);
+            __m128 swapped = _mm_shuffle_ps(mul, mul, _MM_SHUFFLE(2, 3, 0, 1));
+            __m128 sums = _mm_add_ps(mul, swapped);
+            sums = _mm_add_ss(sums, _mm_movehl_ps(swapped, sums));
 
-            result.columns[j].m128_f32[i] = _mm_cvtss_f32(mul);
+            Lane(result.columns[j], i) = _mm_cvtss_f32(sums);
         }
     }
 
@@ -161,10 +169,10 @@ Matrix4& Matrix4::operator*=(const Matrix4& other) {
 
 
 Vector3 Matrix4::operator*(const Vector4& vec) const {
-    float x = columns[0].m128_f32[0] * vec.vec3.x + columns[1].m128_f32[0] * vec.vec3.y + columns[2].m128_f32[0] * vec.vec3.z + vec.w * columns[3].m128_f32[0];
-    float y = columns[0].m128_f32[1] * vec.vec3.x + columns[1].m128_f32[1] * vec.vec3.y + columns[2].m128_f32[1] * vec.vec3.z + vec.w * columns[3].m128_f32[1];
-    float z = columns[0].m128_f32[2] * vec.vec3.x + columns[1].m128_f32[2] * vec.vec3.y + columns[2].m128_f32[2] * vec.vec3.z + vec.w * columns[3].m128_f32[2];
-    //float w = columns[0].m128_f32[3] * vec.x + columns[1].m128_f32[3] * vec.y + columns[2].m128_f32[3] * vec.z + columns[3].m128_f32[3];
+    float x = Lane(columns[0], 0) * vec.vec3.x + Lane(columns[1], 0) * vec.vec3.y + Lane(columns[2], 0) * vec.vec3.z + vec.w * Lane(columns[3], 0);
+    float y = Lane(columns[0], 1) * vec.vec3.x + Lane(columns[1], 1) * vec.vec3.y + Lane(columns[2], 1) * vec.vec3.z + vec.w * Lane(columns[3], 1);
+    float z = Lane(columns[0], 2) * vec.vec3.x + Lane(columns[1], 2) * vec.vec3.y + Lane(columns[2], 2) * vec.vec3.z + vec.w * Lane(columns[3], 2);
+    //float w = Lane(columns[0], 3) * vec.x + Lane(columns[1], 3) * vec.y + Lane(columns[2], 3) * vec.z + Lane(columns[3], 3);
 
     //if (w != 1.f && w != 0.f) {
     //    x /= w;
@@ -248,7 +256,7 @@ float Math::Matrix4::Get(int row, int column) const {
     if (row < 0 || row > 3 || column < 0 || column > 3) {
         throw std::out_of_range("Index out of bounds for Matrix4");
     }
-    return columns[row].m128_f32[column];
+    return Lane(columns[row], column);
 }
 
 
@@ -257,7 +265,7 @@ void Math::Matrix4::Set(int row, int column, float value) {
     if (row < 0 || row > 3 || column < 0 || column > 3) {
         throw std::out_of_range("Index out of bounds for Matrix4");
     }
-    columns[row].m128_f32[column] = value;
+    Lane(columns[row], column) = value;
 }
 
 Matrix3 Matrix4::Extract3x3Matrix() const {
@@ -282,7 +290,7 @@ Matrix3 Matrix4::Extract3x3Matrix() const {
 //
 //    for (int row = 0; row < 4; ++row) {
 //        for (int col = 0; col < 4; ++col) {
-//            result[row][col] = columns[row].m128_f32[col];
+//            result[row][col] = Lane(columns[row], col);
 //        }
 //    }
 //
@@ -6,6 +6,15 @@
 #include "Matrix3.h"
 #include "Matrix4.h"
 #include "Transform.h"
+#include <math/SimdKernels.h>
+#include <rendering/RenderQueue.h>
+#include <rendering/OcclusionBuffer.h>
+#include <rendering/DynamicResolution.h>
+#include <rendering/ProfileLog.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <vector>
 
 constexpr float EPSILON = 1e-5f;
 constexpr float LOOSE_EPSILON = 1e-3f;
@@ -668,4 +677,521 @@ Matrix3 Extract3x3Matrix_old(Matrix4 ths) {
     }
 
     return result;
-}
\ No newline at end of file
+}
+
+
+// 37 is deliberately not a multiple of any lane width, so every level also runs its scalar tail.
+constexpr size_t SIMD_TEST_COUNT = 37;
+
+static std::vector<const SimdKernelTable*> SupportedSimdKernels() {
+    std::vector<const SimdKernelTable*> tables;
+    for (int level{}; level < static_cast<int>(SimdLevel::COUNT); ++level) {
+        if (const SimdKernelTable* table = GetSimdKernels(static_cast<SimdLevel>(level))) {
+            tables.push_back(table);
+        }
+    }
+    return tables;
+}
+
+TEST(SimdKernelsTest, SSE2AlwaysAvailable) {
+    ASSERT_NE(GetSimdKernels(SimdLevel::SSE2), nullptr);
+    EXPECT_EQ(GetSimdKernels().level, DetectSimdLevel());
+}
+
+TEST(SimdKernelsTest, TransformPoints) {
+    const float mat[16]{ 0.f, 1.f, 0.f, 0.f,   -2.f, 0.f, 0.f, 0.f,   0.f, 0.f, 3.f, 0.f,   5.f, -6.f, 7.f, 1.f };
+    std::vector<float> x(SIMD_TEST_COUNT), y(SIMD_TEST_COUNT), z(SIMD_TEST_COUNT);
+    for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+        x[i] = static_cast<float>(i);
+        y[i] = 0.5f * static_cast<float>(i) - 3.f;
+        z[i] = -static_cast<float>(i % 5);
+    }
+
+    for (const SimdKernelTable* kernels : SupportedSimdKernels()) {
+        std::vector<float> ox(SIMD_TEST_COUNT), oy(SIMD_TEST_COUNT), oz(SIMD_TEST_COUNT);
+        kernels->transformPoints(mat, { x.data(), y.data(), z.data() }, { ox.data(), oy.data(), oz.data() }, SIMD_TEST_COUNT);
+
+        for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+            EXPECT_FLOAT_EQ(ox[i], -2.f * y[i] + 5.f) << ToString(kernels->level);
+            EXPECT_FLOAT_EQ(oy[i], x[i] - 6.f) << ToString(kernels->level);
+            EXPECT_FLOAT_EQ(oz[i], 3.f * z[i] + 7.f) << ToString(kernels->level);
+        }
+    }
+}
+
+TEST(SimdKernelsTest, BuildModelMatricesMatchesTransform) {
+    std::vector<float> qw(SIMD_TEST_COUNT), qx(SIMD_TEST_COUNT), qy(SIMD_TEST_COUNT), qz(SIMD_TEST_COUNT);
+    std::vector<float> px(SIMD_TEST_COUNT), py(SIMD_TEST_COUNT), pz(SIMD_TEST_COUNT);
+    std::vector<Core::Transform> transforms;
+
+    for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+        Quaternion q(10.f * static_cast<float>(i), Vector3(1.f, static_cast<float>(i % 3), 2.f).Normalize());
+        Vector3 p(static_cast<float>(i), -1.f, 0.25f * static_cast<float>(i));
+        transforms.emplace_back(p, q);
+
+        qw[i] = q.w; qx[i] = q.x; qy[i] = q.y; qz[i] = q.z;
+        px[i] = p.x; py[i] = p.y; pz[i] = p.z;
+    }
+
+    for (const SimdKernelTable* kernels : SupportedSimdKernels()) {
+        std::vector<float> planes(16 * SIMD_TEST_COUNT);
+        Mat4SoA out;
+        for (int e{}; e < 16; ++e) {
+            out.e[e] = planes.data() + e * SIMD_TEST_COUNT;
+        }
+        kernels->buildModelMatrices({ qw.data(), qx.data(), qy.data(), qz.data() }, { px.data(), py.data(), pz.data() }, out, SIMD_TEST_COUNT);
+
+        for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+            for (int e{}; e < 16; ++e) {
+                EXPECT_NEAR(out.e[e][i], transforms[i].m_localToWorld[e], EPSILON) << ToString(kernels->level);
+            }
+        }
+    }
+}
+
+TEST(SimdKernelsTest, ComputeNormalMatrices) {
+    const Matrix3 reference[3]{
+        Matrix3(2.f, 0.f, 1.f,   0.f, 3.f, 0.f,   -1.f, 0.f, 4.f),
+        Matrix3(1.f, 2.f, 3.f,   0.f, 1.f, 4.f,   5.f, 6.f, 0.f),
+        Matrix3(1.f, 2.f, 3.f,   2.f, 4.f, 6.f,   0.f, 1.f, 1.f) //singular
+    };
+
+    std::vector<float> planes(16 * SIMD_TEST_COUNT, 0.f);
+    ConstMat4SoA in;
+    for (int e{}; e < 16; ++e) {
+        in.e[e] = planes.data() + e * SIMD_TEST_COUNT;
+    }
+    for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+        const Matrix3& m = reference[i % 3];
+        for (int col{}; col < 3; ++col) {
+            for (int row{}; row < 3; ++row) {
+                planes[(col * 4 + row) * SIMD_TEST_COUNT + i] = m.entries[col][row];
+            }
+        }
+        planes[15 * SIMD_TEST_COUNT + i] = 1.f;
+    }
+
+    const Matrix3 expected[3]{ reference[0].Inverse().Transpose(), reference[1].Inverse().Transpose(), Matrix3{} };
+
+    for (const SimdKernelTable* kernels : SupportedSimdKernels()) {
+        std::vector<float> outPlanes(9 * SIMD_TEST_COUNT);
+        Mat3SoA out;
+        for (int e{}; e < 9; ++e) {
+            out.e[e] = outPlanes.data() + e * SIMD_TEST_COUNT;
+        }
+        kernels->computeNormalMatrices(in, out, SIMD_TEST_COUNT);
+
+        for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+            const Matrix3& n = expected[i % 3];
+            for (int col{}; col < 3; ++col) {
+                for (int row{}; row < 3; ++row) {
+                    EXPECT_NEAR(out.e[col * 3 + row][i], n.entries[col][row], LOOSE_EPSILON) << ToString(kernels->level);
+                }
+            }
+        }
+    }
+}
+
+TEST(SimdKernelsTest, UpdateRigidTransformsMatchesInertiaTensorTransform) {
+    std::vector<float> qw(SIMD_TEST_COUNT), qx(SIMD_TEST_COUNT), qy(SIMD_TEST_COUNT), qz(SIMD_TEST_COUNT);
+    std::vector<float> px(SIMD_TEST_COUNT), py(SIMD_TEST_COUNT), pz(SIMD_TEST_COUNT);
+    std::vector<float> inertiaPlanes(9 * SIMD_TEST_COUNT);
+    std::vector<Core::Transform> transforms;
+    std::vector<Matrix3> inverseInertia;
+
+    ConstMat3SoA inertiaIn;
+    for (int e{}; e < 9; ++e) {
+        inertiaIn.e[e] = inertiaPlanes.data() + e * SIMD_TEST_COUNT;
+    }
+
+    for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+        Quaternion q(7.f * static_cast<float>(i), Vector3(static_cast<float>(i % 4), 1.f, -1.f).Normalize());
+        Vector3 p(-static_cast<float>(i), 2.f, 0.5f);
+        transforms.emplace_back(p, q);
+        inverseInertia.emplace_back(1.f + static_cast<float>(i % 3), 0.5f, 2.f);
+
+        qw[i] = q.w; qx[i] = q.x; qy[i] = q.y; qz[i] = q.z;
+        px[i] = p.x; py[i] = p.y; pz[i] = p.z;
+        for (int col{}; col < 3; ++col) {
+            for (int row{}; row < 3; ++row) {
+                inertiaPlanes[(col * 3 + row) * SIMD_TEST_COUNT + i] = inverseInertia[i].entries[col][row];
+            }
+        }
+    }
+
+    for (const SimdKernelTable* kernels : SupportedSimdKernels()) {
+        std::vector<float> matPlanes(16 * SIMD_TEST_COUNT), worldPlanes(9 * SIMD_TEST_COUNT);
+        Mat4SoA localToWorld;
+        Mat3SoA inertiaWorld;
+        for (int e{}; e < 16; ++e) {
+            localToWorld.e[e] = matPlanes.data() + e * SIMD_TEST_COUNT;
+        }
+        for (int e{}; e < 9; ++e) {
+            inertiaWorld.e[e] = worldPlanes.data() + e * SIMD_TEST_COUNT;
+        }
+        kernels->updateRigidTransforms({ qw.data(), qx.data(), qy.data(), qz.data() }, { px.data(), py.data(), pz.data() },
+                                       inertiaIn, localToWorld, inertiaWorld, SIMD_TEST_COUNT);
+
+        for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+            for (int e{}; e < 16; ++e) {
+                EXPECT_NEAR(localToWorld.e[e][i], transforms[i].m_localToWorld[e], EPSILON) << ToString(kernels->level);
+            }
+
+            // same as RigidBody::TransformInertiaTensor
+            const Matrix3 rotation = transforms[i].m_localToWorld.Extract3x3Matrix();
+            const Matrix3 expected = (rotation * inverseInertia[i]) * rotation.Transpose();
+            for (int col{}; col < 3; ++col) {
+                for (int row{}; row < 3; ++row) {
+                    EXPECT_NEAR(inertiaWorld.e[col * 3 + row][i], expected.entries[col][row], LOOSE_EPSILON) << ToString(kernels->level);
+                }
+            }
+        }
+    }
+}
+
+TEST(SimdKernelsTest, CullBoxesAgainstUnitCube) {
+    // inside is -1 <= x, y, z <= 1
+    const float planes[24]{
+         1.f, 0.f, 0.f, 1.f,   -1.f, 0.f, 0.f, 1.f,
+         0.f, 1.f, 0.f, 1.f,    0.f, -1.f, 0.f, 1.f,
+         0.f, 0.f, 1.f, 1.f,    0.f, 0.f, -1.f, 1.f
+    };
+    std::vector<float> cx(SIMD_TEST_COUNT), cy(SIMD_TEST_COUNT), cz(SIMD_TEST_COUNT);
+    std::vector<float> ex(SIMD_TEST_COUNT), ey(SIMD_TEST_COUNT), ez(SIMD_TEST_COUNT);
+    std::vector<float> expected(SIMD_TEST_COUNT);
+
+    for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+        // boxes marching along x, some overlapping the cube only through their extents
+        cx[i] = -4.f + 0.25f * static_cast<float>(i);
+        cy[i] = (i % 3 == 0) ? 2.5f : 0.f;
+        cz[i] = 0.f;
+        ex[i] = 0.5f;
+        ey[i] = (i % 6 == 0) ? 2.f : 0.5f;
+        ez[i] = 0.5f;
+
+        const bool overlapsX = std::fabs(cx[i]) - ex[i] <= 1.f;
+        const bool overlapsY = std::fabs(cy[i]) - ey[i] <= 1.f;
+        expected[i] = (overlapsX && overlapsY) ? 1.f : 0.f;
+    }
+
+    for (const SimdKernelTable* kernels : SupportedSimdKernels()) {
+        std::vector<float> visible(SIMD_TEST_COUNT, -1.f);
+        kernels->cullBoxes(planes, 6, { cx.data(), cy.data(), cz.data() }, { ex.data(), ey.data(), ez.data() },
+                           visible.data(), SIMD_TEST_COUNT);
+
+        for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+            EXPECT_EQ(visible[i], expected[i]) << ToString(kernels->level) << " box " << i;
+        }
+    }
+}
+
+TEST(SimdKernelsTest, SphereOverlapsBoxes) {
+    const float sphere[4]{ 0.f, 0.f, 0.f, 1.5f };
+    std::vector<float> cx(SIMD_TEST_COUNT), cy(SIMD_TEST_COUNT), cz(SIMD_TEST_COUNT);
+    std::vector<float> ex(SIMD_TEST_COUNT), ey(SIMD_TEST_COUNT), ez(SIMD_TEST_COUNT);
+    std::vector<float> expected(SIMD_TEST_COUNT);
+
+    for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+        // unit boxes marching along a diagonal, so that the corner is the closest point for some of them
+        cx[i] = -3.f + 0.2f * static_cast<float>(i);
+        cy[i] = (i % 2 == 0) ? cx[i] : 0.f;
+        cz[i] = (i % 4 == 0) ? 1.25f : 0.f;
+        ex[i] = ey[i] = ez[i] = 0.5f;
+
+        float distSqrd = 0.f;
+        for (float d : { std::fabs(cx[i]) - ex[i], std::fabs(cy[i]) - ey[i], std::fabs(cz[i]) - ez[i] }) {
+            distSqrd += d > 0.f ? d * d : 0.f;
+        }
+        expected[i] = distSqrd <= sphere[3] * sphere[3] ? 1.f : 0.f;
+    }
+
+    for (const SimdKernelTable* kernels : SupportedSimdKernels()) {
+        std::vector<float> overlap(SIMD_TEST_COUNT, -1.f);
+        kernels->sphereOverlapsBoxes(sphere, { cx.data(), cy.data(), cz.data() }, { ex.data(), ey.data(), ez.data() },
+                                     overlap.data(), SIMD_TEST_COUNT);
+
+        for (size_t i{}; i < SIMD_TEST_COUNT; ++i) {
+            EXPECT_EQ(overlap[i], expected[i]) << ToString(kernels->level) << " box " << i;
+        }
+    }
+}
+
+TEST(SimdKernelsTest, RasterizeOccludersIsConservative) {
+    constexpr int WIDTH = 48, HEIGHT = 24;
+    // one counter-clockwise and one clockwise triangle, both sloped in depth
+    const float triangles[18]{
+         2.3f, 1.7f, 0.2f,   40.6f, 5.1f, 0.6f,   9.2f, 21.4f, 0.4f,
+        30.5f, 3.5f, 0.9f,   20.1f, 20.8f, 0.3f,  46.7f, 22.2f, 0.5f
+    };
+
+    std::vector<float> reference;
+    for (const SimdKernelTable* kernels : SupportedSimdKernels()) {
+        std::vector<float> depth(WIDTH * HEIGHT, 1.f);
+        kernels->rasterizeOccluders(triangles, 2, depth.data(), WIDTH, HEIGHT);
+
+        for (int y{}; y < HEIGHT; ++y) {
+            for (int x{}; x < WIDTH; ++x) {
+                // a pixel is written iff a triangle holds its center, and never nearer than that triangle over the whole pixel
+                float expected = 1.f;
+                for (int t{}; t < 2; ++t) {
+                    const float* v = triangles + 9 * t;
+                    const float area = (v[3] - v[0]) * (v[7] - v[1]) - (v[6] - v[0]) * (v[4] - v[1]);
+                    bool covered = false;
+                    float farthest = 0.f;
+                    for (int sample{}; sample < 5; ++sample) {    // the center, then the 4 corners
+                        const float px = sample == 0 ? x + 0.5f : static_cast<float>(x + (sample & 1));
+                        const float py = sample == 0 ? y + 0.5f : static_cast<float>(y + ((sample - 1) >> 1));
+                        float weights[3];
+                        for (int k{}; k < 3; ++k) {
+                            const float* p0 = v + 3 * ((k + 1) % 3);
+                            const float* p1 = v + 3 * ((k + 2) % 3);
+                            weights[k] = ((p1[0] - p0[0]) * (py - p0[1]) - (p1[1] - p0[1]) * (px - p0[0])) / area;
+                        }
+                        if (sample == 0) {
+                            covered = weights[0] >= 0.f && weights[1] >= 0.f && weights[2] >= 0.f;
+                        }
+                        farthest = std::max(farthest, weights[0] * v[2] + weights[1] * v[5] + weights[2] * v[8]);
+                    }
+                    if (covered) {
+                        expected = std::min(expected, std::min(farthest, std::max({ v[2], v[5], v[8] })));
+                    }
+                }
+                EXPECT_NEAR(depth[y * WIDTH + x], expected, LOOSE_EPSILON) << ToString(kernels->level) << " pixel " << x << ", " << y;
+            }
+        }
+
+        if (reference.empty()) {
+            reference = depth;
+        }
+        for (int p{}; p < WIDTH * HEIGHT; ++p) {
+            EXPECT_NEAR(depth[p], reference[p], EPSILON) << ToString(kernels->level) << " pixel " << p;
+        }
+    }
+}
+
+// Camera at the origin looking down -z: 90 degrees field of view, square, near 0.1, far 100
+static void OcclusionTestViewProj(float (&viewProj)[16]) {
+    const float nearPlane = 0.1f, farPlane = 100.f;
+    std::fill(std::begin(viewProj), std::end(viewProj), 0.f);
+    viewProj[0] = 1.f;
+    viewProj[5] = 1.f;
+    viewProj[10] = -(farPlane + nearPlane) / (farPlane - nearPlane);
+    viewProj[11] = -1.f;
+    viewProj[14] = -2.f * farPlane * nearPlane / (farPlane - nearPlane);
+}
+
+TEST(OcclusionBufferTest, WallHidesBoxesBehindIt) {
+    // 4x4 wall at z = -5, covering ndc [-0.4, 0.4] on both axes
+    Rendering::OccluderMesh wall;
+    wall.positions = { -2.f, -2.f, -5.f,   2.f, -2.f, -5.f,   2.f, 2.f, -5.f,   -2.f, 2.f, -5.f };
+    wall.indices = { 0, 1, 2,   0, 2, 3 };
+    const float identity[16]{ 1.f, 0.f, 0.f, 0.f,   0.f, 1.f, 0.f, 0.f,   0.f, 0.f, 1.f, 0.f,   0.f, 0.f, 0.f, 1.f };
+
+    float viewProj[16];
+    OcclusionTestViewProj(viewProj);
+    Rendering::OcclusionBuffer buffer(64, 64);
+    buffer.Begin(viewProj);
+    buffer.AddOccluder(wall, identity);
+    EXPECT_EQ(buffer.GetNumTriangles(), 2u);
+
+    const float half[3]{ 0.5f, 0.5f, 0.5f };
+    const float behind[3]{ 0.f, 0.f, -10.f };
+    const float behindOffCenter[3]{ 3.f, 0.f, -10.f };
+    const float inFront[3]{ 0.f, 0.f, -3.f };
+    const float pastTheEdge[3]{ 5.f, 0.f, -10.f };
+    const float acrossNearPlane[3]{ 0.f, 0.f, 0.f };
+    EXPECT_FALSE(buffer.IsBoxVisible(behind, half));
+    EXPECT_FALSE(buffer.IsBoxVisible(behindOffCenter, half));
+    EXPECT_TRUE(buffer.IsBoxVisible(inFront, half));
+    EXPECT_TRUE(buffer.IsBoxVisible(pastTheEdge, half));
+    EXPECT_TRUE(buffer.IsBoxVisible(acrossNearPlane, half));
+
+    // already culled boxes stay culled, the others are tested
+    float cx[3]{ 0.f, 0.f, 5.f }, cy[3]{ 0.f, 0.f, 0.f }, cz[3]{ -10.f, -10.f, -10.f };
+    float ex[3]{ 0.5f, 0.5f, 0.5f }, ey[3]{ 0.5f, 0.5f, 0.5f }, ez[3]{ 0.5f, 0.5f, 0.5f };
+    float visible[3]{ 0.f, 1.f, 1.f };
+    EXPECT_EQ(buffer.CullBoxes({ cx, cy, cz }, { ex, ey, ez }, visible, 3), 1u);
+    EXPECT_EQ(visible[0], 0.f);
+    EXPECT_EQ(visible[1], 0.f);
+    EXPECT_EQ(visible[2], 1.f);
+
+    // a new frame starts empty
+    buffer.Begin(viewProj);
+    EXPECT_TRUE(buffer.IsBoxVisible(behind, half));
+}
+
+TEST(OcclusionBufferTest, WallClippedByNearPlane) {
+    // slanted sheet running from behind the camera to far in front of it
+    Rendering::OccluderMesh wall;
+    wall.positions = { -50.f, -50.f, 10.f,   50.f, -50.f, 10.f,   50.f, 50.f, -20.f,   -50.f, 50.f, -20.f };
+    wall.indices = { 0, 1, 2,   0, 2, 3 };
+    const float identity[16]{ 1.f, 0.f, 0.f, 0.f,   0.f, 1.f, 0.f, 0.f,   0.f, 0.f, 1.f, 0.f,   0.f, 0.f, 0.f, 1.f };
+
+    float viewProj[16];
+    OcclusionTestViewProj(viewProj);
+    Rendering::OcclusionBuffer buffer(64, 64);
+    buffer.Begin(viewProj);
+    buffer.AddOccluder(wall, identity);
+    EXPECT_GE(buffer.GetNumTriangles(), 2u);
+
+    // the sheet crosses the view axis at z = -5, hiding what lies beyond it and nothing in front of it
+    const float half[3]{ 0.5f, 0.5f, 0.5f };
+    const float beyond[3]{ 0.f, 0.f, -40.f };
+    const float before[3]{ 0.f, 0.f, -2.f };
+    EXPECT_FALSE(buffer.IsBoxVisible(beyond, half));
+    EXPECT_TRUE(buffer.IsBoxVisible(before, half));
+}
+
+TEST(OcclusionBufferTest, SimplifyKeepsLargestTriangles) {
+    // xyz + 2 padding floats per vertex; triangles of area 0.5, 8 and 2
+    const float positions[]{
+        0.f, 0.f, 0.f, 9.f, 9.f,   1.f, 0.f, 0.f, 9.f, 9.f,   0.f, 1.f, 0.f, 9.f, 9.f,
+        0.f, 0.f, 1.f, 9.f, 9.f,   4.f, 0.f, 1.f, 9.f, 9.f,   0.f, 4.f, 1.f, 9.f, 9.f,
+        2.f, 0.f, 2.f, 9.f, 9.f,   0.f, 2.f, 2.f, 9.f, 9.f
+    };
+    const int indices[]{ 0, 1, 2,   3, 4, 5,   0, 6, 7 };
+
+    const Rendering::OccluderMesh occluder = Rendering::OcclusionBuffer::Simplify(positions, 5, indices, 9, 2);
+    ASSERT_EQ(occluder.GetNumTriangles(), 2u);
+    EXPECT_EQ(occluder.positions.size(), 6u * 3u);     // only the vertices still referenced
+
+    // largest first, with the positions of the source vertices
+    const float expectedFirst[9]{ 0.f, 0.f, 1.f,   4.f, 0.f, 1.f,   0.f, 4.f, 1.f };
+    const float expectedSecond[9]{ 0.f, 0.f, 0.f,   2.f, 0.f, 2.f,   0.f, 2.f, 2.f };
+    for (int v{}; v < 3; ++v) {
+        for (int e{}; e < 3; ++e) {
+            EXPECT_EQ(occluder.positions[3 * occluder.indices[v] + e], expectedFirst[3 * v + e]);
+            EXPECT_EQ(occluder.positions[3 * occluder.indices[3 + v] + e], expectedSecond[3 * v + e]);
+        }
+    }
+}
+
+TEST(RenderQueueTest, KeyFieldsRoundTrip) {
+    const uint64_t key = Rendering::RenderQueue::MakeKey(5, 3, true, 200, 1234, 7.5f);
+    EXPECT_EQ(Rendering::RenderQueue::GetPass(key), 5u);
+    EXPECT_EQ(Rendering::RenderQueue::GetProgram(key), 3u);
+    EXPECT_TRUE(Rendering::RenderQueue::GetCullFront(key));
+    EXPECT_EQ(Rendering::RenderQueue::GetTexture(key), 200u);
+    EXPECT_EQ(Rendering::RenderQueue::GetMesh(key), 1234u);
+
+    // depth only breaks ties: it never outweighs the state fields
+    EXPECT_LT(Rendering::RenderQueue::MakeKey(0, 0, false, 0, 0, 1.f), Rendering::RenderQueue::MakeKey(0, 0, false, 0, 0, 2.f));
+    EXPECT_LT(Rendering::RenderQueue::MakeKey(0, 0, false, 0, 0, 1000.f), Rendering::RenderQueue::MakeKey(0, 0, false, 0, 1, 0.f));
+    EXPECT_EQ(Rendering::RenderQueue::MakeKey(0, 0, false, 0, 0, -3.f), Rendering::RenderQueue::MakeKey(0, 0, false, 0, 0, 0.f));
+}
+
+TEST(RenderQueueTest, SortMatchesStableSort) {
+    Rendering::RenderQueue queue;
+    std::vector<Rendering::RenderQueue::Item> expected;
+
+    for (int i = 0; i < 1000; ++i) {
+        const unsigned pass = (i * 7) % 8;
+        const unsigned texture = (i * 13) % 11;
+        const float depth = static_cast<float>((i * 31) % 97) * 0.5f;
+        const uint64_t key = Rendering::RenderQueue::MakeKey(pass, i % 4, i % 4 == 1, texture, i % 3, depth);
+        queue.Push(key, i);
+        expected.push_back({ key, i });
+    }
+
+    queue.Sort();
+    std::stable_sort(expected.begin(), expected.end(),
+        [](const Rendering::RenderQueue::Item& a, const Rendering::RenderQueue::Item& b) { return a.key < b.key; });
+
+    const std::vector<Rendering::RenderQueue::Item>& items = queue.GetItems();
+    ASSERT_EQ(items.size(), expected.size());
+    for (size_t i{}; i < items.size(); ++i) {
+        EXPECT_EQ(items[i].key, expected[i].key) << "item " << i;
+        EXPECT_EQ(items[i].objIdx, expected[i].objIdx) << "item " << i;
+    }
+}
+
+TEST(DynamicResolutionTest, DropsAtOnceToFitTheBudget) {
+    Rendering::DynamicResolution resolution(10.f, 0.25f, 1.f);
+
+    // twice the budget: sqrt(0.9 * 10 / 20) = 0.67, floored to a 1/16 step
+    EXPECT_FLOAT_EQ(resolution.Update(20.f, 1.f), 0.625f);
+
+    // the frames measured before the change are ignored, the next one is not
+    for (int i = 0; i < Rendering::DynamicResolution::SETTLE_FRAMES; ++i) {
+        EXPECT_FLOAT_EQ(resolution.Update(20.f, 1.f), 0.625f);
+    }
+    EXPECT_LT(resolution.Update(20.f, 1.f), 0.625f);
+
+    // never below the minimum
+    for (int i = 0; i < 20; ++i) {
+        resolution.Update(1000.f, 1.f);
+    }
+    EXPECT_FLOAT_EQ(resolution.GetScale(), 0.25f);
+}
+
+TEST(DynamicResolutionTest, RaisesOneStepAfterFramesUnderBudget) {
+    Rendering::DynamicResolution resolution(10.f, 0.5f, 1.f);
+    resolution.Update(40.f, 1.f);
+    ASSERT_FLOAT_EQ(resolution.GetScale(), 0.5f);
+    for (int i = 0; i < Rendering::DynamicResolution::SETTLE_FRAMES; ++i) {
+        resolution.Update(1.f, 1.f);
+    }
+
+    for (int i = 1; i < Rendering::DynamicResolution::RAISE_AFTER_FRAMES; ++i) {
+        EXPECT_FLOAT_EQ(resolution.Update(1.f, 1.f), 0.5f);
+    }
+    EXPECT_FLOAT_EQ(resolution.Update(1.f, 1.f), 0.5f + Rendering::DynamicResolution::SCALE_STEP);
+
+    // a frame near the budget restarts the count
+    for (int i = 0; i < Rendering::DynamicResolution::SETTLE_FRAMES; ++i) {
+        resolution.Update(1.f, 1.f);
+    }
+    for (int i = 1; i < Rendering::DynamicResolution::RAISE_AFTER_FRAMES; ++i) {
+        resolution.Update(1.f, 1.f);
+    }
+    resolution.Update(9.f, 1.f);
+    EXPECT_FLOAT_EQ(resolution.Update(1.f, 1.f), 0.5f + Rendering::DynamicResolution::SCALE_STEP);
+}
+
+TEST(DynamicResolutionTest, HoldsWhileCpuBound) {
+    Rendering::DynamicResolution resolution(10.f, 0.5f, 1.f);
+    resolution.Update(40.f, 1.f);
+    for (int i = 0; i < 10 * Rendering::DynamicResolution::RAISE_AFTER_FRAMES; ++i) {
+        resolution.Update(1.f, 25.f);
+    }
+    EXPECT_FLOAT_EQ(resolution.GetScale(), 0.5f);
+
+    EXPECT_EQ(Rendering::DynamicResolution::ScaleSize(1080, 0.5f), 540);
+    EXPECT_EQ(Rendering::DynamicResolution::ScaleSize(3, 0.1f), 1);
+}
+
+TEST(ProfileLogTest, IndexesPassesByName) {
+    Rendering::ProfileLog log;
+    EXPECT_EQ(log.GetPassIndex("Geometry"), 0);
+    EXPECT_EQ(log.GetPassIndex("Light Pass"), 1);
+    EXPECT_EQ(log.GetPassIndex("Geometry"), 0);
+    EXPECT_EQ(log.GetNumPasses(), 2);
+    EXPECT_EQ(log.GetPassName(1), "Light Pass");
+}
+
+TEST(ProfileLogTest, CountsSkippedPassesAsZero) {
+    Rendering::ProfileLog log;
+    const int geometry = log.GetPassIndex("Geometry");
+    const int mirror = log.GetPassIndex("Mirror");
+    log.AddFrame(0, { 2.f, 1.f });
+    log.AddFrame(1, { 4.f, Rendering::ProfileLog::NOT_RUN });
+    log.AddFrame(2, { 3.f });   // recorded before the mirror pass was known
+
+    EXPECT_FLOAT_EQ(log.GetAverageMs(geometry), 3.f);
+    EXPECT_FLOAT_EQ(log.GetAverageMs(mirror), 1.f / 3.f);
+    EXPECT_FLOAT_EQ(log.GetMaxMs(Rendering::ProfileLog::TOTAL), 4.f);
+    EXPECT_FLOAT_EQ(log.GetAverageMs(Rendering::ProfileLog::TOTAL, 2), 3.5f);
+    EXPECT_FLOAT_EQ(log.GetFrame(0).GetMs(Rendering::ProfileLog::TOTAL), 3.f);
+}
+
+TEST(ProfileLogTest, WritesOneCsvRowPerFrame) {
+    Rendering::ProfileLog log;
+    log.GetPassIndex("Geometry");
+    log.GetPassIndex("Mirror");
+    log.AddFrame(7, { 2.5f, Rendering::ProfileLog::NOT_RUN });
+    log.AddFrame(8, { 2.f, 0.5f });
+
+    std::ostringstream csv;
+    log.WriteCsv(csv);
+    EXPECT_EQ(csv.str(), "frame,Geometry,Mirror,total\n7,2.5,,2.5\n8,2,0.5,2.5\n");
+}
@@ -2,28 +2,28 @@
 void Core::Transform::Update()
 {
     // First column
-    m_localToWorld.columns[0].m128_f32[0] = 1.0f - 2.0f * (m_orientation.y * m_orientation.y + m_orientation.z * m_orientation.z);
-    m_localToWorld.columns[0].m128_f32[1] = 2.0f * (m_orientation.x * m_orientation.y + m_orientation.w * m_orientation.z);
-    m_localToWorld.columns[0].m128_f32[2] = 2.0f * (m_orientation.x * m_orientation.z - m_orientation.w * m_orientation.y);
-    m_localToWorld.columns[0].m128_f32[3] = 0.0f; // Assuming homogeneous coordinate for direction vectors is 0
+    m_localToWorld[0] = 1.0f - 2.0f * (m_orientation.y * m_orientation.y + m_orientation.z * m_orientation.z);
+    m_localToWorld[1] = 2.0f * (m_orientation.x * m_orientation.y + m_orientation.w * m_orientation.z);
+    m_localToWorld[2] = 2.0f * (m_orientation.x * m_orientation.z - m_orientation.w * m_orientation.y);
+    m_localToWorld[3] = 0.0f; // Assuming homogeneous coordinate for direction vectors is 0
 
     // Second column
-    m_localToWorld.columns[1].m128_f32[0] = 2.0f * (m_orientation.x * m_orientation.y - m_orientation.w * m_orientation.z);
-    m_localToWorld.columns[1].m128_f32[1] = 1.0f - 2.0f * (m_orientation.x * m_orientation.x + m_orientation.z * m_orientation.z);
-    m_localToWorld.columns[1].m128_f32[2] = 2.0f * (m_orientation.y * m_orientation.z + m_orientation.w * m_orientation.x);
-    m_localToWorld.columns[1].m128_f32[3] = 0.0f;
+    m_localToWorld[4] = 2.0f * (m_orientation.x * m_orientation.y - m_orientation.w * m_orientation.z);
+    m_localToWorld[5] = 1.0f - 2.0f * (m_orientation.x * m_orientation.x + m_orientation.z * m_orientation.z);
+    m_localToWorld[6] = 2.0f * (m_orientation.y * m_orientation.z + m_orientation.w * m_orientation.x);
+    m_localToWorld[7] = 0.0f;
 
     // Third column
-    m_localToWorld.columns[2].m128_f32[0] = 2.0f * (m_orientation.x * m_orientation.z + m_orientation.w * m_orientation.y);
-    m_localToWorld.columns[2].m128_f32[1] = 2.0f * (m_orientation.y * m_orientation.z - m_orientation.w * m_orientation.x);
-    m_localToWorld.columns[2].m128_f32[2] = 1.0f - 2.0f * (m_orientation.x * m_orientation.x + m_orientation.y * m_orientation.y);
-    m_localToWorld.columns[2].m128_f32[3] = 0.0f; 
+    m_localToWorld[8] = 2.0f * (m_orientation.x * m_orientation.z + m_orientation.w * m_orientation.y);
+    m_localToWorld[9] = 2.0f * (m_orientation.y * m_orientation.z - m_orientation.w * m_orientation.x);
+    m_localToWorld[10] = 1.0f - 2.0f * (m_orientation.x * m_orientation.x + m_orientation.y * m_orientation.y);
+    m_localToWorld[11] = 0.0f; 
 
     // Fourth column (position)
-    m_localToWorld.columns[3].m128_f32[0] = m_position[0];
-    m_localToWorld.columns[3].m128_f32[1] = m_position[1];
-    m_localToWorld.columns[3].m128_f32[2] = m_position[2];
-    m_localToWorld.columns[3].m128_f32[3] = 1.0f; // Homogeneous coordinate for position is 1
+    m_localToWorld[12] = m_position[0];
+    m_localToWorld[13] = m_position[1];
+    m_localToWorld[14] = m_position[2];
+    m_localToWorld[15] = 1.0f; // Homogeneous coordinate for position is 1
 }
 
 Math::Vector3 Core::Transform::GetAxis(int index) const
@@ -33,9 +33,9 @@ Math::Vector3 Core::Transform::GetAxis(int index) const
     }
 
     Vector3 result(
-        m_localToWorld.columns[index].m128_f32[0],
-        m_localToWorld.columns[index].m128_f32[1],
-        m_localToWorld.columns[index].m128_f32[2]
+        m_localToWorld[index * 4],
+        m_localToWorld[index * 4 + 1],
+        m_localToWorld[index * 4 + 2]
     );
     result.Normalize();
 
@@ -0,0 +1,72 @@
+#include"gtest/gtest.h"
+#include <rendering/MeshLibrary.h>
+#include <core/Scene.h>
+#include <cmath>
+
+// Scenes of the physics library, built against the engine's own headers. The math tests (Test.cpp) use the
+// copies next to them instead, so the two cannot share an executable.
+
+using Math::Vector3;
+
+TEST(PhysicsSceneTest, StepsWithoutMeshesNorRenderer) {
+    const Rendering::MeshLibrary meshLibrary;   // nothing loaded: the objects get no mesh
+    Core::Scene scene(meshLibrary);
+    ASSERT_GT(scene.GetNumObjects(), 0u);
+    EXPECT_EQ(scene.GetObject(0).GetMesh(), nullptr);
+
+    for (int step = 0; step < 120; ++step) {
+        scene.Update(1 / 120.f);
+    }
+    ASSERT_GT(scene.GetNumObjects(), 0u);
+    for (size_t i = 0; i < scene.GetNumObjects(); ++i) {
+        const auto pos = scene.GetObject(i).GetPosition();
+        EXPECT_TRUE(std::isfinite(pos.x) && std::isfinite(pos.y) && std::isfinite(pos.z));
+    }
+}
+
+TEST(PhysicsSceneTest, ModelMatrixWithoutMesh) {
+    const Rendering::MeshLibrary meshLibrary;
+    Core::Scene scene(meshLibrary);
+    scene.Clear();
+    const Core::Object* box = scene.CreateObject("box", Rendering::MeshID::CUBE, Rendering::ImageID::WOOD_TEX_1,
+        Physics::ColliderType::OBB, Vec3{ 2.f, 4.f, 6.f }, Vector3{ 1.f, 2.f, 3.f }, 0.f);
+    const Core::Object* sphere = scene.CreateObject("sphere", Rendering::MeshID::SPHERE, Rendering::ImageID::POTTERY_TEX_1,
+        Physics::ColliderType::SPHERE, 3.f, Vector3{ -1.f, 5.f, 0.f }, 1.f);
+    ASSERT_EQ(box->GetMesh(), nullptr);
+    ASSERT_EQ(sphere->GetMesh(), nullptr);
+
+    // no mesh: the collider scale and the transform only
+    const Mat4 boxModel = box->GetModelMatrix();
+    const Mat4 sphereModel = sphere->GetModelMatrix();
+    for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            const float boxScale[3]{ 2.f, 4.f, 6.f };
+            const float boxExpected = col == 3 ? Vec4{ 1.f, 2.f, 3.f, 1.f }[row] : (row == col ? boxScale[col] : 0.f);
+            const float sphereExpected = col == 3 ? Vec4{ -1.f, 5.f, 0.f, 1.f }[row] : (row == col ? 3.f : 0.f);
+            EXPECT_NEAR(boxModel[col][row], boxExpected, EPSILON) << col << ", " << row;
+            EXPECT_NEAR(sphereModel[col][row], sphereExpected, EPSILON) << col << ", " << row;
+        }
+    }
+}
+
+TEST(PhysicsSceneTest, ProjectilePoolSize) {
+    const Rendering::MeshLibrary meshLibrary;
+    Core::Scene scene(meshLibrary, Vec3{ 0.f }, 8);
+    const Core::Scene largerScene(meshLibrary, Vec3{ 0.f }, 20);
+    EXPECT_EQ(largerScene.GetNumObjects() - scene.GetNumObjects(), 12u);
+
+    auto CountVisible = [&scene] {
+        size_t numVisible = 0;
+        for (size_t i = 0; i < scene.GetNumObjects(); ++i) {
+            numVisible += scene.GetObject(i).IsVisible();
+        }
+        return numVisible;
+    };
+
+    // as many shots as projectiles: all of them in flight, none reloaded
+    const size_t numVisible = CountVisible();
+    for (int shot = 0; shot < 8; ++shot) {
+        scene.ShootProjectile(Vec3{ 0.f, 5.f, 20.f }, Vec3{ 0.f, 0.f, -1.f }, Vec3{ 0.f, 1.f, 0.f });
+    }
+    EXPECT_EQ(CountVisible(), numVisible + 8);
+}